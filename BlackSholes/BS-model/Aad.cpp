@@ -0,0 +1,80 @@
+// Group A & B: Source file for the reverse mode (adjoint) automatic differentiation type AReal and its tape
+
+#include "Aad.h"
+
+namespace Options
+{
+	// Tape of a thread until it chooses one; it reserves nothing up front, as most threads never record
+	static thread_local Tape DefaultTape(0);
+	thread_local Tape* ActiveTape = &DefaultTape;
+
+	// Function to choose the tape of the calling thread, 0 for its default tape
+	void SetActiveTape(Tape* tape)
+	{
+		ActiveTape = (tape == 0) ? &DefaultTape : tape;
+	}
+
+	// Constructor reserving room for capacity nodes. Node 0 is a constant that unused operands point to
+	Tape::Tape(size_t capacity)
+	{
+		nodes.reserve(capacity);
+		adjoints.reserve(capacity);
+		Record(0, 0.0, 0, 0.0);
+	}
+
+	// Function to drop every node recorded at or after mark, keeping the memory
+	void Tape::Rewind(size_t mark)
+	{
+		if (mark < 1)
+		{
+			mark = 1;
+		}
+		if (mark < nodes.size())
+		{
+			nodes.resize(mark);
+			adjoints.resize(mark);
+		}
+	}
+
+	// Function to drop every node, keeping the memory
+	void Tape::Clear()
+	{
+		Rewind(1);
+		adjoints[0] = 0.0;
+	}
+
+	// Function to set every adjoint to zero
+	void Tape::ResetAdjoints()
+	{
+		for (size_t i = 0; i < adjoints.size(); ++i)
+		{
+			adjoints[i] = 0.0;
+		}
+	}
+
+	// Function to sweep the adjoints from the last node back to mark. Nodes before mark receive their contributions but are
+	// not swept themselves, so inputs recorded before a checkpoint accumulate the adjoints of everything recorded after it
+	void Tape::Propagate(size_t mark)
+	{
+		if (mark < 1)
+		{
+			mark = 1;
+		}
+		for (size_t i = nodes.size(); i-- > mark;)
+		{
+			double a = adjoints[i];
+			if (a == 0.0)
+			{
+				continue;
+			}
+			const Node& node = nodes[i];
+			adjoints[node.parent[0]] += node.partial[0] * a;
+			adjoints[node.parent[1]] += node.partial[1] * a;
+		}
+	}
+
+	AReal& AReal::operator += (const AReal& y) { *this = *this + y; return *this; }
+	AReal& AReal::operator -= (const AReal& y) { *this = *this - y; return *this; }
+	AReal& AReal::operator *= (const AReal& y) { *this = *this * y; return *this; }
+	AReal& AReal::operator /= (const AReal& y) { *this = *this / y; return *this; }
+}
@@ -0,0 +1,107 @@
+// Group A & B: Header file for the reverse mode (adjoint) automatic differentiation type AReal and its tape
+//
+// Every arithmetic operation on AReal appends one node to the active tape of the calling thread: the indices of its (at
+// most two) operands and the partial derivatives with respect to them. A thread that never chose a tape records on a
+// default tape of its own, so an AReal can be built on any thread. A reverse sweep over the tape then gives the
+// derivative of one output with respect to every input recorded before it, at a small constant multiple of the cost of
+// the valuation itself.
+//
+// The tape is an arena: nodes are addressed by index, nothing is freed until Clear() and the memory is reused afterwards.
+// Mark() and Rewind() allow checkpointing, e.g. record shared inputs once, then for each instrument record its valuation,
+// sweep back to the mark and rewind; adjoints of the shared inputs accumulate while the tape stays the size of one instrument.
+
+#ifndef AadHPP
+#define AadHPP
+
+#include "NormalCdf.h"
+#include <vector>
+#include <cstddef>
+using namespace std;
+
+namespace Options
+{
+	class Tape
+	{
+		private:
+			struct Node
+			{
+				size_t parent[2]; // operands, 0 with a zero partial when unused
+				double partial[2]; // derivative of the node with respect to each operand
+			};
+
+			vector<Node> nodes;
+			vector<double> adjoints;
+
+		public:
+			Tape(size_t capacity = 1 << 16); // constructor reserving room for capacity nodes
+
+			size_t Record(size_t p0, double d0, size_t p1, double d1) // function to append a node and return its index
+			{
+				Node node = { { p0, p1 }, { d0, d1 } };
+				nodes.push_back(node);
+				adjoints.push_back(0.0);
+				return nodes.size() - 1;
+			}
+
+			size_t Size() const { return nodes.size(); } // function to return the number of recorded nodes
+			size_t Mark() const { return nodes.size(); } // function to return a checkpoint, the index of the next node
+			void Rewind(size_t mark); // function to drop every node recorded at or after mark, keeping the memory
+			void Clear(); // function to drop every node, keeping the memory
+
+			double& Adjoint(size_t index) { return adjoints[index]; } // function to access the adjoint of a node
+			void ResetAdjoints(); // function to set every adjoint to zero
+			void Propagate(size_t mark = 0); // function to sweep the adjoints from the last node back to mark
+	};
+
+	extern thread_local Tape* ActiveTape; // tape that AReal operations of the calling thread record on, never null
+	void SetActiveTape(Tape* tape); // function to choose the tape of the calling thread, 0 for its default tape
+
+	class AReal
+	{
+		private:
+			double val; // value
+			size_t idx; // node on the active tape
+
+		public:
+			AReal() : val(0.0), idx(ActiveTape->Record(0, 0.0, 0, 0.0)) {} // default constructor recording an input of zero
+			AReal(double v) : val(v), idx(ActiveTape->Record(0, 0.0, 0, 0.0)) {} // constructor recording an input
+			AReal(double v, size_t i) : val(v), idx(i) {} // constructor for a value already on the tape
+
+			double Value() const { return val; } // function to return the value
+			size_t Index() const { return idx; } // function to return the node on the tape
+			double& Adjoint() const { return ActiveTape->Adjoint(idx); } // function to access the adjoint after a sweep
+			void Seed(double w) const { ActiveTape->Adjoint(idx) += w; } // function to seed the adjoint of an output before a sweep
+
+			AReal& operator += (const AReal& y);
+			AReal& operator -= (const AReal& y);
+			AReal& operator *= (const AReal& y);
+			AReal& operator /= (const AReal& y);
+	};
+
+	// Operations, each recording one node with its local partial derivatives. Mixed forms with a double record nothing for it.
+	inline AReal operator + (const AReal& x, const AReal& y) { return AReal(x.Value() + y.Value(), ActiveTape->Record(x.Index(), 1.0, y.Index(), 1.0)); }
+	inline AReal operator + (const AReal& x, double y) { return AReal(x.Value() + y, ActiveTape->Record(x.Index(), 1.0, 0, 0.0)); }
+	inline AReal operator + (double x, const AReal& y) { return y + x; }
+	inline AReal operator - (const AReal& x, const AReal& y) { return AReal(x.Value() - y.Value(), ActiveTape->Record(x.Index(), 1.0, y.Index(), -1.0)); }
+	inline AReal operator - (const AReal& x, double y) { return AReal(x.Value() - y, ActiveTape->Record(x.Index(), 1.0, 0, 0.0)); }
+	inline AReal operator - (double x, const AReal& y) { return AReal(x - y.Value(), ActiveTape->Record(y.Index(), -1.0, 0, 0.0)); }
+	inline AReal operator - (const AReal& x) { return AReal(-x.Value(), ActiveTape->Record(x.Index(), -1.0, 0, 0.0)); }
+	inline AReal operator * (const AReal& x, const AReal& y) { return AReal(x.Value() * y.Value(), ActiveTape->Record(x.Index(), y.Value(), y.Index(), x.Value())); }
+	inline AReal operator * (const AReal& x, double y) { return AReal(x.Value() * y, ActiveTape->Record(x.Index(), y, 0, 0.0)); }
+	inline AReal operator * (double x, const AReal& y) { return y * x; }
+	inline AReal operator / (const AReal& x, const AReal& y)
+	{
+		double inv = 1.0 / y.Value();
+		return AReal(x.Value() * inv, ActiveTape->Record(x.Index(), inv, y.Index(), -x.Value() * inv * inv));
+	}
+	inline AReal operator / (const AReal& x, double y) { return x * (1.0 / y); }
+	inline AReal operator / (double x, const AReal& y) { return AReal(x / y.Value(), ActiveTape->Record(y.Index(), -x / (y.Value() * y.Value()), 0, 0.0)); }
+
+	inline AReal exp(const AReal& x) { double e = std::exp(x.Value()); return AReal(e, ActiveTape->Record(x.Index(), e, 0, 0.0)); }
+	inline AReal log(const AReal& x) { return AReal(std::log(x.Value()), ActiveTape->Record(x.Index(), 1.0 / x.Value(), 0, 0.0)); }
+	inline AReal sqrt(const AReal& x) { double s = std::sqrt(x.Value()); return AReal(s, ActiveTape->Record(x.Index(), 0.5 / s, 0, 0.0)); }
+	inline AReal NormalCdfExact(const AReal& x) { return AReal(NormalCdfExact(x.Value()), ActiveTape->Record(x.Index(), NormalPdf(x.Value()), 0, 0.0)); }
+	inline AReal NormalPdf(const AReal& x) { double p = NormalPdf(x.Value()); return AReal(p, ActiveTape->Record(x.Index(), -x.Value() * p, 0, 0.0)); }
+}
+
+#endif
@@ -0,0 +1,224 @@
+// Group A & B: Source file for batch (structure-of-arrays) pricing of finite maturity American options
+
+#include "AmericanBatch.h"
+#include "EuroBatch.h"
+#include <cmath>
+#include <algorithm>
+using namespace std;
+
+namespace Options
+{
+	const size_t AmBlock = 64; // contracts per block, so the scratch arrays below stay in L1 cache
+	const double AmTol = 1e-10; // critical price tolerance, relative to the strike
+	const int AmMaxIter = 32; // cap on the Newton iterations of each block
+	const int BsTerms = 5; // phi terms of the Bjerksund-Stensland call
+
+	// Function to price a block of m contracts with the Barone-Adesi-Whaley approximation. Notation follows Haug (2007):
+	// C = c + A2 * (S / S*)^q2 below the critical price S*, S - K above it, and likewise for the put with q1 and S**
+	static void BaroneAdesiWhaleyBlock(const double* T, const double* sig, const double* r, const double* q, const double* S, const double* K, double* call, double* put, size_t m, CdfTier tier)
+	{
+		double eurCall[AmBlock], eurPut[AmBlock], v[AmBlock], drift[AmBlock], carry[AmBlock], disc[AmBlock], q1[AmBlock], q2[AmBlock];
+		double sc[AmBlock], sp[AmBlock], callInf[AmBlock], putInf[AmBlock], dc1[AmBlock], dc2[AmBlock], dp1[AmBlock], dp2[AmBlock];
+		double Nc1[AmBlock], Nc2[AmBlock], Np1[AmBlock], Np2[AmBlock], Nmp1[AmBlock], Nmp2[AmBlock], nc1[AmBlock], np1[AmBlock];
+		int liveCall[AmBlock], livePut[AmBlock]; // 1 while the critical price is still iterating
+
+		EuroBatchPrice(T, sig, r, q, S, K, eurCall, eurPut, m, tier);
+
+		// Stage 1: the exponents q1 and q2 and the seeds of the critical prices
+		BATCH_LOOP
+		for (size_t i = 0; i < m; ++i)
+		{
+			double b = r[i] - q[i];
+			double sig2 = sig[i] * sig[i];
+			v[i] = sig[i] * sqrt(T[i]);
+			drift[i] = (b + 0.5 * sig2) * T[i];
+			carry[i] = exp(-q[i] * T[i]); // exp((b - r) * T)
+			disc[i] = exp(-r[i] * T[i]);
+
+			// 4M / (1 - exp(-rT)) with M = 2r / sig^2, written so that r = 0 takes its limit 8 / (sig^2 * T)
+			double rT = r[i] * T[i];
+			double rOverK = (fabs(rT) > 1e-12) ? r[i] / (-expm1(-rT)) : 1.0 / T[i];
+			double n1 = 2 * b / sig2 - 1;
+			double root = sqrt(n1 * n1 + 8 * rOverK / sig2);
+			q2[i] = 0.5 * (-n1 + root);
+			q1[i] = 0.5 * (-n1 - root);
+
+			// Seeds from the perpetual critical prices (the T -> infinity limits of q1 and q2), which bound S* from above and
+			// S** from below. h1 and h2 are capped at 0 so that a long maturity with a large carry keeps the seed in the bracket
+			double rootInf = sqrt(n1 * n1 + 8 * r[i] / sig2);
+			callInf[i] = K[i] / (1 - 2 / (-n1 + rootInf));
+			putInf[i] = K[i] / (1 - 2 / (-n1 - rootInf));
+			double h2 = -(b * T[i] + 2 * v[i]) * K[i] / (callInf[i] - K[i]);
+			double h1 = (b * T[i] - 2 * v[i]) * K[i] / (K[i] - putInf[i]);
+
+			liveCall[i] = (q[i] > 0.0) ? 1 : 0;
+			livePut[i] = (r[i] > 0.0) ? 1 : 0;
+			sc[i] = liveCall[i] ? K[i] + (callInf[i] - K[i]) * (1 - exp(min(h2, 0.0))) : K[i];
+			sp[i] = livePut[i] ? putInf[i] + (K[i] - putInf[i]) * exp(min(h1, 0.0)) : K[i];
+		}
+
+		// Stage 2: Newton iterations for S* and S** in lockstep over the block, stopping once every contract has converged.
+		// Each step is clamped to the bracket [K, S*(infinity)] or [S**(infinity), K], which always holds the root
+		for (int it = 0; it < AmMaxIter; ++it)
+		{
+			BATCH_LOOP
+			for (size_t i = 0; i < m; ++i)
+			{
+				dc1[i] = (log(sc[i] / K[i]) + drift[i]) / v[i];
+				dc2[i] = dc1[i] - v[i];
+				dp1[i] = (log(sp[i] / K[i]) + drift[i]) / v[i];
+				dp2[i] = dp1[i] - v[i];
+			}
+
+			NormalCdfBatch(dc1, Nc1, m, tier);
+			NormalCdfBatch(dc2, Nc2, m, tier);
+			NormalCdfBatch(dp1, Np1, Nmp1, m, tier); // the put side needs N(-d), taken directly rather than as 1 - N(d)
+			NormalCdfBatch(dp2, Np2, Nmp2, m, tier);
+			NormalPdfBatch(dc1, nc1, m);
+			NormalPdfBatch(dp1, np1, m);
+
+			int active = 0;
+			BATCH_LOOP
+			for (size_t i = 0; i < m; ++i)
+			{
+				// Call: S* - K = c(S*) + (1 - exp((b - r)T) N(d1)) S* / q2
+				double cS = sc[i] * carry[i] * Nc1[i] - K[i] * disc[i] * Nc2[i];
+				double rhsC = cS + (1 - carry[i] * Nc1[i]) * sc[i] / q2[i];
+				double bC = carry[i] * Nc1[i] * (1 - 1 / q2[i]) + (1 - carry[i] * nc1[i] / v[i]) / q2[i];
+				int doneC = (fabs(sc[i] - K[i] - rhsC) < AmTol * K[i]) ? 1 : 0;
+				sc[i] = liveCall[i] ? min(max((K[i] + rhsC - bC * sc[i]) / (1 - bC), K[i]), callInf[i]) : sc[i];
+				liveCall[i] = liveCall[i] && !doneC;
+
+				// Put: K - S** = p(S**) - (1 - exp((b - r)T) N(-d1)) S** / q1
+				double pS = K[i] * disc[i] * Nmp2[i] - sp[i] * carry[i] * Nmp1[i];
+				double rhsP = pS - (1 - carry[i] * Nmp1[i]) * sp[i] / q1[i];
+				double bP = -carry[i] * Nmp1[i] * (1 - 1 / q1[i]) - (1 + carry[i] * np1[i] / v[i]) / q1[i];
+				int doneP = (fabs(K[i] - sp[i] - rhsP) < AmTol * K[i]) ? 1 : 0;
+				sp[i] = livePut[i] ? min(max((K[i] - rhsP + bP * sp[i]) / (1 + bP), putInf[i]), K[i]) : sp[i];
+				livePut[i] = livePut[i] && !doneP;
+
+				active += liveCall[i] + livePut[i];
+			}
+
+			if (active == 0)
+			{
+				break;
+			}
+		}
+
+		// Stage 3: the early exercise premia at the final critical prices
+		BATCH_LOOP
+		for (size_t i = 0; i < m; ++i)
+		{
+			dc1[i] = (log(sc[i] / K[i]) + drift[i]) / v[i];
+			dp1[i] = (log(sp[i] / K[i]) + drift[i]) / v[i];
+		}
+
+		NormalCdfBatch(dc1, Nc1, m, tier);
+		NormalCdfBatch(dp1, Np1, Nmp1, m, tier);
+
+		BATCH_LOOP
+		for (size_t i = 0; i < m; ++i)
+		{
+			double A2 = (sc[i] / q2[i]) * (1 - carry[i] * Nc1[i]);
+			double A1 = -(sp[i] / q1[i]) * (1 - carry[i] * Nmp1[i]);
+			double amCall = (S[i] < sc[i]) ? eurCall[i] + A2 * exp(q2[i] * log(S[i] / sc[i])) : S[i] - K[i];
+			double amPut = (S[i] > sp[i]) ? eurPut[i] + A1 * exp(q1[i] * log(S[i] / sp[i])) : K[i] - S[i];
+			call[i] = (q[i] > 0.0) ? amCall : eurCall[i];
+			put[i] = (r[i] > 0.0) ? amPut : eurPut[i];
+		}
+	}
+
+	// Function to price a block of m calls with the Bjerksund-Stensland (1993) approximation for a rate and cost of carry b.
+	// With the flat boundary I the price is a sum of phi(S, T, gamma, H, I) terms, each a pair of normal cdfs, so no iteration
+	// is needed. The put follows from the transformation P(S, K, r, b) = C(K, S, r - b, -b)
+	static void BjerksundStenslandCallBlock(const double* T, const double* sig, const double* r, const double* b, const double* S, const double* K, double* call, size_t m, CdfTier tier)
+	{
+		double x[(2 * BsTerms + 2) * AmBlock] = {}; // cdf arguments, term k in rows 2k and 2k + 1, d1 and d2 last; zeroed as the compiler cannot see that stage 1 fills every row read
+		double Nx[(2 * BsTerms + 2) * AmBlock];
+		double scale[BsTerms][AmBlock], power[BsTerms][AmBlock], alpha[AmBlock], beta[AmBlock], trigger[AmBlock];
+
+		// Stage 1: the boundary I, the exponent beta and the arguments of every phi term
+		BATCH_LOOP
+		for (size_t i = 0; i < m; ++i)
+		{
+			double sig2 = sig[i] * sig[i];
+			double v = sig[i] * sqrt(T[i]);
+			double logS = log(S[i]);
+
+			double u = b[i] / sig2 - 0.5;
+			beta[i] = -u + sqrt(u * u + 2 * r[i] / sig2);
+			double bInf = beta[i] / (beta[i] - 1) * K[i];
+			double b0 = max(K[i], r[i] / (r[i] - b[i]) * K[i]);
+			double h = -(b[i] * T[i] + 2 * v) * b0 / (bInf - b0);
+			trigger[i] = b0 + (bInf - b0) * (1 - exp(min(h, 0.0))); // h > 0 only for b * T < -2 * sig * sqrt(T), the boundary is kept in [B0, Binf]
+			alpha[i] = (trigger[i] - K[i]) * exp(-beta[i] * log(trigger[i]));
+
+			// phi terms (gamma, H): (beta, I), (1, I), (1, K), (0, I), (0, K)
+			double gammas[BsTerms] = { beta[i], 1.0, 1.0, 0.0, 0.0 };
+			double logH[BsTerms] = { log(trigger[i]), log(trigger[i]), log(K[i]), log(trigger[i]), log(K[i]) };
+			double logIS = log(trigger[i]) - logS;
+			for (int k = 0; k < BsTerms; ++k)
+			{
+				double g = gammas[k];
+				double lambda = (-r[i] + g * b[i] + 0.5 * g * (g - 1) * sig2) * T[i];
+				double kappa = 2 * b[i] / sig2 + (2 * g - 1);
+				double d = -(logS - logH[k] + (b[i] + (g - 0.5) * sig2) * T[i]) / v;
+				x[(2 * k) * m + i] = d;
+				x[(2 * k + 1) * m + i] = d - 2 * logIS / v;
+				scale[k][i] = exp(lambda + g * logS);
+				power[k][i] = exp(kappa * logIS);
+			}
+
+			double d1 = (logS - log(K[i]) + (b[i] + 0.5 * sig2) * T[i]) / v;
+			x[(2 * BsTerms) * m + i] = d1;
+			x[(2 * BsTerms + 1) * m + i] = d1 - v;
+		}
+
+		// Stage 2: every normal cdf of the block in one pass
+		NormalCdfBatch(x, Nx, (2 * BsTerms + 2) * m, tier);
+
+		// Stage 3: the prices, European when early exercise is never optimal (b >= r) and intrinsic beyond the boundary
+		BATCH_LOOP
+		for (size_t i = 0; i < m; ++i)
+		{
+			double phi[BsTerms];
+			for (int k = 0; k < BsTerms; ++k)
+			{
+				phi[k] = scale[k][i] * (Nx[(2 * k) * m + i] - power[k][i] * Nx[(2 * k + 1) * m + i]);
+			}
+			double amCall = alpha[i] * exp(beta[i] * log(S[i])) - alpha[i] * phi[0] + phi[1] - phi[2] - K[i] * phi[3] + K[i] * phi[4];
+			double eurCall = S[i] * exp((b[i] - r[i]) * T[i]) * Nx[(2 * BsTerms) * m + i] - K[i] * exp(-r[i] * T[i]) * Nx[(2 * BsTerms + 1) * m + i];
+			call[i] = (b[i] >= r[i]) ? eurCall : ((S[i] >= trigger[i]) ? S[i] - K[i] : amCall);
+		}
+	}
+
+	// Function to price n American call and put options with a finite maturity
+	void AmericanBatchPrice(const double* T, const double* sig, const double* r, const double* q, const double* S, const double* K, double* call, double* put, size_t n, AmericanApprox approx, CdfTier tier)
+	{
+		double b[AmBlock], putRate[AmBlock], putCarry[AmBlock];
+
+		for (size_t start = 0; start < n; start += AmBlock)
+		{
+			size_t m = min(AmBlock, n - start);
+
+			if (approx == AmBaroneAdesiWhaley)
+			{
+				BaroneAdesiWhaleyBlock(T + start, sig + start, r + start, q + start, S + start, K + start, call + start, put + start, m, tier);
+				continue;
+			}
+
+			BATCH_LOOP
+			for (size_t i = 0; i < m; ++i)
+			{
+				size_t j = start + i;
+				b[i] = r[j] - q[j];
+				putRate[i] = q[j]; // r - b
+				putCarry[i] = -b[i];
+			}
+
+			BjerksundStenslandCallBlock(T + start, sig + start, r + start, b, S + start, K + start, call + start, m, tier);
+			BjerksundStenslandCallBlock(T + start, sig + start, putRate, putCarry, K + start, S + start, put + start, m, tier);
+		}
+	}
+}
@@ -0,0 +1,28 @@
+// Group A & B: Header file for batch (structure-of-arrays) pricing of finite maturity American options
+//
+// AmericanOption prices the perpetual option only. The functions here approximate the American call and put with a maturity,
+// in the same structure-of-arrays layout as EuroBatchPrice, so a whole book is priced in one call.
+
+#ifndef AmericanBatchHPP
+#define AmericanBatchHPP
+
+#include "NormalCdf.h"
+#include <cstddef>
+
+namespace Options
+{
+	enum AmericanApprox
+	{
+		AmBaroneAdesiWhaley, // quadratic approximation of Barone-Adesi and Whaley (1987), critical prices found by Newton iteration
+		AmBjerksundStensland // flat exercise boundary of Bjerksund and Stensland (1993), closed form without iteration
+	};
+
+	// Element i of every input array describes contract i, in the same order as the EuroOption constructor (T, sigma, r, q, S, K),
+	// the cost of carry is b = r - q. call[i] and put[i] are written into caller owned arrays of length n; nothing is allocated.
+	// A call with q <= 0 and a put with r <= 0 are never exercised early and get the European price.
+	// Contracts are processed in blocks; the Barone-Adesi-Whaley critical prices of a block are iterated in lockstep,
+	// so the solve vectorises like the rest of the kernel.
+	void AmericanBatchPrice(const double* T, const double* sig, const double* r, const double* q, const double* S, const double* K, double* call, double* put, size_t n, AmericanApprox approx = AmBaroneAdesiWhaley, CdfTier tier = CdfExact); // function to price n American call and put options with a finite maturity
+}
+
+#endif
@@ -1,10 +1,13 @@
 // Group A & B: Source file for Option Pricing and Sensitivity Measurement of Plain (European) options
 
 #include "AmericanOption.h"
+#include "Ladder.h"
+#include "NormalCdf.h"
 #include <iostream>
 #include <cmath>
 #include <boost/math/distributions/normal.hpp>
 #include <vector>
+#include <algorithm>
 using namespace std;
 using namespace boost::math;
 
@@ -36,27 +39,25 @@ namespace Options
 
 	double AmericanOption::AmCallPrice() const // function to calculate price of American Call Option
 	{
-		double C = (K / (y1() - 1)) * pow(((S / K) * ((y1() - 1) / y1())), y1());
-		return C;
+		return AmCallPrice(S);
 	}
 
 	double AmericanOption::AmPutPrice() const// function to calculate price of American Put Option
 	{
-		double P = (K / (1 - y2())) * pow(((S / K) * ((y2() - 1) / y2())), y2());
-		return P;
+		return AmPutPrice(S);
 	}
 
-	double AmericanOption::AmCallPrice(double underlying) // function to calculate price of American Call Option, with dependancy on change of underlying price
+	double AmericanOption::AmCallPrice(double underlying) const // function to calculate price of American Call Option, with dependancy on change of underlying price (the option itself is not changed)
 	{
-		S = underlying;
-		double C = (K / (y1() - 1)) * pow(((S / K) * ((y1() - 1) / y1())), y1());
+		double Y1 = y1();
+		double C = (K / (Y1 - 1)) * exp(Y1 * log((underlying / K) * ((Y1 - 1) / Y1)));
 		return C;
 	}
 
-	double AmericanOption::AmPutPrice(double underlying) // function to calculate price of American Put Option, with dependancy on change of underlying price
+	double AmericanOption::AmPutPrice(double underlying) const // function to calculate price of American Put Option, with dependancy on change of underlying price (the option itself is not changed)
 	{
-		S = underlying;
-		double P = (K / (1 - y2())) * pow(((S / K) * ((y2() - 1) / y2())), y2());
+		double Y2 = y2();
+		double P = (K / (1 - Y2)) * exp(Y2 * log((underlying / K) * ((Y2 - 1) / Y2)));
 		return P;
 	}
 
@@ -87,17 +88,96 @@ namespace Options
 	// Global function to create a vector of doubles separated by size h
 	vector<double> AmericanOption::FactorCNG(double start, double end, double h)
 	{
-		// Create an empty vector to store the factor values
-		vector<double> factor;
+		// The number of values is fixed up front and value i is start + i * h, so rounding cannot add or drop a value
+		vector<double> factor(LadderPoints(start, end, h));
+		FillLadder(start, h, factor.size(), factor.data());
+
+		// Return the completed factor vector
+		return factor;
+	}
 
-		// Loop from start to end with increment h, and add each value to the factor vector
-		for (double i = start; i <= end; i += h)
+	void AmericanOption::SpotLadder(const double* spot, size_t n, double* call, double* put) const // function to price call and put over a ladder of underlying prices (see Ladder.h), y1 and y2 are evaluated once per ladder
+	{
+		// The perpetual prices are power functions of S: C = callScale * S^y1 and P = putScale * S^y2
+		AmExponents e = Exponents(sig, r, b);
+		double Y1 = e.Y1;
+		double Y2 = e.Y2;
+		double callScale = (K / (Y1 - 1)) * exp(Y1 * (e.LogCallRatio - log(K)));
+		double putScale = (K / (1 - Y2)) * exp(Y2 * (e.LogPutRatio - log(K)));
+
+		BATCH_LOOP
+		for (size_t i = 0; i < n; ++i)
 		{
-			factor.push_back(i);
+			double logS = log(spot[i]);
+			call[i] = callScale * exp(Y1 * logS);
+			put[i] = putScale * exp(Y2 * logS);
 		}
+	}
 
-		// Return the completed factor vector
-		return factor;
+	AmExponents AmericanOption::Exponents(double sigma, double rate, double B) // function to calculate y1, y2 and the log ratios once for a (sigma, r, b) triple
+	{
+		AmExponents e;
+		e.sig = sigma;
+		e.r = rate;
+		e.b = B;
+
+		// y1 and y2 are the roots of 0.5 * sig^2 * y * (y - 1) + b * y - r = 0
+		double sig2 = sigma * sigma;
+		double u = (B / sig2) - 0.5;
+		double root = sqrt(u * u + (2 * rate) / sig2);
+		e.Y1 = -u + root;
+		e.Y2 = -u - root;
+		e.LogCallRatio = log((e.Y1 - 1) / e.Y1);
+		e.LogPutRatio = log((e.Y2 - 1) / e.Y2);
+		return e;
+	}
+
+	// Function to price n perpetual call and put options, reusing the exponents across scenarios
+	void AmericanOption::PerpetualBatch(const double* sig, const double* r, const double* B, const double* S, const double* K, double* call, double* put, size_t n)
+	{
+		const size_t Block = 64; // scenarios per block, so the scratch arrays stay in L1 cache
+		const int CacheSize = 8; // distinct (sigma, r, b) triples remembered, enough for the vols of a typical sweep
+		AmExponents cache[CacheSize];
+		int cached = 0, next = 0, last = 0;
+		double Y1[Block], Y2[Block], callRatio[Block], putRatio[Block];
+
+		for (size_t start = 0; start < n; start += Block)
+		{
+			size_t m = min(Block, n - start);
+
+			// Stage 1: look up the exponents of each scenario, trying the previous scenario's entry first and calculating them on a miss
+			for (size_t i = 0; i < m; ++i)
+			{
+				size_t j = start + i;
+				int hit = (cached > 0 && cache[last].sig == sig[j] && cache[last].r == r[j] && cache[last].b == B[j]) ? last : -1;
+				for (int k = 0; k < cached && hit < 0; ++k)
+				{
+					hit = (cache[k].sig == sig[j] && cache[k].r == r[j] && cache[k].b == B[j]) ? k : -1;
+				}
+				if (hit < 0)
+				{
+					hit = next;
+					cache[next] = Exponents(sig[j], r[j], B[j]);
+					next = (next + 1) % CacheSize;
+					cached = min(cached + 1, CacheSize);
+				}
+				last = hit;
+				Y1[i] = cache[hit].Y1;
+				Y2[i] = cache[hit].Y2;
+				callRatio[i] = cache[hit].LogCallRatio;
+				putRatio[i] = cache[hit].LogPutRatio;
+			}
+
+			// Stage 2: C = K / (y1 - 1) * ((S / K) * (y1 - 1) / y1)^y1, the power taken as exp(y1 * (log(S / K) + log((y1 - 1) / y1)))
+			BATCH_LOOP
+			for (size_t i = 0; i < m; ++i)
+			{
+				size_t j = start + i;
+				double logMoney = log(S[j] / K[j]);
+				call[j] = (K[j] / (Y1[i] - 1)) * exp(Y1[i] * (logMoney + callRatio[i]));
+				put[j] = (K[j] / (1 - Y2[i])) * exp(Y2[i] * (logMoney + putRatio[i]));
+			}
+		}
 	}
 
 	// Function to create and print a vector of changed option prices, having changed asset price
@@ -106,60 +186,47 @@ namespace Options
 		// Create a vector of factor values using the FactorCNG function
 		vector<double> F = FactorCNG(start, end, h);
 
-		// Create empty vectors to store the call and put prices
-		vector<double> CallVector;
-		vector<double> PutVector;
-
-		// Loop through the factor vector, and for each value, calculate the call and put prices
-		for (auto it = F.begin(); it != F.end(); it += h)
-		{
-			// Calculate the call price using the AmCallPrice function
-			CallVector.push_back(AmCallPrice(*it));
-
-			// Calculate the put price using the AmPutPrice function
-			PutVector.push_back(AmPutPrice(*it));
-		}
+		// Price the whole ladder of underlying prices in one pass
+		vector<double> CallVector(F.size());
+		vector<double> PutVector(F.size());
+		SpotLadder(F.data(), F.size(), CallVector.data(), PutVector.data());
 
 		// Print the header for the output table
 		cout << setw(15) << "Underlying Price" << setw(15) << "Call Price" << setw(15) << "Put Price" << endl;
 
 		// Loop through the factor vector and print the underlying price, call price, and put price for each scenario
-		for (int i = 0; i < F.size(); ++i)
+		for (size_t i = 0; i < F.size(); ++i)
 		{
 			cout << setw(15) << F[i] << setw(15) << CallVector[i] << setw(15) << PutVector[i] << endl;
 		}
 	}
 
 	// Function to create and print a vector of changed option prices, having changing multiple factors affecting option pricing
-	void AmericanOption::MultiFactorPricer(vector<vector<double>> multiFactor)
+	void AmericanOption::MultiFactorPricer(const vector<vector<double>>& multiFactor) const
 	{
-		// Create empty vectors to store the call and put prices for each scenario
-		vector<double> callValues;
-		vector<double> putValues;
+		// Gather the scenarios into columns and price them in one pass, the exponents are shared by scenarios with equal (sigma, r, b)
+		size_t n = multiFactor.size();
+		vector<double> strike(n), vol(n), rate(n), underlying(n), carry(n);
+		for (size_t i = 0; i < n; ++i)
+		{
+			strike[i] = multiFactor[i].at(0);
+			vol[i] = multiFactor[i].at(1);
+			rate[i] = multiFactor[i].at(2);
+			underlying[i] = multiFactor[i].at(3);
+			carry[i] = multiFactor[i].at(4);
+		}
+		vector<double> callValues(n);
+		vector<double> putValues(n);
+		PerpetualBatch(vol.data(), rate.data(), carry.data(), underlying.data(), strike.data(), callValues.data(), putValues.data(), n);
 
 		// Print the header for the output table
 		cout << setw(10) << "Strike" << setw(15) << "Volatility" << setw(10) << "Rate" << setw(15) << "Underlying" << setw(10) << "B-value" << setw(15) << "Call Price" << setw(15) << "Put Price" << endl;
 
 		// Loop through the multi-factor scenarios
-		for (auto it = multiFactor.begin(); it != multiFactor.end(); ++it)
+		for (size_t i = 0; i < n; ++i)
 		{
-			// Set the parameters for the current scenario
-			SetStrike(it->at(0));
-			SetVolatility(it->at(1));
-			SetRate(it->at(2));
-			SetUnderlying(it->at(3));
-			SetB(it->at(4));
-
-			// Price the European call and put options using the AmCallPrice and AmPutPrice functions
-			double callPrice = AmCallPrice();
-			double putPrice = AmPutPrice();
-
 			// Print the scenario parameters and option prices
-			cout << setw(10) << it->at(0) << setw(10) << it->at(1) << setw(15) << it->at(2) << setw(10) << it->at(3) << setw(15) << it->at(4) << setw(15) << callPrice << setw(15) << putPrice << endl;
-
-			// Add the call and put prices to the result vectors
-			callValues.push_back(callPrice);
-			putValues.push_back(putPrice);
+			cout << setw(10) << strike[i] << setw(10) << vol[i] << setw(15) << rate[i] << setw(10) << underlying[i] << setw(15) << carry[i] << setw(15) << callValues[i] << setw(15) << putValues[i] << endl;
 		}
 	}
 
@@ -12,6 +12,14 @@ using namespace boost::math;
 
 namespace Options
 {
+	// Exponents of the perpetual American option for one (sigma, r, b) triple, with the logs of (y - 1) / y that scale the price
+	struct AmExponents
+	{
+		double sig, r, b; // the triple they were calculated for
+		double Y1, Y2; // y1 and y2
+		double LogCallRatio, LogPutRatio; // log((y1 - 1) / y1) and log((y2 - 1) / y2)
+	};
+
 	class AmericanOption
 	{
 	private:
@@ -31,8 +39,8 @@ namespace Options
 		double y2() const; // function to calculate value of y2
 		double AmCallPrice() const; // function to calculate price of American Call Option
 		double AmPutPrice() const; // function to calculate price of American Put Option
-		double AmCallPrice(double underlying); // function to calculate price of American Call Option, with dependancy on change of underlying price
-		double AmPutPrice(double underlying); // function to calculate price of American Put Option, with dependancy on change of underlying price
+		double AmCallPrice(double underlying) const; // function to calculate price of American Call Option, with dependancy on change of underlying price (the option itself is not changed)
+		double AmPutPrice(double underlying) const; // function to calculate price of American Put Option, with dependancy on change of underlying price (the option itself is not changed)
 
 		void SetVolatility(double vol); // setter function for sigma
 		void SetRate(double rate); // setter function for rate
@@ -41,9 +49,16 @@ namespace Options
 		void SetB(double B); // setter function for cost of carry
 
 		vector<double> FactorCNG(double start, double end, double h); // global function to create a vector of doubles seperated by size h
+		void SpotLadder(const double* spot, size_t n, double* call, double* put) const; // function to price call and put over a ladder of underlying prices (see Ladder.h), y1 and y2 are evaluated once per ladder
+
+		static AmExponents Exponents(double sigma, double rate, double B); // function to calculate y1, y2 and the log ratios once for a (sigma, r, b) triple
+		// Prices n perpetual options given column-wise, scenario i being (sig[i], r[i], B[i], S[i], K[i]). The exponents are kept
+		// in a small cache keyed on (sigma, r, b), so they are calculated once per distinct triple however many spots and strikes
+		// share it, and each price costs one log and one exp instead of three y1()/y2() evaluations and a pow
+		static void PerpetualBatch(const double* sig, const double* r, const double* B, const double* S, const double* K, double* call, double* put, size_t n); // function to price n perpetual call and put options, reusing the exponents across scenarios
 
 		void SingleFactorPricer(double start, double end, double h); // function to create and print a vector of changed option prices, having changed asset price
-		void MultiFactorPricer(vector<vector<double>> multiFactor); // function to create anf print a vector of changed option prices, having changing multiple factors affecting option pricing
+		void MultiFactorPricer(const vector<vector<double>>& multiFactor) const; // function to create anf print a vector of changed option prices, having changing multiple factors affecting option pricing
 	};
 
 }
@@ -0,0 +1,134 @@
+// Group A & B: Source file for the batch put-call parity and no-arbitrage checks of quoted or modelled option chains
+
+#include "Arbitrage.h"
+#include "NormalCdf.h"
+#include "Scheduler.h"
+#include <algorithm>
+#include <cmath>
+using namespace std;
+
+namespace Options
+{
+	const size_t ArbitrageBlock = 64; // contracts per block, so the scratch arrays below stay in L1 cache
+	const size_t ArbitrageGrain = 8; // chains per scheduled task
+
+	// Function to add a violation to the list
+	static void Report(vector<ArbitrageViolation>& out, ArbitrageKind kind, size_t index, size_t other, double excess)
+	{
+		ArbitrageViolation v = { kind, index, other, excess };
+		out.push_back(v);
+	}
+
+	// Function to run the parity, strike and butterfly checks over the contracts [begin, end) of one chain. Stage 1 computes
+	// the excess of every check for every contract branch free, negative where the check holds or the neighbours belong to
+	// another expiry; stage 2 keeps the positive ones
+	static void CheckStrikes(const QuoteArrays& a, size_t begin, size_t end, const ArbitrageTolerance& tol, vector<ArbitrageViolation>& out)
+	{
+		double parity[ArbitrageBlock], callStrike[ArbitrageBlock], putStrike[ArbitrageBlock], callSpread[ArbitrageBlock], putSpread[ArbitrageBlock];
+		double callFly[ArbitrageBlock], putFly[ArbitrageBlock];
+
+		for (size_t start = begin; start < end; start += ArbitrageBlock)
+		{
+			size_t m = min(ArbitrageBlock, end - start);
+
+			// Stage 1: excess of each bound, the neighbours clamped to the chain so nothing past its end is read
+			BATCH_LOOP
+			for (size_t i = 0; i < m; ++i)
+			{
+				size_t j = start + i;
+				size_t j1 = (j + 1 < end) ? j + 1 : j;
+				size_t j2 = (j + 2 < end) ? j + 2 : j1;
+				double D = exp(-a.r[j] * a.T[j]);
+				double F = a.S[j] * exp(-a.q[j] * a.T[j]);
+				bool pair = (j1 != j) && (a.T[j1] == a.T[j]);
+				bool triple = (j2 != j1) && (a.T[j2] == a.T[j]);
+
+				parity[i] = fabs(a.Call[j] - a.Put[j] - (F - a.K[j] * D)) - tol.Parity;
+
+				double width = a.K[j1] - a.K[j];
+				double dC = a.Call[j] - a.Call[j1], dP = a.Put[j1] - a.Put[j];
+				callStrike[i] = pair ? -dC - tol.Strike : -1.0;
+				putStrike[i] = pair ? -dP - tol.Strike : -1.0;
+				callSpread[i] = pair ? dC - D * width - tol.Strike : -1.0;
+				putSpread[i] = pair ? dP - D * width - tol.Strike : -1.0;
+
+				double span = a.K[j2] - a.K[j];
+				double w1 = (a.K[j2] - a.K[j1]) / span, w3 = width / span;
+				callFly[i] = triple ? -(w1 * a.Call[j] - a.Call[j1] + w3 * a.Call[j2]) - tol.Butterfly : -1.0;
+				putFly[i] = triple ? -(w1 * a.Put[j] - a.Put[j1] + w3 * a.Put[j2]) - tol.Butterfly : -1.0;
+			}
+
+			// Stage 2: compact the violations, in contract order
+			for (size_t i = 0; i < m; ++i)
+			{
+				size_t j = start + i;
+				if (parity[i] > 0.0) Report(out, ArbParity, j, j, parity[i]);
+				if (callStrike[i] > 0.0) Report(out, ArbCallStrike, j, j + 1, callStrike[i]);
+				if (putStrike[i] > 0.0) Report(out, ArbPutStrike, j, j + 1, putStrike[i]);
+				if (callSpread[i] > 0.0) Report(out, ArbCallSpread, j, j + 1, callSpread[i]);
+				if (putSpread[i] > 0.0) Report(out, ArbPutSpread, j, j + 1, putSpread[i]);
+				if (callFly[i] > 0.0) Report(out, ArbCallButterfly, j, j + 2, callFly[i]);
+				if (putFly[i] > 0.0) Report(out, ArbPutButterfly, j, j + 2, putFly[i]);
+			}
+		}
+	}
+
+	// Function to run the calendar check between neighbouring expiries of the chain [begin, end). The call of the later expiry
+	// is interpolated linearly in the strike at the matched moneyness; as the call is convex in the strike the interpolation
+	// can only overstate it, so a reported violation is never an artefact of the interpolation
+	static void CheckCalendar(const QuoteArrays& a, size_t begin, size_t end, const ArbitrageTolerance& tol, vector<ArbitrageViolation>& out)
+	{
+		size_t first = begin;
+		while (first < end)
+		{
+			size_t last = first;
+			while (last < end && a.T[last] == a.T[first]) ++last;
+			size_t next = last;
+			while (next < end && a.T[next] == a.T[last]) ++next;
+			if (next - last < 2)
+			{
+				first = last;
+				continue;
+			}
+
+			// Expiry T1 is [first, last), T2 is [last, next)
+			double F1 = a.S[first] * exp(-a.q[first] * a.T[first]), Fwd1 = F1 * exp(a.r[first] * a.T[first]);
+			double F2 = a.S[last] * exp(-a.q[last] * a.T[last]), Fwd2 = F2 * exp(a.r[last] * a.T[last]);
+			size_t p = last;
+			for (size_t j = first; j < last; ++j)
+			{
+				double target = a.K[j] * Fwd2 / Fwd1;
+				if (target < a.K[last] || target > a.K[next - 1]) continue;
+
+				while (p + 2 < next && a.K[p + 1] < target) ++p;
+				double w = (target - a.K[p]) / (a.K[p + 1] - a.K[p]);
+				double later = (a.Call[p] + w * (a.Call[p + 1] - a.Call[p])) / F2;
+				double excess = a.Call[j] - later * F1 - tol.Calendar;
+				if (excess > 0.0) Report(out, ArbCalendar, j, p + 1, excess);
+			}
+			first = last;
+		}
+	}
+
+	// Function to check a snapshot of option chains for arbitrage and return the number of violations. The violations are
+	// grouped by chain in chain order; within a chain the strike checks come in contract order, then the calendar checks
+	size_t ArbitrageCheck(const QuoteArrays& quotes, const size_t* chainBegin, size_t chains, const ArbitrageTolerance& tol, vector<ArbitrageViolation>& out, unsigned nThreads)
+	{
+		vector<vector<ArbitrageViolation> > found(chains);
+		ParallelFor(chains, ArbitrageGrain, [&](size_t begin, size_t end)
+		{
+			for (size_t c = begin; c < end; ++c)
+			{
+				CheckStrikes(quotes, chainBegin[c], chainBegin[c + 1], tol, found[c]);
+				CheckCalendar(quotes, chainBegin[c], chainBegin[c + 1], tol, found[c]);
+			}
+		}, nThreads);
+
+		out.clear();
+		for (size_t c = 0; c < chains; ++c)
+		{
+			out.insert(out.end(), found[c].begin(), found[c].end());
+		}
+		return out.size();
+	}
+}
@@ -0,0 +1,56 @@
+// Group A & B: Header file for the batch put-call parity and no-arbitrage checks of quoted or modelled option chains
+
+#ifndef ArbitrageHPP
+#define ArbitrageHPP
+
+#include <vector>
+#include <cstddef>
+using namespace std;
+
+namespace Options
+{
+	// Kinds of violation. With D = exp(-r*T) and F = S*exp(-q*T), along the strikes K1 < K2 < K3 of one expiry and across
+	// the expiries T1 < T2 of one chain:
+	enum ArbitrageKind
+	{
+		ArbParity, // |C - P - (F - K*D)| above tolerance
+		ArbCallStrike, // C(K2) > C(K1), a call rising with the strike
+		ArbPutStrike, // P(K1) > P(K2), a put falling with the strike
+		ArbCallSpread, // C(K1) - C(K2) > D*(K2 - K1), a call spread worth more than its maximum payoff
+		ArbPutSpread, // P(K2) - P(K1) > D*(K2 - K1), a put spread worth more than its maximum payoff
+		ArbCallButterfly, // a call butterfly on (K1, K2, K3) with negative value, the call not convex in the strike
+		ArbPutButterfly, // a put butterfly on (K1, K2, K3) with negative value, the put not convex in the strike
+		ArbCalendar // C(T1, K)/F1 > C(T2, K')/F2 at the same moneyness K/(F1/D1) == K'/(F2/D2), time value falling with T
+	};
+
+	// Absolute tolerances in price units, a check fires only when its bound is broken by more than these
+	struct ArbitrageTolerance
+	{
+		double Parity, Strike, Butterfly, Calendar;
+	};
+
+	// One violation: Index is the first contract involved (K1 or T1), Other the last (K2, K3, or the strike at T2 just above
+	// the matched moneyness) and Excess the amount by which the bound is broken, beyond the tolerance
+	struct ArbitrageViolation
+	{
+		ArbitrageKind Kind;
+		size_t Index, Other;
+		double Excess;
+	};
+
+	// Quotes of n contracts, each with a call and a put price. Chain c (one underlying) covers contracts
+	// [chainBegin[c], chainBegin[c + 1]) sorted by expiry and, within an expiry, by increasing strike
+	struct QuoteArrays
+	{
+		const double* T; const double* S; const double* r; const double* q; const double* K;
+		const double* Call; const double* Put;
+	};
+
+	// The contract and strike checks run over blocks of contracts in loops the compiler can vectorise, with the pairs and
+	// triples that straddle two expiries masked out; the calendar check walks neighbouring expiries with two pointers. The
+	// chains are checked in parallel (nThreads == 0 means all cores) and the violations are returned grouped by chain in
+	// chain order, the same for any number of threads. Returns the number of violations
+	size_t ArbitrageCheck(const QuoteArrays& quotes, const size_t* chainBegin, size_t chains, const ArbitrageTolerance& tol, vector<ArbitrageViolation>& out, unsigned nThreads = 0); // function to check a snapshot of option chains for arbitrage
+}
+
+#endif
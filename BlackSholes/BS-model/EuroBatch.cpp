@@ -0,0 +1,315 @@
+// Group A & B: Source file for batch (structure-of-arrays) pricing of Plain (European) options
+
+#include "EuroBatch.h"
+#include <cmath>
+#include <algorithm>
+#include <boost/math/distributions/normal.hpp>
+using namespace std;
+using namespace boost::math;
+
+namespace Options
+{
+	const size_t BatchBlock = 64; // contracts per block, so the scratch arrays below stay in L1 cache
+
+	// Function to return the cost of carry b = RateCarry * r + YieldCarry * y of a model policy; r - y for SpotModel
+	template<class Model, class Real>
+	inline Real Carry(Real r, Real y)
+	{
+		return Model::RateCarry * r + Model::YieldCarry * y;
+	}
+
+	// Function to return the gap r - b, the rate at which the discounted forward decays; y for SpotModel, r for Black76Model.
+	// Written with the policy's constants rather than as r - b, so it is exact
+	template<class Model, class Real>
+	inline Real Gap(Real r, Real y)
+	{
+		return (1 - Model::RateCarry) * r - Model::YieldCarry * y;
+	}
+
+	// Kernel behind every EuroBatchPrice, for any model policy in double or single precision. With the carry b and the gap
+	// g = r - b of the policy it prices exp(-r*T) * Black(S * exp(b*T), K). sqrtT, discR and discQ (then exp(-g*T)) are
+	// either all null, and then calculated here, or all given
+	template<class Model, class Real>
+	static void PriceKernel(const Real* T, const Real* sig, const Real* r, const Real* y, const Real* S, const Real* K, const Real* sqrtT, const Real* discR, const Real* discQ, Real* call, Real* put, size_t n, CdfTier tier)
+	{
+		Real d1[BatchBlock], d2[BatchBlock], fwdS[BatchBlock], disK[BatchBlock], Nd1[BatchBlock], Nd2[BatchBlock], Nmd1[BatchBlock], Nmd2[BatchBlock];
+
+		for (size_t start = 0; start < n; start += BatchBlock)
+		{
+			size_t m = min(BatchBlock, n - start);
+
+			// Stage 1: d1, d2 and the discounted underlying and strike, each log/exp/sqrt evaluated once per contract
+			if (sqrtT == 0)
+			{
+				BATCH_LOOP
+				for (size_t i = 0; i < m; ++i)
+				{
+					size_t j = start + i;
+					Real sigSqrtT = sig[j] * sqrt(T[j]);
+					Real carry = Carry<Model>(r[j], y[j]);
+					Real gap = Gap<Model>(r[j], y[j]);
+					d1[i] = (log(S[j] / K[j]) + (carry + ((sig[j] * sig[j]) / 2)) * T[j]) / sigSqrtT;
+					d2[i] = d1[i] - sigSqrtT;
+					fwdS[i] = S[j] * exp(-gap * T[j]);
+					disK[i] = K[j] * exp(-r[j] * T[j]);
+				}
+			}
+			else
+			{
+				BATCH_LOOP
+				for (size_t i = 0; i < m; ++i)
+				{
+					size_t j = start + i;
+					Real sigSqrtT = sig[j] * sqrtT[j];
+					Real carry = Carry<Model>(r[j], y[j]);
+					d1[i] = (log(S[j] / K[j]) + (carry + ((sig[j] * sig[j]) / 2)) * T[j]) / sigSqrtT;
+					d2[i] = d1[i] - sigSqrtT;
+					fwdS[i] = S[j] * discQ[j];
+					disK[i] = K[j] * discR[j];
+				}
+			}
+
+			// Stage 2: normal cdf, N(d) and N(-d) from one tail evaluation each, so each contract needs two. N(-d) is not
+			// taken as 1 - N(d), which would lose every digit of a deep out of the money put
+			NormalCdfBatch(d1, Nd1, Nmd1, m, tier);
+			NormalCdfBatch(d2, Nd2, Nmd2, m, tier);
+
+			// Stage 3: the prices
+			BATCH_LOOP
+			for (size_t i = 0; i < m; ++i)
+			{
+				call[start + i] = (fwdS[i] * Nd1[i]) - (disK[i] * Nd2[i]);
+				put[start + i] = (disK[i] * Nmd2[i]) - (fwdS[i] * Nmd1[i]);
+			}
+		}
+	}
+
+	// Function to price n European call and put options in blocks the compiler can vectorise
+	void EuroBatchPrice(const double* T, const double* sig, const double* r, const double* q, const double* S, const double* K, double* call, double* put, size_t n, CdfTier tier)
+	{
+		PriceKernel<SpotModel, double>(T, sig, r, q, S, K, 0, 0, 0, call, put, n, tier);
+	}
+
+	// Kernel behind every EuroBatchGreeks, for any model policy in double or single precision, higher may be null. The higher order Greeks reuse
+	// the block's d1, d2, n(d1), sqrt(T) and exp(-q*T) and need no further transcendental function, so they add only a few
+	// multiplications per contract. The carry b and gap g are as in PriceKernel; rootT, discR and discQ (exp(-g*T)) are either
+	// all null, and then calculated here, or all given
+	template<class Model, class Real>
+	static void GreeksKernel(const Real* T, const Real* sig, const Real* r, const Real* y, const Real* S, const Real* K, const Real* rootT, const Real* discR, const Real* discQ, const EuroGreeksArraysT<Real>& out, const EuroHigherGreeksArraysT<Real>* higher, size_t n, CdfTier tier)
+	{
+		Real sqrtT[BatchBlock], d1[BatchBlock], d2[BatchBlock], expQT[BatchBlock], expRT[BatchBlock], Nd1[BatchBlock], Nd2[BatchBlock], Nmd1[BatchBlock], Nmd2[BatchBlock], nd1[BatchBlock];
+
+		for (size_t start = 0; start < n; start += BatchBlock)
+		{
+			size_t m = min(BatchBlock, n - start);
+
+			// Stage 1: the discount factors, then d1 and d2
+			if (rootT == 0)
+			{
+				BATCH_LOOP
+				for (size_t i = 0; i < m; ++i)
+				{
+					size_t j = start + i;
+					sqrtT[i] = sqrt(T[j]);
+					expQT[i] = exp(-Gap<Model>(r[j], y[j]) * T[j]);
+					expRT[i] = exp(-r[j] * T[j]);
+				}
+			}
+			else
+			{
+				BATCH_LOOP
+				for (size_t i = 0; i < m; ++i)
+				{
+					size_t j = start + i;
+					sqrtT[i] = rootT[j];
+					expQT[i] = discQ[j];
+					expRT[i] = discR[j];
+				}
+			}
+
+			BATCH_LOOP
+			for (size_t i = 0; i < m; ++i)
+			{
+				size_t j = start + i;
+				Real sigSqrtT = sig[j] * sqrtT[i];
+				Real carry = Carry<Model>(r[j], y[j]);
+				d1[i] = (log(S[j] / K[j]) + (carry + ((sig[j] * sig[j]) / 2)) * T[j]) / sigSqrtT;
+				d2[i] = d1[i] - sigSqrtT;
+			}
+
+			// Stage 2: N(d1), N(d2), N(-d1), N(-d2) and n(d1); the put side uses N(-d) as in PriceKernel
+			NormalCdfBatch(d1, Nd1, Nmd1, m, tier);
+			NormalCdfBatch(d2, Nd2, Nmd2, m, tier);
+			NormalPdfBatch(d1, nd1, m);
+
+			// Stage 3: everything built from them
+			BATCH_LOOP
+			for (size_t i = 0; i < m; ++i)
+			{
+				size_t j = start + i;
+				Real fwdS = S[j] * expQT[i];
+				Real disK = K[j] * expRT[i];
+				Real decay = -(fwdS * sig[j] * nd1[i]) / (2 * sqrtT[i]);
+				Real gap = Gap<Model>(r[j], y[j]);
+				Real forwardRho = (Model::RateCarry - 1) * T[j] * fwdS; // change of the discounted forward with r, zero when b moves with r
+
+				out.CallPrice[j] = (fwdS * Nd1[i]) - (disK * Nd2[i]);
+				out.PutPrice[j] = (disK * Nmd2[i]) - (fwdS * Nmd1[i]);
+				out.CallDelta[j] = expQT[i] * Nd1[i];
+				out.PutDelta[j] = -expQT[i] * Nmd1[i];
+				out.Gamma[j] = (expQT[i] * nd1[i]) / (S[j] * sig[j] * sqrtT[i]);
+				out.Vega[j] = fwdS * sqrtT[i] * nd1[i];
+				out.CallTheta[j] = decay - (r[j] * disK * Nd2[i]) + (gap * fwdS * Nd1[i]);
+				out.PutTheta[j] = decay + (r[j] * disK * Nmd2[i]) - (gap * fwdS * Nmd1[i]);
+				out.CallRho[j] = T[j] * disK * Nd2[i] + forwardRho * Nd1[i];
+				out.PutRho[j] = -T[j] * disK * Nmd2[i] - forwardRho * Nmd1[i];
+			}
+
+			if (higher == 0)
+			{
+				continue;
+			}
+
+			// Stage 4: second and third order Greeks from the same intermediates
+			const EuroHigherGreeksArraysT<Real>& h = *higher;
+			BATCH_LOOP
+			for (size_t i = 0; i < m; ++i)
+			{
+				size_t j = start + i;
+				Real sigSqrtT = sig[j] * sqrtT[i];
+				Real gamma = (expQT[i] * nd1[i]) / (S[j] * sigSqrtT);
+				Real vega = S[j] * expQT[i] * sqrtT[i] * nd1[i];
+				Real carry = Carry<Model>(r[j], y[j]);
+				Real gap = Gap<Model>(r[j], y[j]);
+				Real drift = (2 * carry * T[j] - d2[i] * sigSqrtT) / (2 * T[j] * sigSqrtT); // d(d1)/dt term shared by charm and color
+
+				h.Vanna[j] = -expQT[i] * nd1[i] * d2[i] / sig[j];
+				h.Volga[j] = vega * d1[i] * d2[i] / sig[j];
+				h.CallCharm[j] = gap * expQT[i] * Nd1[i] - expQT[i] * nd1[i] * drift;
+				h.PutCharm[j] = -gap * expQT[i] * Nmd1[i] - expQT[i] * nd1[i] * drift;
+				h.Speed[j] = -(gamma / S[j]) * (d1[i] / sigSqrtT + 1);
+				h.Color[j] = gamma * (gap + drift * d1[i] + 1 / (2 * T[j]));
+			}
+		}
+	}
+
+	// Function to calculate prices and first order Greeks of n call and put options, sharing d1, d2, discount factors and N(d) within each contract
+	void EuroBatchGreeks(const double* T, const double* sig, const double* r, const double* q, const double* S, const double* K, const EuroGreeksArrays& out, size_t n, CdfTier tier)
+	{
+		GreeksKernel<SpotModel, double>(T, sig, r, q, S, K, 0, 0, 0, out, 0, n, tier);
+	}
+
+	// Function to calculate prices, first order and higher order Greeks of n call and put options in the same pass
+	void EuroBatchGreeks(const double* T, const double* sig, const double* r, const double* q, const double* S, const double* K, const EuroGreeksArrays& out, const EuroHigherGreeksArrays& higher, size_t n, CdfTier tier)
+	{
+		GreeksKernel<SpotModel, double>(T, sig, r, q, S, K, 0, 0, 0, out, &higher, n, tier);
+	}
+
+	// Function to price n European call and put options whose sqrt(T), exp(-r*T) and exp(-q*T) are given
+	void EuroBatchPrice(const double* T, const double* sig, const double* r, const double* q, const double* S, const double* K, const double* sqrtT, const double* discR, const double* discQ, double* call, double* put, size_t n, CdfTier tier)
+	{
+		PriceKernel<SpotModel, double>(T, sig, r, q, S, K, sqrtT, discR, discQ, call, put, n, tier);
+	}
+
+	// Function to calculate prices and first order Greeks of n call and put options whose sqrt(T), exp(-r*T) and exp(-q*T) are given
+	void EuroBatchGreeks(const double* T, const double* sig, const double* r, const double* q, const double* S, const double* K, const double* sqrtT, const double* discR, const double* discQ, const EuroGreeksArrays& out, size_t n, CdfTier tier)
+	{
+		GreeksKernel<SpotModel, double>(T, sig, r, q, S, K, sqrtT, discR, discQ, out, 0, n, tier);
+	}
+
+	// Function to price n European call and put options in single precision
+	void EuroBatchPrice(const float* T, const float* sig, const float* r, const float* q, const float* S, const float* K, float* call, float* put, size_t n, CdfTier tier)
+	{
+		PriceKernel<SpotModel, float>(T, sig, r, q, S, K, 0, 0, 0, call, put, n, tier);
+	}
+
+	// Function to calculate prices and first order Greeks of n call and put options in single precision
+	void EuroBatchGreeks(const float* T, const float* sig, const float* r, const float* q, const float* S, const float* K, const EuroGreeksArraysF& out, size_t n, CdfTier tier)
+	{
+		GreeksKernel<SpotModel, float>(T, sig, r, q, S, K, 0, 0, 0, out, 0, n, tier);
+	}
+
+	// Function to price n European call and put options under one model
+	template<class Model>
+	void ModelBatchPrice(const double* T, const double* sig, const double* r, const double* y, const double* S, const double* K, double* call, double* put, size_t n, CdfTier tier)
+	{
+		PriceKernel<Model, double>(T, sig, r, y, S, K, 0, 0, 0, call, put, n, tier);
+	}
+
+	// Function to calculate prices and first order Greeks of n call and put options under one model
+	template<class Model>
+	void ModelBatchGreeks(const double* T, const double* sig, const double* r, const double* y, const double* S, const double* K, const EuroGreeksArrays& out, size_t n, CdfTier tier)
+	{
+		GreeksKernel<Model, double>(T, sig, r, y, S, K, 0, 0, 0, out, 0, n, tier);
+	}
+
+	template void ModelBatchPrice<SpotModel>(const double*, const double*, const double*, const double*, const double*, const double*, double*, double*, size_t, CdfTier);
+	template void ModelBatchPrice<Black76Model>(const double*, const double*, const double*, const double*, const double*, const double*, double*, double*, size_t, CdfTier);
+	template void ModelBatchGreeks<SpotModel>(const double*, const double*, const double*, const double*, const double*, const double*, const EuroGreeksArrays&, size_t, CdfTier);
+	template void ModelBatchGreeks<Black76Model>(const double*, const double*, const double*, const double*, const double*, const double*, const EuroGreeksArrays&, size_t, CdfTier);
+
+	// Function to return in order the contracts grouped by model, stable within a model, by a counting sort
+	void SortByModel(const EuroModel* model, size_t n, size_t* order, size_t* modelBegin)
+	{
+		size_t next[EuroModels] = {};
+		for (size_t i = 0; i < n; ++i)
+		{
+			++next[model[i]];
+		}
+		modelBegin[0] = 0;
+		for (int m = 0; m < EuroModels; ++m)
+		{
+			modelBegin[m + 1] = modelBegin[m] + next[m];
+			next[m] = modelBegin[m];
+		}
+		for (size_t i = 0; i < n; ++i)
+		{
+			order[next[model[i]]++] = i;
+		}
+	}
+
+	// Function to price a book grouped by model, one kernel call per model; Garman-Kohlhagen contracts run through SpotModel
+	void MixedBatchPrice(const size_t* modelBegin, const double* T, const double* sig, const double* r, const double* y, const double* S, const double* K, double* call, double* put, CdfTier tier)
+	{
+		for (int m = 0; m < EuroModels; ++m)
+		{
+			size_t b = modelBegin[m], n = modelBegin[m + 1] - b;
+			switch (m)
+			{
+			case ModelBlack76: ModelBatchPrice<Black76Model>(T + b, sig + b, r + b, y + b, S + b, K + b, call + b, put + b, n, tier); break;
+			default: ModelBatchPrice<SpotModel>(T + b, sig + b, r + b, y + b, S + b, K + b, call + b, put + b, n, tier); break;
+			}
+		}
+	}
+
+	// Function to calculate prices and first order Greeks of a book grouped by model, one kernel call per model; Garman-Kohlhagen
+	// contracts run through SpotModel
+	void MixedBatchGreeks(const size_t* modelBegin, const double* T, const double* sig, const double* r, const double* y, const double* S, const double* K, const EuroGreeksArrays& out, CdfTier tier)
+	{
+		for (int m = 0; m < EuroModels; ++m)
+		{
+			size_t b = modelBegin[m], n = modelBegin[m + 1] - b;
+			EuroGreeksArrays part = { out.CallPrice + b, out.PutPrice + b, out.CallDelta + b, out.PutDelta + b, out.Gamma + b, out.Vega + b,
+				out.CallTheta + b, out.PutTheta + b, out.CallRho + b, out.PutRho + b };
+			switch (m)
+			{
+			case ModelBlack76: ModelBatchGreeks<Black76Model>(T + b, sig + b, r + b, y + b, S + b, K + b, part, n, tier); break;
+			default: ModelBatchGreeks<SpotModel>(T + b, sig + b, r + b, y + b, S + b, K + b, part, n, tier); break;
+			}
+		}
+	}
+
+	// Function to price n European call and put options one at a time, using the same formula as EuroCallPrice and EuroPutPrice
+	void EuroBatchPriceScalar(const double* T, const double* sig, const double* r, const double* q, const double* S, const double* K, double* call, double* put, size_t n)
+	{
+		normal_distribution<> myNormal(0, 1);
+
+		for (size_t i = 0; i < n; ++i)
+		{
+			double d1 = (log(S[i] / K[i]) + (r[i] - q[i] + ((sig[i] * sig[i]) / 2)) * T[i]) / (sig[i] * sqrt(T[i]));
+			double d2 = d1 - (sig[i] * sqrt(T[i]));
+			call[i] = (S[i] * exp(-q[i] * T[i]) * cdf(myNormal, d1)) - (K[i] * exp(-r[i] * T[i]) * cdf(myNormal, d2));
+			put[i] = (K[i] * exp(-r[i] * T[i]) * cdf(myNormal, -d2)) - (S[i] * exp(-q[i] * T[i]) * cdf(myNormal, -d1));
+		}
+	}
+}
@@ -0,0 +1,36 @@
+// Group A & B: Header file for the Black-Scholes formulas as templates on the number type
+//
+// Real is double for plain pricing or AReal (Aad.h) to record the valuation for a reverse sweep. exp, log, sqrt and
+// NormalCdfExact are found by argument dependent lookup for AReal and from <cmath> and NormalCdf.h for double.
+// The formulas are those of EuroOption::EuroCallPrice and EuroOption::EuroPutPrice.
+
+#ifndef EuroFormulaHPP
+#define EuroFormulaHPP
+
+#include "NormalCdf.h"
+#include <cmath>
+
+namespace Options
+{
+	template <class Real>
+	Real EuroCallFormula(const Real& T, const Real& sig, const Real& r, const Real& q, const Real& S, const Real& K) // function to calculate the price of a European call option
+	{
+		using std::exp; using std::log; using std::sqrt;
+		Real sigSqrtT = sig * sqrt(T);
+		Real d1 = (log(S / K) + (r - q + 0.5 * sig * sig) * T) / sigSqrtT;
+		Real d2 = d1 - sigSqrtT;
+		return S * exp(-q * T) * NormalCdfExact(d1) - K * exp(-r * T) * NormalCdfExact(d2);
+	}
+
+	template <class Real>
+	Real EuroPutFormula(const Real& T, const Real& sig, const Real& r, const Real& q, const Real& S, const Real& K) // function to calculate the price of a European put option
+	{
+		using std::exp; using std::log; using std::sqrt;
+		Real sigSqrtT = sig * sqrt(T);
+		Real d1 = (log(S / K) + (r - q + 0.5 * sig * sig) * T) / sigSqrtT;
+		Real d2 = d1 - sigSqrtT;
+		return K * exp(-r * T) * NormalCdfExact(-d2) - S * exp(-q * T) * NormalCdfExact(-d1);
+	}
+}
+
+#endif
@@ -1,87 +1,201 @@
 // Group A & B: Source file for Option Pricing and Sensitivity Measurement of Plain (European) options
 
 #include "EuroOption.h"
+#include "ScenarioEngine.h"
+#include "Ladder.h"
 #include <iostream>
 #include <cmath>
 #include <boost/math/distributions/normal.hpp>
 #include <vector>
+#include <algorithm>
 using namespace std;
 using namespace boost::math;
 
 namespace Options
 {
 		EuroOption::EuroOption() : T(0.0), sig(0.0), r(0.0), S(0.0), K(0.0), q(0.0)  // default constructor
-		{}
+		{
+			Refresh(ChangedAll);
+		}
 
 		EuroOption::EuroOption(double time, double sigma, double rate, double div, double a_p, double s_p) : T(time), sig(sigma), r(rate), S(a_p), K(s_p), q(div) // parameterized constructor
-		{}
+		{
+			Refresh(ChangedAll);
+		}
 
-		EuroOption::EuroOption(const EuroOption& eop) : T(eop.T), sig(eop.sig), r(eop.r), S(eop.S), K(eop.K), q(eop.q) // copy constructor
+		EuroOption::EuroOption(const EuroOption& eop) : T(eop.T), sig(eop.sig), r(eop.r), S(eop.S), K(eop.K), q(eop.q),
+			cSqrtT(eop.cSqrtT), cSigSqrtT(eop.cSigSqrtT), cLogSK(eop.cLogSK), cExpQT(eop.cExpQT), cExpRT(eop.cExpRT),
+			cD1(eop.cD1), cD2(eop.cD2), cNd1(eop.cNd1), cNd2(eop.cNd2), cNmd1(eop.cNmd1), cNmd2(eop.cNmd2), cnd1(eop.cnd1) // copy constructor
 		{}
 
 		EuroOption::~EuroOption() // destructor
 		{}
 
+		void EuroOption::Refresh(unsigned changed) // function to recompute only the cached terms that depend on the changed fields
+		{
+			if (changed & ChangedT)
+			{
+				cSqrtT = sqrt(T);
+			}
+			if (changed & (ChangedT | ChangedSig))
+			{
+				cSigSqrtT = sig * cSqrtT;
+			}
+			if (changed & (ChangedS | ChangedK))
+			{
+				cLogSK = log(S / K);
+			}
+			if (changed & (ChangedT | ChangedQ))
+			{
+				cExpQT = exp(-q * T);
+			}
+			if (changed & (ChangedT | ChangedR))
+			{
+				cExpRT = exp(-r * T);
+			}
+
+			// d1 depends on every field, so it and the normal terms built on it follow any change
+			normal_distribution<> myNormal(0, 1);
+			cD1 = (cLogSK + (r - q + ((sig * sig) / 2)) * T) / cSigSqrtT;
+			cD2 = cD1 - cSigSqrtT;
+			bool defined = (cD1 == cD1); // NaN until the option has a maturity and a volatility
+			cNd1 = defined ? cdf(myNormal, cD1) : cD1;
+			cNd2 = defined ? cdf(myNormal, cD2) : cD2;
+			cNmd1 = defined ? NormalCdfExact(-cD1) : cD1; // N(-d) from erfc for the put side, 1 - N(d) would cancel deep out of the money
+			cNmd2 = defined ? NormalCdfExact(-cD2) : cD2;
+			cnd1 = defined ? pdf(myNormal, cD1) : cD1;
+		}
+
 		double EuroOption::d1() const // function to calculate d1
 		{
-			double d1 = (log(S / K) + (r - q + ((sig * sig) / 2)) * T) / (sig * sqrt(T));
-			return d1;
+			return cD1;
 		}
 
 		double EuroOption::d2() const // function to calculate d2
 		{
-			double d2 = d1() - (sig * sqrt(T));
-			return d2;
+			return cD2;
 		}
 
 		double EuroOption::EuroCallPrice() const // function to calculate price of European Call Option
 		{
-			normal_distribution<> myNormal(0, 1);
-			double C = (S * exp(-q * T) * cdf(myNormal, d1())) - (K * exp(-r * T) * cdf(myNormal, d2()));
+			double C = (S * cExpQT * cNd1) - (K * cExpRT * cNd2);
 			return C;
 		}
 
 		double EuroOption::EuroPutPrice() const // function to calculate price of European Put Option
 		{
-			normal_distribution<> myNormal(0, 1);
-			double P = (K * exp(-r * T) * cdf(myNormal, -d2())) - (S * exp(-q * T) * cdf(myNormal, -d1()));
+			double P = (K * cExpRT * cNmd2) - (S * cExpQT * cNmd1);
 			return P;
 		}
 
-		double EuroOption::EuroCallPrice(double underlying) // function to calculate price of European Call Option, with dependancy on change of underlying price
+		double EuroOption::EuroCallPrice(double underlying) const // function to calculate price of European Call Option, with dependancy on change of underlying price (the option itself is not changed)
+		{
+			EuroParams p = Params();
+			p.S = underlying;
+			return EuroCallPrice(p);
+		}
+
+		double EuroOption::EuroPutPrice(double underlying) const // function to calculate price of European Put Option, with dependancy on change of underlying price (the option itself is not changed)
+		{
+			EuroParams p = Params();
+			p.S = underlying;
+			return EuroPutPrice(p);
+		}
+
+		// Pure functions of explicitly passed terms, no member of EuroOption is read or written
+
+		EuroParams EuroOption::Params() const // function to return the terms of this option, to be bumped by the caller
+		{
+			EuroParams p = { T, sig, r, q, S, K };
+			return p;
+		}
+
+		double EuroOption::d1(const EuroParams& p) // function to calculate d1 of the given terms
+		{
+			double d1 = (log(p.S / p.K) + (p.r - p.q + ((p.sig * p.sig) / 2)) * p.T) / (p.sig * sqrt(p.T));
+			return d1;
+		}
+
+		double EuroOption::d2(const EuroParams& p) // function to calculate d2 of the given terms
+		{
+			double d2 = d1(p) - (p.sig * sqrt(p.T));
+			return d2;
+		}
+
+		double EuroOption::EuroCallPrice(const EuroParams& p) // function to calculate price of European Call Option with the given terms
 		{
-			S = underlying;
 			normal_distribution<> myNormal(0, 1);
-			double C = (S * exp(-q * T) * cdf(myNormal, d1())) - (K * exp(-r * T) * cdf(myNormal, d2()));
+			double C = (p.S * exp(-p.q * p.T) * cdf(myNormal, d1(p))) - (p.K * exp(-p.r * p.T) * cdf(myNormal, d2(p)));
 			return C;
 		}
 
-		double EuroOption::EuroPutPrice(double underlying) // function to calculate price of European Put Option, with dependancy on change of underlying price
+		double EuroOption::EuroPutPrice(const EuroParams& p) // function to calculate price of European Put Option with the given terms
 		{
-			S = underlying;
 			normal_distribution<> myNormal(0, 1);
-			double P = (K * exp(-r * T) * cdf(myNormal, -d2())) - (S * exp(-q * T) * cdf(myNormal, -d1()));
+			double P = (p.K * exp(-p.r * p.T) * cdf(myNormal, -d2(p))) - (p.S * exp(-p.q * p.T) * cdf(myNormal, -d1(p)));
 			return P;
 		}
 
+		double EuroOption::CallDelta(const EuroParams& p) // function to calculate delta of plain european call option with the given terms
+		{
+			normal_distribution<> myNormal(0, 1);
+			double delta = exp(-p.q * p.T) * cdf(myNormal, d1(p));
+			return delta;
+		}
+
+		double EuroOption::PutDelta(const EuroParams& p) // function to calculate delta of plain european put option with the given terms
+		{
+			normal_distribution<> myNormal(0, 1);
+			double delta = exp(-p.q * p.T) * (cdf(myNormal, d1(p)) - 1);
+			return delta;
+		}
+
+		double EuroOption::Gamma(const EuroParams& p) // function to calculate gamma of put and call options with the given terms
+		{
+			normal_distribution<> myNormal(0, 1);
+			double gamma = ((exp(-p.q * p.T)) / (p.S * p.sig * sqrt(p.T))) * pdf(myNormal, d1(p));
+			return gamma;
+		}
+
+		double EuroOption::Vega(const EuroParams& p) // function to calculate vega of put and call option with the given terms
+		{
+			normal_distribution<> myNormal(0, 1);
+			double vega = p.S * (exp(-p.q * p.T)) * sqrt(p.T) * pdf(myNormal, d1(p));
+			return vega;
+		}
+
+		double EuroOption::CallTheta(const EuroParams& p) // function to calculate theta of plain european call option with the given terms
+		{
+			normal_distribution<> myNormal(0, 1);
+			double theta = -((p.S * p.sig * exp(-p.q * p.T)) / (2 * sqrt(p.T))) * pdf(myNormal, d1(p)) - (p.r * p.K * exp(-p.r * p.T) * cdf(myNormal, d2(p))) + (p.q * p.S * exp(-p.q * p.T) * cdf(myNormal, d1(p)));
+			return theta;
+		}
+
+		double EuroOption::PutTheta(const EuroParams& p) // function to calculate theta of plain european put option with the given terms
+		{
+			normal_distribution<> myNormal(0, 1);
+			double theta = -((p.S * p.sig * exp(-p.q * p.T)) / (2 * sqrt(p.T))) * pdf(myNormal, d1(p)) + (p.r * p.K * exp(-p.r * p.T) * cdf(myNormal, -d2(p))) - (p.q * p.S * exp(-p.q * p.T) * cdf(myNormal, -d1(p)));
+			return theta;
+		}
+
 		double EuroOption::CallParityPrice() const // function to return back call price derived from Put-Call Parity expression
 		{
-			double C_P = EuroPutPrice() + S - (K * exp(-r * T));
+			double C_P = EuroPutPrice() + (S * cExpQT) - (K * cExpRT);
 			return C_P;
 		}
 
 		double EuroOption::PutParityPrice() const //  function to return back put price derived from Put-Call Parity expression
 		{
-			double P_P = EuroCallPrice() + (K * exp(-r * T)) - S;
+			double P_P = EuroCallPrice() + (K * cExpRT) - (S * cExpQT);
 			return P_P;
 		}
 
 		void EuroOption::ParityCheck() const // function to check if a set of call and put option prices validate the Put-Call Parity
 		{
-			double LHS = EuroCallPrice() + (K * exp(-r * T));
-			double RHS = EuroPutPrice() + S;
+			double LHS = EuroCallPrice() + (K * cExpRT);
+			double RHS = EuroPutPrice() + (S * cExpQT);
 
-			if (LHS = RHS)
+			if (fabs(LHS - RHS) <= 1e-10 * max(1.0, fabs(RHS))) // equal up to rounding
 			{
 				cout << "Put-Call Parity stands Validated" << endl;
 			}
@@ -96,41 +210,42 @@ namespace Options
 		void EuroOption::SetTime(double time)
 		{
 			T = time;
+			Refresh(ChangedT);
 		}
 
 		void EuroOption::SetVolatility(double vol)
 		{
 			sig = vol;
+			Refresh(ChangedSig);
 		}
 
 		void EuroOption::SetRate(double rate)
 		{
 			r = rate;
+			Refresh(ChangedR);
 		}
 		void EuroOption::SetUnderlying(double underlying)
 		{
 			S = underlying;
+			Refresh(ChangedS);
 		}
 		void EuroOption::SetStrike(double strike)
 		{
 			K = strike;
+			Refresh(ChangedK);
 		}
 		void EuroOption::SetDividend(double div)
 		{
 			q = div;
+			Refresh(ChangedQ);
 		}
 
 		// Global function to create a vector of doubles separated by size h
 		vector<double> EuroOption::FactorCNG(double start, double end, double h)
 		{
-			// Create an empty vector to store the factor values
-			vector<double> factor;
-
-			// Loop from start to end with increment h, and add each value to the factor vector
-			for (double i = start; i <= end; i += h)
-			{
-				factor.push_back(i);
-			}
+			// The number of values is fixed up front and value i is start + i * h, so rounding cannot add or drop a value
+			vector<double> factor(LadderPoints(start, end, h));
+			FillLadder(start, h, factor.size(), factor.data());
 
 			// Return the completed factor vector
 			return factor;
@@ -142,199 +257,324 @@ namespace Options
 			// Create a vector of factor values using the FactorCNG function
 			vector<double> F = FactorCNG(start, end, h);
 
-			// Create empty vectors to store the call and put prices
-			vector<double> CallVector;
-			vector<double> PutVector;
-
-			// Loop through the factor vector, and for each value, calculate the call and put prices
-			for (auto it = F.begin(); it != F.end(); it += h)
-			{
-				// Calculate the call price using the EuroCallPrice function
-				CallVector.push_back(EuroCallPrice(*it));
-
-				// Calculate the put price using the EuroPutPrice function
-				PutVector.push_back(EuroPutPrice(*it));
-			}
+			// Price the whole ladder of underlying prices in one pass
+			vector<double> CallVector(F.size());
+			vector<double> PutVector(F.size());
+			SpotLadder(F.data(), F.size(), CallVector.data(), PutVector.data());
 
 			// Print the header for the output table
 			cout << setw(15) << "Underlying Price" << setw(15) << "Call Price" << setw(15) << "Put Price" << endl;
 
 			// Loop through the factor vector and print the underlying price, call price, and put price for each scenario
-			for (int i = 0; i < F.size(); ++i)
+			for (size_t i = 0; i < F.size(); ++i)
 			{
 				cout << setw(15) << F[i] << setw(15) << CallVector[i] << setw(15) << PutVector[i] << endl;
 			}
 		}
 
-		// Function to create and print a vector of changed option prices, having changing multiple factors affecting option pricing
-		void EuroOption::MultiFactorPricer(vector<vector<double>> multiFactor)
+		const size_t LadderBlock = 64; // ladder points per block, so the scratch arrays of the ladders stay in L1 cache
+
+		// Last stage shared by the price ladders: N(d1), N(d2), N(-d1), N(-d2) and the prices of one block
+		static void LadderPrices(const double* d1, const double* d2, const double* fwdS, const double* disK, size_t m, double* call, double* put, CdfTier tier)
 		{
-			// Create empty vectors to store the call and put prices for each scenario
-			vector<double> callValues;
-			vector<double> putValues;
+			double Nd1[LadderBlock], Nd2[LadderBlock], Nmd1[LadderBlock], Nmd2[LadderBlock];
+			NormalCdfBatch(d1, Nd1, Nmd1, m, tier);
+			NormalCdfBatch(d2, Nd2, Nmd2, m, tier);
 
-			// Print the header for the output table
-			cout << setw(10) << "Time" << setw(10) << "Strike" << setw(15) << "Volatility" << setw(10) << "Rate" << setw(15) << "Underlying" << setw(10) << "Dividend" << setw(15) << "Call Price" << setw(15) << "Put Price" << endl;
+			BATCH_LOOP
+			for (size_t i = 0; i < m; ++i)
+			{
+				call[i] = (fwdS[i] * Nd1[i]) - (disK[i] * Nd2[i]);
+				put[i] = (disK[i] * Nmd2[i]) - (fwdS[i] * Nmd1[i]);
+			}
+		}
+
+		void EuroOption::SpotLadder(const double* spot, size_t n, double* call, double* put, CdfTier tier) const // function to price call and put over a ladder of underlying prices
+		{
+			// Per-ladder constants: only log(S) and the normal cdf change along the ladder
+			double sigSqrtT = sig * sqrt(T);
+			double shift = ((r - q + ((sig * sig) / 2)) * T - log(K)) / sigSqrtT;
+			double expQT = exp(-q * T);
+			double disKT = K * exp(-r * T);
+
+			double d1[LadderBlock], d2[LadderBlock], fwdS[LadderBlock], disK[LadderBlock];
+			for (size_t start = 0; start < n; start += LadderBlock)
+			{
+				size_t m = min(LadderBlock, n - start);
+
+				BATCH_LOOP
+				for (size_t i = 0; i < m; ++i)
+				{
+					d1[i] = log(spot[start + i]) / sigSqrtT + shift;
+					d2[i] = d1[i] - sigSqrtT;
+					fwdS[i] = spot[start + i] * expQT;
+					disK[i] = disKT;
+				}
+
+				LadderPrices(d1, d2, fwdS, disK, m, call + start, put + start, tier);
+			}
+		}
+
+		void EuroOption::SpotDeltaLadder(const double* spot, size_t n, double* callDelta, double* putDelta, CdfTier tier) const // function to calculate call and put deltas over a ladder of underlying prices
+		{
+			double sigSqrtT = sig * sqrt(T);
+			double shift = ((r - q + ((sig * sig) / 2)) * T - log(K)) / sigSqrtT;
+			double expQT = exp(-q * T);
+
+			double d1[LadderBlock], Nd1[LadderBlock], Nmd1[LadderBlock];
+			for (size_t start = 0; start < n; start += LadderBlock)
+			{
+				size_t m = min(LadderBlock, n - start);
+
+				BATCH_LOOP
+				for (size_t i = 0; i < m; ++i)
+				{
+					d1[i] = log(spot[start + i]) / sigSqrtT + shift;
+				}
+
+				NormalCdfBatch(d1, Nd1, Nmd1, m, tier);
+
+				BATCH_LOOP
+				for (size_t i = 0; i < m; ++i)
+				{
+					callDelta[start + i] = expQT * Nd1[i];
+					putDelta[start + i] = -expQT * Nmd1[i];
+				}
+			}
+		}
+
+		void EuroOption::VolLadder(const double* vol, size_t n, double* call, double* put, CdfTier tier) const // function to price call and put over a ladder of volatilities
+		{
+			// Per-ladder constants: the discount factors and the log-moneyness do not depend on the volatility
+			double sqrtT = sqrt(T);
+			double moneyness = log(S / K) + (r - q) * T;
+			double fwdST = S * exp(-q * T);
+			double disKT = K * exp(-r * T);
+
+			double d1[LadderBlock], d2[LadderBlock], fwdS[LadderBlock], disK[LadderBlock];
+			for (size_t start = 0; start < n; start += LadderBlock)
+			{
+				size_t m = min(LadderBlock, n - start);
+
+				BATCH_LOOP
+				for (size_t i = 0; i < m; ++i)
+				{
+					double w = vol[start + i] * sqrtT;
+					d1[i] = moneyness / w + 0.5 * w;
+					d2[i] = d1[i] - w;
+					fwdS[i] = fwdST;
+					disK[i] = disKT;
+				}
+
+				LadderPrices(d1, d2, fwdS, disK, m, call + start, put + start, tier);
+			}
+		}
+
+		void EuroOption::RateLadder(const double* rate, size_t n, double* call, double* put, CdfTier tier) const // function to price call and put over a ladder of rates
+		{
+			// Per-ladder constants: only the drift and the discounted strike depend on the rate
+			double sigSqrtT = sig * sqrt(T);
+			double shift = (log(S / K) + (((sig * sig) / 2) - q) * T) / sigSqrtT;
+			double fwdST = S * exp(-q * T);
 
-			// Loop through the multi-factor scenarios
+			double d1[LadderBlock], d2[LadderBlock], fwdS[LadderBlock], disK[LadderBlock];
+			for (size_t start = 0; start < n; start += LadderBlock)
+			{
+				size_t m = min(LadderBlock, n - start);
+
+				BATCH_LOOP
+				for (size_t i = 0; i < m; ++i)
+				{
+					d1[i] = shift + rate[start + i] * T / sigSqrtT;
+					d2[i] = d1[i] - sigSqrtT;
+					fwdS[i] = fwdST;
+					disK[i] = K * exp(-rate[start + i] * T);
+				}
+
+				LadderPrices(d1, d2, fwdS, disK, m, call + start, put + start, tier);
+			}
+		}
+
+		// Function to create and print a vector of changed option prices, having changing multiple factors affecting option pricing
+		void EuroOption::MultiFactorPricer(const vector<vector<double>>& multiFactor) const
+		{
+			// Flatten the scenarios into the row-major matrix read by the scenario engine
+			vector<double> flat;
+			flat.reserve(multiFactor.size() * ScColumns);
 			for (auto it = multiFactor.begin(); it != multiFactor.end(); ++it)
 			{
-				// Set the parameters for the current scenario
-				SetTime(it->at(0));
-				SetStrike(it->at(1));
-				SetVolatility(it->at(2));
-				SetRate(it->at(3));
-				SetUnderlying(it->at(4));
-				SetDividend(it->at(5));
-
-				// Price the European call and put options using the EuroCallPrice and EuroPutPrice functions
-				double callPrice = EuroCallPrice();
-				double putPrice = EuroPutPrice();
-
-				// Print the scenario parameters and option prices
-				cout << setw(10) << it->at(0) << setw(10) << it->at(1) << setw(15) << it->at(2) << setw(10) << it->at(3) << setw(15) << it->at(4) << setw(10) << it->at(5) << setw(15) << callPrice << setw(15) << putPrice << endl;
-
-				// Add the call and put prices to the result vectors
-				callValues.push_back(callPrice);
-				putValues.push_back(putPrice);
+				for (size_t c = 0; c < ScColumns; ++c)
+				{
+					flat.push_back(it->at(c));
+				}
 			}
+
+			// Price all scenarios in parallel, then print them
+			ScenarioResults res;
+			PriceScenarios(flat.data(), multiFactor.size(), res);
+			PrintScenarioPrices(cout, flat.data(), multiFactor.size(), res);
 		}
 
 		double EuroOption::CallDelta() const // function to calculate delta of plain european call option
 		{
-			normal_distribution<> myNormal(0, 1);
-			double delta = exp(-q * T) * cdf(myNormal, d1());
+			double delta = cExpQT * cNd1;
 			return delta;
 		}
 
-		double EuroOption::CallDelta(double underlying) // function to calculate delta of plain european call option, with dependancy on changing asset price
+		double EuroOption::CallDelta(double underlying) const // function to calculate delta of plain european call option, with dependancy on changing asset price (the option itself is not changed)
 		{
-			S = underlying;
-			normal_distribution<> myNormal(0, 1);
-			double delta = exp(-q * T) * cdf(myNormal, d1());
-			return delta;
+			EuroParams p = Params();
+			p.S = underlying;
+			return CallDelta(p);
 		}
 
 		double EuroOption::PutDelta() const // function to calculate delta of plain european put option
 		{
-			normal_distribution<> myNormal(0, 1);
-			double delta = exp(-q * T) * (cdf(myNormal, d1()) - 1);
+			double delta = -cExpQT * cNmd1;
 			return delta;
 		}
 
-		double EuroOption::PutDelta(double underlying) // function to calculate delta of plain european put option, with dependancy on changing asset price
+		double EuroOption::PutDelta(double underlying) const // function to calculate delta of plain european put option, with dependancy on changing asset price (the option itself is not changed)
 		{
-			S = underlying;
-			normal_distribution<> myNormal(0, 1);
-			double delta = exp(-q * T) * (cdf(myNormal, d1()) - 1);
-			return delta;
+			EuroParams p = Params();
+			p.S = underlying;
+			return PutDelta(p);
 		}
 
 		double EuroOption::Gamma() const // function to calculate gamma of put and call options
 		{
-			normal_distribution<> myNormal(0, 1);
-			double gamma = ((exp(-q * T)) / (S * sig * sqrt(T))) * pdf(myNormal, d1());
+			double gamma = (cExpQT / (S * cSigSqrtT)) * cnd1;
 			return gamma;
 		}
 
 		double EuroOption::Vega() const // function to calculate vega of put and call option
 		{
-			normal_distribution<> myNormal(0, 1);
-			double vega = S * (exp(-q * T)) * sqrt(T) * pdf(myNormal, d1());
+			double vega = S * cExpQT * cSqrtT * cnd1;
 			return vega;
 		}
 
 		double EuroOption::CallTheta() const // function to calculate theta of plain european call option
 		{
-			normal_distribution<> myNormal(0, 1);
-			double theta = -((S * sig * exp(-q * T)) / (2 * sqrt(T))) * pdf(myNormal, d1()) - (r * K * exp(-r * T) * cdf(myNormal, d2())) + (q * S * exp(-q * T) * cdf(myNormal, d1()));
+			double theta = -((S * sig * cExpQT) / (2 * cSqrtT)) * cnd1 - (r * K * cExpRT * cNd2) + (q * S * cExpQT * cNd1);
 			return theta;
 		}
 
 		double EuroOption::PutTheta() const // function to calculate theta of plain european put option
 		{
-			normal_distribution<> myNormal(0, 1);
-			double theta = -((S * sig * exp(-q * T)) / (2 * sqrt(T))) * pdf(myNormal, d1()) + (r * K * exp(-r * T) * cdf(myNormal, -d2())) - (q * S * exp(-q * T) * cdf(myNormal, -d1()));
+			double theta = -((S * sig * cExpQT) / (2 * cSqrtT)) * cnd1 + (r * K * cExpRT * cNmd2) - (q * S * cExpQT * cNmd1);
 			return theta;
 		}
 
+		EuroGreeks EuroOption::AllGreeks() const // function to calculate prices, delta, gamma, vega, theta and rho of call and put, evaluating d1, d2, the discount factors and N(d) only once
+		{
+			// Everything comes from the cached terms
+			double fwdS = S * cExpQT; // underlying discounted at the dividend yield
+			double disK = K * cExpRT; // discounted strike
+			double decay = -(fwdS * sig * cnd1) / (2 * cSqrtT); // time decay term common to call and put theta
+
+			EuroGreeks g;
+			g.CallPrice = (fwdS * cNd1) - (disK * cNd2);
+			g.PutPrice = (disK * cNmd2) - (fwdS * cNmd1);
+			g.CallDelta = cExpQT * cNd1;
+			g.PutDelta = -cExpQT * cNmd1;
+			g.Gamma = (cExpQT * cnd1) / (S * cSigSqrtT);
+			g.Vega = fwdS * cSqrtT * cnd1;
+			g.CallTheta = decay - (r * disK * cNd2) + (q * fwdS * cNd1);
+			g.PutTheta = decay + (r * disK * cNmd2) - (q * fwdS * cNmd1);
+			g.CallRho = T * disK * cNd2;
+			g.PutRho = -T * disK * cNmd2;
+			return g;
+		}
+
+		EuroGreeks EuroOption::AllGreeks(const EuroParams& p) // function to calculate prices and first order Greeks of call and put with the given terms, evaluating d1, d2, the discount factors and N(d) only once
+		{
+			normal_distribution<> myNormal(0, 1);
+
+			// Shared intermediates, each transcendental function is evaluated once
+			double sqrtT = sqrt(p.T);
+			double sigSqrtT = p.sig * sqrtT;
+			double D1 = (log(p.S / p.K) + (p.r - p.q + ((p.sig * p.sig) / 2)) * p.T) / sigSqrtT;
+			double D2 = D1 - sigSqrtT;
+			double expQT = exp(-p.q * p.T);
+			double expRT = exp(-p.r * p.T);
+			double Nd1 = cdf(myNormal, D1);
+			double Nd2 = cdf(myNormal, D2);
+			double Nmd1 = NormalCdfExact(-D1); // N(-d1) from erfc, not 1 - N(d1) which cancels for deep out of the money puts
+			double Nmd2 = NormalCdfExact(-D2); // N(-d2)
+			double nd1 = pdf(myNormal, D1);
+
+			double fwdS = p.S * expQT; // underlying discounted at the dividend yield
+			double disK = p.K * expRT; // discounted strike
+			double decay = -(fwdS * p.sig * nd1) / (2 * sqrtT); // time decay term common to call and put theta
+
+			EuroGreeks g;
+			g.CallPrice = (fwdS * Nd1) - (disK * Nd2);
+			g.PutPrice = (disK * Nmd2) - (fwdS * Nmd1);
+			g.CallDelta = expQT * Nd1;
+			g.PutDelta = -expQT * Nmd1;
+			g.Gamma = (expQT * nd1) / (p.S * sigSqrtT);
+			g.Vega = fwdS * sqrtT * nd1;
+			g.CallTheta = decay - (p.r * disK * Nd2) + (p.q * fwdS * Nd1);
+			g.PutTheta = decay + (p.r * disK * Nmd2) - (p.q * fwdS * Nmd1);
+			g.CallRho = p.T * disK * Nd2;
+			g.PutRho = -p.T * disK * Nmd2;
+			return g;
+		}
+
 		// Function to create and print a vector of changed option deltas, having changed asset price
 		void EuroOption::SingleFactorGreek(double start, double end, double h)
 		{
 			// Create a vector of factor values using the FactorCNG function
 			vector<double> F = FactorCNG(start, end, h);
 
-			// Create empty vectors to store the call and put deltas
-			vector<double> CallDelVector;
-			vector<double> PutDelVector;
-
-			// Loop through the factor vector, and for each value, calculate the call and put deltas
-			for (auto it = F.begin(); it != F.end(); it += h)
-			{
-				// Calculate the call delta using the CallDelta function
-				CallDelVector.push_back(CallDelta(*it));
-
-				// Calculate the put delta using the PutDelta function
-				PutDelVector.push_back(PutDelta(*it));
-			}
+			// Calculate the call and put deltas of the whole ladder in one pass
+			vector<double> CallDelVector(F.size());
+			vector<double> PutDelVector(F.size());
+			SpotDeltaLadder(F.data(), F.size(), CallDelVector.data(), PutDelVector.data());
 
 			// Print the header for the output table
 			cout << setw(15) << "Underlying Price" << setw(15) << "Call Delta" << setw(15) << "Put Delta" << endl;
 
 			// Loop through the factor vector and print the underlying price, call delta, and put delta for each scenario
-			for (int i = 0; i < F.size(); ++i)
+			for (size_t i = 0; i < F.size(); ++i)
 			{
 				cout << setw(15) << F[i] << setw(15) << CallDelVector[i] << setw(15) << PutDelVector[i] << endl;
 			}
 		}
 
 		// Function to create and print a vector of changed option deltas, having changing multiple factors affecting option pricing
-		void EuroOption::MultiFactorGreek(vector<vector<double>> multiFactor)
+		void EuroOption::MultiFactorGreek(const vector<vector<double>>& multiFactor) const
 		{
-			// Create empty vectors to store the call and put deltas for each scenario
-			vector<double> calldelValues;
-			vector<double> putdelValues;
-
-			// Print the header for the output table
-			cout << setw(10) << "Time" << setw(10) << "Strike" << setw(15) << "Volatility" << setw(10) << "Rate" << setw(15) << "Underlying" << setw(10) << "Dividend" << setw(15) << "Call Delta" << setw(15) << "Put Delta" << endl;
-
-			// Loop through the multi-factor scenarios
+			// Flatten the scenarios into the row-major matrix read by the scenario engine
+			vector<double> flat;
+			flat.reserve(multiFactor.size() * ScColumns);
 			for (auto it = multiFactor.begin(); it != multiFactor.end(); ++it)
 			{
-				// Set the parameters for the current scenario
-				SetTime(it->at(0));
-				SetStrike(it->at(1));
-				SetVolatility(it->at(2));
-				SetRate(it->at(3));
-				SetUnderlying(it->at(4));
-				SetDividend(it->at(5));
-
-				// Calculate the call and put deltas using the CallDelta and PutDelta functions
-				double calldel = CallDelta();
-				double putdel = PutDelta();
-
-				// Print the scenario parameters and option deltas
-				cout << setw(10) << it->at(0) << setw(10) << it->at(1) << setw(15) << it->at(2) << setw(10) << it->at(3) << setw(15) << it->at(4) << setw(10) << it->at(5) << setw(15) << calldel << setw(15) << putdel << endl;
-
-				// Add the call and put deltas to the result vectors
-				calldelValues.push_back(calldel);
-				putdelValues.push_back(putdel);
+				for (size_t c = 0; c < ScColumns; ++c)
+				{
+					flat.push_back(it->at(c));
+				}
 			}
+
+			// Price all scenarios in parallel, then print them
+			ScenarioResults res;
+			PriceScenarios(flat.data(), multiFactor.size(), res);
+			PrintScenarioDeltas(cout, flat.data(), multiFactor.size(), res);
 		}
 		
-		double EuroOption::CallDeltaApx(double S, double h) // function to calculate delta of call option using taylor's approximation
+		double EuroOption::CallDeltaApx(double S, double h) const // function to calculate delta of call option using taylor's approximation
 		{
 			double a_delta = (EuroCallPrice(S + h) - EuroCallPrice(S - h)) / (2 * h);
 			return a_delta;
 		}
 
-		double EuroOption::PutDeltaApx(double S, double h) // function to calculate delta of put option using taylor's approximation
+		double EuroOption::PutDeltaApx(double S, double h) const // function to calculate delta of put option using taylor's approximation
 		{
 			double a_delta = (EuroPutPrice(S + h) - EuroPutPrice(S - h)) / (2 * h);
 			return a_delta;
 		}
 
-		double EuroOption::GammaApx(double S, double h) // function to calculate gamma using taylor's approximation
+		double EuroOption::GammaApx(double S, double h) const // function to calculate gamma using taylor's approximation
 		{
 			double a_gamma = (EuroCallPrice(S + h) - (2 * EuroCallPrice(S)) + EuroCallPrice(S - h)) / (2 * h);
 			return a_gamma;
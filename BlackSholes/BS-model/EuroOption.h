@@ -6,12 +6,35 @@
 #include <iostream>
 #include <cmath>
 #include <boost/math/distributions/normal.hpp>
+#include "NormalCdf.h"
 #include <vector>
 using namespace std;
 using namespace boost::math;
 
 namespace Options
 {
+		// Price and first order sensitivities of a call and a put on the same contract, filled by EuroOption::AllGreeks
+		struct EuroGreeks
+		{
+			double CallPrice, PutPrice;
+			double CallDelta, PutDelta;
+			double Gamma, Vega; // same for call and put
+			double CallTheta, PutTheta;
+			double CallRho, PutRho;
+		};
+
+		// Contract terms passed explicitly to the static pricing functions, in the order of the EuroOption constructor.
+		// Take a copy with EuroOption::Params(), bump the copy and price it: the shared EuroOption is never written to.
+		struct EuroParams
+		{
+			double T; // time
+			double sig; // volatility
+			double r; // rate
+			double q; // dividend
+			double S; // Underlying Price
+			double K; // Strike Price
+		};
+
 		class EuroOption
 		{
 		private:
@@ -22,6 +45,13 @@ namespace Options
 			double K; // Strike Price
 			double q; // dividend
 
+			// Terms cached from the fields above. Only the constructors and setters write them, through Refresh(), so the
+			// const functions still only read the object and stay safe to call from several threads
+			enum Changed { ChangedT = 1, ChangedSig = 2, ChangedR = 4, ChangedQ = 8, ChangedS = 16, ChangedK = 32, ChangedAll = 63 };
+			double cSqrtT, cSigSqrtT, cLogSK, cExpQT, cExpRT; // sqrt(T), sig * sqrt(T), log(S / K), exp(-q * T) and exp(-r * T)
+			double cD1, cD2, cNd1, cNd2, cNmd1, cNmd2, cnd1; // d1, d2, N(d1), N(d2), N(-d1), N(-d2) and n(d1)
+			void Refresh(unsigned changed); // function to recompute only the cached terms that depend on the changed fields
+
 		public:
 			EuroOption(); // default constructor
 			EuroOption(double time, double sigma, double rate, double div, double a_p, double s_p); // parameterized constructor
@@ -32,10 +62,25 @@ namespace Options
 			double d2() const; // function to calculate d2
 			double EuroCallPrice() const; // function to calculate price of European Call Option
 			double EuroPutPrice() const; // function to calculate price of European Put Option
-			double EuroCallPrice(double underlying); // function to calculate price of European Call Option, with dependancy on change of underlying price
-			double EuroPutPrice(double underlying); // function to calculate price of European Put Option, with dependancy on change of underlying price
+			double EuroCallPrice(double underlying) const; // function to calculate price of European Call Option, with dependancy on change of underlying price (the option itself is not changed)
+			double EuroPutPrice(double underlying) const; // function to calculate price of European Put Option, with dependancy on change of underlying price (the option itself is not changed)
+
+			// Pure functions of explicitly passed terms. They neither read nor write an EuroOption, so one instrument can be
+			// priced and bumped from any number of threads without locks or copies; nothing is allocated.
+			EuroParams Params() const; // function to return the terms of this option, to be bumped by the caller
+			static double d1(const EuroParams& p); // function to calculate d1 of the given terms
+			static double d2(const EuroParams& p); // function to calculate d2 of the given terms
+			static double EuroCallPrice(const EuroParams& p); // function to calculate price of European Call Option with the given terms
+			static double EuroPutPrice(const EuroParams& p); // function to calculate price of European Put Option with the given terms
+			static double CallDelta(const EuroParams& p); // function to calculate delta of plain european call option with the given terms
+			static double PutDelta(const EuroParams& p); // function to calculate delta of plain european put option with the given terms
+			static double Gamma(const EuroParams& p); // function to calculate gamma of put and call options with the given terms
+			static double Vega(const EuroParams& p); // function to calculate vega of put and call option with the given terms
+			static double CallTheta(const EuroParams& p); // function to calculate theta of plain european call option with the given terms
+			static double PutTheta(const EuroParams& p); // function to calculate theta of plain european put option with the given terms
+			static EuroGreeks AllGreeks(const EuroParams& p); // function to calculate prices and first order Greeks of call and put with the given terms
 
-			// Setter Functions for parameters affecting option price
+			// Setter Functions modify the option and must not be called while other threads price it
 			void SetTime(double time); 
 			void SetVolatility(double vol);
 			void SetRate(double rate);
@@ -49,24 +94,33 @@ namespace Options
 
 			vector<double> FactorCNG(double start, double end, double h); // global function to create a vector of doubles seperated by size h
 
+			// Ladders: one factor takes the n values of a caller owned array (see Ladder.h) while the other terms stay at this
+			// option's values. Terms that do not depend on the factor are computed once per ladder, results go into caller owned
+			// arrays of length n and nothing is allocated.
+			void SpotLadder(const double* spot, size_t n, double* call, double* put, CdfTier tier = CdfExact) const; // function to price call and put over a ladder of underlying prices
+			void SpotDeltaLadder(const double* spot, size_t n, double* callDelta, double* putDelta, CdfTier tier = CdfExact) const; // function to calculate call and put deltas over a ladder of underlying prices
+			void VolLadder(const double* vol, size_t n, double* call, double* put, CdfTier tier = CdfExact) const; // function to price call and put over a ladder of volatilities
+			void RateLadder(const double* rate, size_t n, double* call, double* put, CdfTier tier = CdfExact) const; // function to price call and put over a ladder of rates
+
 			void SingleFactorPricer(double start, double end, double h); // function to create and print a vector of changed option prices, having changed asset price
-			void MultiFactorPricer(vector<vector<double>> multiFactor); // function to create anf print a vector of changed option prices, having changing multiple factors affecting option pricing
+			void MultiFactorPricer(const vector<vector<double>>& multiFactor) const; // function to create anf print a vector of changed option prices, having changing multiple factors affecting option pricing (see ScenarioEngine.h for large runs)
 
 			double CallDelta() const; // function to calculate delta of plain european call option
-			double CallDelta(double underlying); // function to calculate delta of plain european call option, with dependancy on changing asset price
+			double CallDelta(double underlying) const; // function to calculate delta of plain european call option, with dependancy on changing asset price
 			double PutDelta() const; // function to calculate delta of plain european put option
-			double PutDelta(double underlying); // function to calculate delta of plain european put option, with dependancy on changing asset price
+			double PutDelta(double underlying) const; // function to calculate delta of plain european put option, with dependancy on changing asset price
 			double Gamma() const; // function to calculate gamma of put and call options
 			double Vega() const; // function to calculate vega of put and call option
 			double CallTheta() const; // function to calculate theta of plain european call option
 			double PutTheta() const; // function to calculate theta of plain european put option
+			EuroGreeks AllGreeks() const; // function to calculate prices, delta, gamma, vega, theta and rho of call and put, evaluating d1, d2, the discount factors and N(d) only once
 
 			void SingleFactorGreek(double start, double end, double h); // function to create and print a vector of changed option deltas, having changed asset price
-			void MultiFactorGreek(vector<vector<double>> multiFactor); // function to create anf print a vector of changed option deltas, having changing multiple factors affecting option pricing
+			void MultiFactorGreek(const vector<vector<double>>& multiFactor) const; // function to create anf print a vector of changed option deltas, having changing multiple factors affecting option pricing (see ScenarioEngine.h for large runs)
 
-			double CallDeltaApx(double S, double h); // function to calculate delta of call option using taylor's approximation
-			double PutDeltaApx(double S, double h); // function to calculate delta of put option using taylor's approximation
-			double GammaApx(double S, double h); // function to calculate gamma using taylor's approximation
+			double CallDeltaApx(double S, double h) const; // function to calculate delta of call option using taylor's approximation
+			double PutDeltaApx(double S, double h) const; // function to calculate delta of put option using taylor's approximation
+			double GammaApx(double S, double h) const; // function to calculate gamma using taylor's approximation
 			void SingleFactorApproximation(double start, double end, double h); // function to create and print a vector of changed option deltas approximations, having changed asset price
 		};
 }
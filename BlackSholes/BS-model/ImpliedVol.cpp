@@ -0,0 +1,110 @@
+// Group A & B: Source file for batch implied volatility of Plain (European) options
+
+#include "ImpliedVol.h"
+#include <cmath>
+#include <algorithm>
+#include <limits>
+using namespace std;
+
+namespace Options
+{
+	const size_t IvBlock = 64; // quotes per block, iterated in lockstep so the scratch arrays below stay in L1 cache
+	const double IvMinVol = 1e-6; // iterates are kept inside [IvMinVol, IvMaxVol] so a large step cannot leave the domain
+	const double IvMaxVol = 10.0;
+	const double Pi = 3.14159265358979323846;
+
+	// Function to back out the implied volatility of n quoted European options
+	void EuroBatchImpliedVol(const double* price, const int* type, const double* T, const double* r, const double* q, const double* S, const double* K, double* vol, ImpliedVolStatus* status, size_t n, double tol, int maxIter, CdfTier tier)
+	{
+		double target[IvBlock], phi[IvBlock], fwdS[IvBlock], disK[IvBlock], logFwd[IvBlock], sqrtT[IvBlock], sigma[IvBlock];
+		double d1[IvBlock], d2[IvBlock], e1[IvBlock], e2[IvBlock], Ne1[IvBlock], Ne2[IvBlock], nd1[IvBlock];
+		int live[IvBlock]; // 1 while the quote is still iterating
+
+		for (size_t start = 0; start < n; start += IvBlock)
+		{
+			size_t m = min(IvBlock, n - start);
+
+			// Stage 1: the arbitrage bounds are checked and the rational initial guess of Corrado and Miller (1996) is formed.
+			// Puts are iterated on their own price rather than mapped to calls, parity would cancel digits for in the money calls
+			BATCH_LOOP
+			for (size_t i = 0; i < m; ++i)
+			{
+				size_t j = start + i;
+				fwdS[i] = S[j] * NormalExp(-q[j] * T[j]);
+				disK[i] = K[j] * NormalExp(-r[j] * T[j]);
+				logFwd[i] = NormalLog(fwdS[i] / disK[i]);
+				sqrtT[i] = sqrt(T[j]);
+				phi[i] = (type[j] == 1) ? 1.0 : -1.0;
+
+				double intrinsic = max(phi[i] * (fwdS[i] - disK[i]), 0.0);
+				double upper = (type[j] == 1) ? fwdS[i] : disK[i];
+				target[i] = price[j];
+				status[j] = (price[j] <= intrinsic) ? IvBelowIntrinsic : ((price[j] >= upper) ? IvAboveUpperBound : IvNotConverged);
+				live[i] = (status[j] == IvNotConverged) ? 1 : 0;
+
+				double c = (type[j] == 1) ? price[j] : price[j] + fwdS[i] - disK[i]; // the guess is written for calls
+				double half = c - 0.5 * (fwdS[i] - disK[i]);
+				double disc = max(half * half - (fwdS[i] - disK[i]) * (fwdS[i] - disK[i]) / Pi, 0.0);
+				double totalVol = sqrt(2 * Pi) / (fwdS[i] + disK[i]) * (half + sqrt(disc)); // guess of sig * sqrt(T)
+				sigma[i] = min(max(totalVol / sqrtT[i], 0.01), 2.0);
+			}
+
+			// Stage 2: Halley iterations in lockstep over the block, stopping once every quote has converged
+			for (int it = 0; it < maxIter; ++it)
+			{
+				BATCH_LOOP
+				for (size_t i = 0; i < m; ++i)
+				{
+					double w = sigma[i] * sqrtT[i];
+					d1[i] = (logFwd[i] + 0.5 * w * w) / w;
+					d2[i] = d1[i] - w;
+					e1[i] = phi[i] * d1[i]; // N(phi * d) gives the call (phi = 1) or the put (phi = -1) terms
+					e2[i] = phi[i] * d2[i];
+				}
+
+				NormalCdfBatch(e1, Ne1, m, tier);
+				NormalCdfBatch(e2, Ne2, m, tier);
+				NormalPdfBatch(d1, nd1, m);
+
+				// Price and vega share d1, d2, N(d) and n(d1) exactly as in EuroBatchGreeks, volga follows from vega * d1 * d2 / sig.
+				// The iteration runs on log(price) - log(quote): deep out of the money prices are close to exp(-1/sig^2) and a
+				// plain price objective then converges very slowly
+				int active = 0;
+				BATCH_LOOP
+				for (size_t i = 0; i < m; ++i)
+				{
+					double P = max(phi[i] * ((fwdS[i] * Ne1[i]) - (disK[i] * Ne2[i])), 1e-300);
+					double vega = max(fwdS[i] * sqrtT[i] * nd1[i], 1e-300);
+					double newton = NormalLog(P / target[i]) * P / vega;
+					double curvature = d1[i] * d2[i] / sigma[i] - vega / P; // g''/g' for g = log(price)
+					double denom = 1.0 - 0.5 * newton * curvature;
+					double step = (denom > 0.5) ? newton / denom : newton; // fall back to Newton when the Halley correction is unreliable
+
+					int done = (fabs(step) < tol) ? 1 : 0;
+					sigma[i] = live[i] ? min(max(sigma[i] - step, IvMinVol), IvMaxVol) : sigma[i];
+					status[start + i] = (live[i] && done) ? IvConverged : status[start + i];
+					live[i] = live[i] & (1 - done);
+				}
+
+				// Counted in a loop of its own, a running sum in the loop above keeps it from vectorising
+				for (size_t i = 0; i < m; ++i)
+				{
+					active += live[i];
+				}
+
+				if (active == 0)
+				{
+					break;
+				}
+			}
+
+			// Stage 3: quotes outside the arbitrage bounds have no implied volatility
+			BATCH_LOOP
+			for (size_t i = 0; i < m; ++i)
+			{
+				size_t j = start + i;
+				vol[j] = (status[j] == IvBelowIntrinsic || status[j] == IvAboveUpperBound) ? numeric_limits<double>::quiet_NaN() : sigma[i];
+			}
+		}
+	}
+}
@@ -0,0 +1,26 @@
+// Group A & B: Header file for batch implied volatility of Plain (European) options
+
+#ifndef ImpliedVolHPP
+#define ImpliedVolHPP
+
+#include "NormalCdf.h"
+#include <cstddef>
+
+namespace Options
+{
+	// Outcome of each quote passed to EuroBatchImpliedVol
+	enum ImpliedVolStatus
+	{
+		IvConverged = 0, // vol[i] reprices the quote, the last correction was below the tolerance
+		IvNotConverged = 1, // iteration limit reached, vol[i] holds the last iterate
+		IvBelowIntrinsic = 2, // quote at or below the discounted intrinsic value, vol[i] is NaN
+		IvAboveUpperBound = 3 // call at or above S*exp(-q*T) (put at or above K*exp(-r*T)), vol[i] is NaN
+	};
+
+	// Element i of every input array describes quote i: its price, type (1 == call, -1 == put) and the contract terms in the
+	// EuroOption order. vol[i] and status[i] are written into caller owned arrays of length n; nothing is allocated.
+	// tol is the absolute tolerance on the volatility, maxIter caps the Halley iterations of each block.
+	void EuroBatchImpliedVol(const double* price, const int* type, const double* T, const double* r, const double* q, const double* S, const double* K, double* vol, ImpliedVolStatus* status, size_t n, double tol = 1e-10, int maxIter = 16, CdfTier tier = CdfRisk); // function to back out the implied volatility of n quoted European options
+}
+
+#endif
@@ -0,0 +1,31 @@
+// Group A & B: Source file for ladders of equally spaced factor values (spot, volatility or rate)
+
+#include "Ladder.h"
+#include "NormalCdf.h"
+#include <cmath>
+using namespace std;
+
+namespace Options
+{
+	// Function to return the number of points of the ladder start, start + step, ... up to end
+	size_t LadderPoints(double start, double end, double step)
+	{
+		if (!(step > 0.0) || end < start)
+		{
+			return 0;
+		}
+
+		// The small relative allowance keeps end itself on the ladder when (end - start) / step rounds to just below an integer
+		return size_t(floor((end - start) / step * (1.0 + 1e-12))) + 1;
+	}
+
+	// Function to write the n points of a ladder into a caller owned array
+	void FillLadder(double start, double step, size_t n, double* out)
+	{
+		BATCH_LOOP
+		for (size_t i = 0; i < n; ++i)
+		{
+			out[i] = start + double(i) * step;
+		}
+	}
+}
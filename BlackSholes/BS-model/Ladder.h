@@ -0,0 +1,17 @@
+// Group A & B: Header file for ladders of equally spaced factor values (spot, volatility or rate)
+
+#ifndef LadderHPP
+#define LadderHPP
+
+#include <cstddef>
+
+namespace Options
+{
+	// A ladder is fixed by its integer number of points, value i is start + i * step. Nothing accumulates step in floating
+	// point, so the point count cannot drift and the last point does not depend on rounding.
+
+	size_t LadderPoints(double start, double end, double step); // function to return the number of points of the ladder start, start + step, ... up to end
+	void FillLadder(double start, double step, size_t n, double* out); // function to write the n points of a ladder into a caller owned array
+}
+
+#endif
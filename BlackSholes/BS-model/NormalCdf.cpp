@@ -0,0 +1,138 @@
+// Group A & B: Source file for the batch forms of the standard normal cdf and pdf
+
+#include "NormalCdf.h"
+
+namespace Options
+{
+	// Function to calculate the standard normal cdf of n values, one vectorisable loop per tier
+	void NormalCdfBatch(const double* x, double* out, size_t n, CdfTier tier)
+	{
+		switch (tier)
+		{
+		case CdfRisk:
+			BATCH_LOOP
+			for (size_t i = 0; i < n; ++i)
+			{
+				out[i] = NormalCdfRisk(x[i]);
+			}
+			break;
+
+		case CdfSweep:
+			BATCH_LOOP
+			for (size_t i = 0; i < n; ++i)
+			{
+				out[i] = NormalCdfSweep(x[i]);
+			}
+			break;
+
+		default:
+			BATCH_LOOP
+			for (size_t i = 0; i < n; ++i)
+			{
+				out[i] = NormalCdfExact(x[i]);
+			}
+			break;
+		}
+	}
+
+	// Function to calculate N(x) and N(-x) of n values from one tail evaluation each, one vectorisable loop per tier
+	void NormalCdfBatch(const double* x, double* out, double* complement, size_t n, CdfTier tier)
+	{
+		switch (tier)
+		{
+		case CdfRisk:
+			BATCH_LOOP
+			for (size_t i = 0; i < n; ++i)
+			{
+				double tail = NormalTailRisk(fabs(x[i]));
+				out[i] = x[i] > 0.0 ? 1.0 - tail : tail;
+				complement[i] = x[i] > 0.0 ? tail : 1.0 - tail;
+			}
+			break;
+
+		case CdfSweep:
+			BATCH_LOOP
+			for (size_t i = 0; i < n; ++i)
+			{
+				double tail = NormalTailSweep(fabs(x[i]));
+				out[i] = x[i] > 0.0 ? 1.0 - tail : tail;
+				complement[i] = x[i] > 0.0 ? tail : 1.0 - tail;
+			}
+			break;
+
+		default:
+			BATCH_LOOP
+			for (size_t i = 0; i < n; ++i)
+			{
+				double tail = NormalTailExact(fabs(x[i]));
+				out[i] = x[i] > 0.0 ? 1.0 - tail : tail;
+				complement[i] = x[i] > 0.0 ? tail : 1.0 - tail;
+			}
+			break;
+		}
+	}
+
+	// Function to calculate the standard normal pdf of n values, with the vectorisable NormalExp in place of exp
+	void NormalPdfBatch(const double* x, double* out, size_t n)
+	{
+		BATCH_LOOP
+		for (size_t i = 0; i < n; ++i)
+		{
+			out[i] = NormalInvSqrt2Pi * NormalExp(-0.5 * x[i] * x[i]);
+		}
+	}
+
+	// Function to calculate the standard normal cdf of n values in single precision
+	void NormalCdfBatch(const float* x, float* out, size_t n, CdfTier tier)
+	{
+		if (tier == CdfExact)
+		{
+			BATCH_LOOP
+			for (size_t i = 0; i < n; ++i)
+			{
+				out[i] = 0.5f * erfcf(-x[i] * NormalInvSqrt2Single);
+			}
+			return;
+		}
+
+		BATCH_LOOP
+		for (size_t i = 0; i < n; ++i)
+		{
+			out[i] = NormalCdfSingle(x[i]);
+		}
+	}
+
+	// Function to calculate N(x) and N(-x) of n values in single precision
+	void NormalCdfBatch(const float* x, float* out, float* complement, size_t n, CdfTier tier)
+	{
+		if (tier == CdfExact)
+		{
+			BATCH_LOOP
+			for (size_t i = 0; i < n; ++i)
+			{
+				float tail = 0.5f * erfcf(fabsf(x[i]) * NormalInvSqrt2Single);
+				out[i] = x[i] > 0.0f ? 1.0f - tail : tail;
+				complement[i] = x[i] > 0.0f ? tail : 1.0f - tail;
+			}
+			return;
+		}
+
+		BATCH_LOOP
+		for (size_t i = 0; i < n; ++i)
+		{
+			float tail = NormalTailSingle(fabsf(x[i]));
+			out[i] = x[i] > 0.0f ? 1.0f - tail : tail;
+			complement[i] = x[i] > 0.0f ? tail : 1.0f - tail;
+		}
+	}
+
+	// Function to calculate the standard normal pdf of n values in single precision
+	void NormalPdfBatch(const float* x, float* out, size_t n)
+	{
+		BATCH_LOOP
+		for (size_t i = 0; i < n; ++i)
+		{
+			out[i] = NormalPdfSingle(x[i]);
+		}
+	}
+}
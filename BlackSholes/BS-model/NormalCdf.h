@@ -0,0 +1,257 @@
+// Group A & B: Header file for the standard normal cdf and pdf with selectable accuracy tiers
+//
+// The scalar functions are inline so that the Monte Carlo and FDM projects can use them by including this header only;
+// the batch functions live in NormalCdf.cpp.
+//
+// The Risk and Sweep tiers are built from branch free arithmetic only, their exponential included (NormalExp), so their
+// batch loops can vectorise; GCC and Clang do so at -O3 (-O2 alone leaves them scalar). A call to the library exp, log or
+// erfc keeps a loop scalar, which is why the Exact tier costs what a scalar erfc costs, and so does sqrt under GCC unless
+// -fno-math-errno is given (sqrt of a negative number would have to set errno).
+
+#ifndef NormalCdfHPP
+#define NormalCdfHPP
+
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <cstdint>
+
+// Loop hint for the batch kernels: element i never depends on element j, so the compiler is free to vectorise.
+// The instruction set (SSE2, AVX2, AVX-512) is chosen by the compiler flags, e.g. /arch:AVX2 or /arch:AVX512
+#ifndef BATCH_LOOP
+#if defined(_MSC_VER)
+#define BATCH_LOOP __pragma(loop(ivdep))
+#elif defined(__GNUC__)
+#define BATCH_LOOP _Pragma("GCC ivdep")
+#else
+#define BATCH_LOOP
+#endif
+#endif
+
+namespace Options
+{
+	enum CdfTier
+	{
+		CdfExact, // erfc based, full double precision (agrees with boost::math::cdf to about 1e-16)
+		CdfRisk, // Hart (1968) rational approximation, absolute error below 1e-14 in practice, vectorised
+		CdfSweep // Abramowitz and Stegun 26.2.17 polynomial, absolute error below 1e-7, vectorised and the cheapest, for scenario sweeps
+	};
+
+	const double NormalInvSqrt2 = 0.70710678118654752440; // 1/sqrt(2)
+	const double NormalInvSqrt2Pi = 0.39894228040143267794; // 1/sqrt(2*pi)
+
+	inline double NormalPdf(double x) // function to calculate the standard normal pdf, exact in every tier since its cost is a single exp
+	{
+		return NormalInvSqrt2Pi * exp(-0.5 * x * x);
+	}
+
+	// exp(x) for x in [-708, 709], branch free so that loops calling it vectorise. x = n ln2 + r with |r| <= ln2 / 2 (ln2 split
+	// in two, Cody and Waite), e^r by its Taylor polynomial of degree 12 and 2^n written into the exponent bits. Relative
+	// error below 4e-16; x below -708 is taken as -708
+	inline double NormalExp(double x)
+	{
+		const double shift = 6755399441055744.0; // 1.5 * 2^52: adding it rounds to an integer held in the low mantissa bits
+		x = (x < -708.0) ? -708.0 : x;
+		double n = x * 1.4426950408889634 + shift;
+		int64_t bits;
+		memcpy(&bits, &n, sizeof(bits));
+		n -= shift;
+		double r = x - n * 6.93147180369123816490e-01 - n * 1.90821492927058770002e-10;
+		double p = 2.08767569878680989792e-09;
+		p = p * r + 2.50521083854417187751e-08;
+		p = p * r + 2.75573192239858906526e-07;
+		p = p * r + 2.75573192239858906526e-06;
+		p = p * r + 2.48015873015873015873e-05;
+		p = p * r + 1.98412698412698412698e-04;
+		p = p * r + 1.38888888888888888889e-03;
+		p = p * r + 8.33333333333333333333e-03;
+		p = p * r + 4.16666666666666666667e-02;
+		p = p * r + 1.66666666666666666667e-01;
+		p = p * r + 0.5;
+		p = p * r + 1.0;
+		p = p * r + 1.0;
+		int64_t exponent = (bits + 1023) << 52;
+		double scale;
+		memcpy(&scale, &exponent, sizeof(scale));
+		return p * scale;
+	}
+
+	// exp(x) as NormalExp with a Taylor polynomial of degree 7, relative error below 6e-9, for the Sweep tier
+	inline double NormalExpSweep(double x)
+	{
+		const double shift = 6755399441055744.0;
+		x = (x < -708.0) ? -708.0 : x;
+		double n = x * 1.4426950408889634 + shift;
+		int64_t bits;
+		memcpy(&bits, &n, sizeof(bits));
+		n -= shift;
+		double r = x - n * 0.69314718055994530942;
+		double p = 1.98412698412698412698e-04;
+		p = p * r + 1.38888888888888888889e-03;
+		p = p * r + 8.33333333333333333333e-03;
+		p = p * r + 4.16666666666666666667e-02;
+		p = p * r + 1.66666666666666666667e-01;
+		p = p * r + 0.5;
+		p = p * r + 1.0;
+		p = p * r + 1.0;
+		int64_t exponent = (bits + 1023) << 52;
+		double scale;
+		memcpy(&scale, &exponent, sizeof(scale));
+		return p * scale;
+	}
+
+	// log(x) for positive normal x, branch free so that loops calling it vectorise. x = 2^k m with m in [sqrt(2)/2, sqrt(2)),
+	// log(m) = log(1 + f) from the series in s = f / (2 + f) of fdlibm's log; k is read from the exponent bits as a double
+	// (2^52 + k - 2^52), so no integer to double conversion is needed. Error below 1 ulp
+	inline double NormalLog(double x)
+	{
+		int64_t bits;
+		memcpy(&bits, &x, sizeof(bits));
+		int64_t mantissaBits = (bits & 0x000FFFFFFFFFFFFFLL) | 0x3FF0000000000000LL;
+		int64_t exponentBits = (bits >> 52) | 0x4330000000000000LL;
+		double m, k;
+		memcpy(&m, &mantissaBits, sizeof(m));
+		memcpy(&k, &exponentBits, sizeof(k));
+		k -= 4503599627371519.0; // 2^52 + 1023
+		bool high = m > 1.41421356237309504880;
+		m = high ? 0.5 * m : m;
+		k = high ? k + 1.0 : k;
+
+		double f = m - 1.0;
+		double s = f / (2.0 + f);
+		double z = s * s;
+		double w = z * z;
+		double t1 = w * (3.999999999940941908e-01 + w * (2.222219843214978396e-01 + w * 1.531383769920937332e-01));
+		double t2 = z * (6.666666666666735130e-01 + w * (2.857142874366239149e-01 + w * (1.818357216161805012e-01 + w * 1.479819860511658591e-01)));
+		double hfsq = 0.5 * f * f;
+		return k * 6.93147180369123816490e-01 - ((hfsq - (s * (hfsq + t1 + t2) + k * 1.90821492927058770002e-10)) - f);
+	}
+
+	inline double NormalCdfExact(double x) // function to calculate the standard normal cdf to full double precision
+	{
+		return 0.5 * erfc(-x * NormalInvSqrt2);
+	}
+
+	// Tail functions: N(-xAbs) for xAbs = |x| >= 0, one per tier. N(-x) taken from them keeps the tier's accuracy where
+	// 1 - N(x) would cancel (deep out of the money puts); the Exact tail is accurate relative to its size over the whole
+	// range, Risk and Sweep to their absolute bounds. The cdf functions below use them
+	inline double NormalTailExact(double xAbs) // function to calculate N(-xAbs) to full double precision
+	{
+		return 0.5 * erfc(xAbs * NormalInvSqrt2);
+	}
+
+	inline double NormalTailRisk(double xAbs) // function to calculate N(-xAbs) with Hart's rational approximation, branch free
+	{
+		// Hart's rational is used over the whole range instead of switching to a continued fraction beyond |x| = 7.07,
+		// the tail there is below 1e-12 so the absolute error stays within the tier. |x| is capped at 37.5, where the tail
+		// is 1e-307, so the exponential stays normal; the tail beyond is returned as that of 37.5.
+		xAbs = (xAbs < 37.5) ? xAbs : 37.5;
+		double num = 3.52624965998911e-02 * xAbs + 0.700383064443688;
+		num = num * xAbs + 6.37396220353165;
+		num = num * xAbs + 33.912866078383;
+		num = num * xAbs + 112.079291497871;
+		num = num * xAbs + 221.213596169931;
+		num = num * xAbs + 220.206867912376;
+		double den = 8.83883476483184e-02 * xAbs + 1.75566716318264;
+		den = den * xAbs + 16.064177579207;
+		den = den * xAbs + 86.7807322029461;
+		den = den * xAbs + 296.564248779674;
+		den = den * xAbs + 637.333633378831;
+		den = den * xAbs + 793.826512519948;
+		den = den * xAbs + 440.413735824752;
+		return NormalExp(-0.5 * xAbs * xAbs) * num / den;
+	}
+
+	inline double NormalTailSweep(double xAbs) // function to calculate N(-xAbs) with the Abramowitz and Stegun polynomial, branch free
+	{
+		xAbs = (xAbs < 37.5) ? xAbs : 37.5;
+		double t = 1.0 / (1.0 + 0.2316419 * xAbs);
+		double poly = t * (0.319381530 + t * (-0.356563782 + t * (1.781477937 + t * (-1.821255978 + t * 1.330274429))));
+		return NormalInvSqrt2Pi * NormalExpSweep(-0.5 * xAbs * xAbs) * poly;
+	}
+
+	inline double NormalCdfRisk(double x) // function to calculate the standard normal cdf with Hart's rational approximation, branch free
+	{
+		double tail = NormalTailRisk(fabs(x));
+		return x > 0.0 ? 1.0 - tail : tail;
+	}
+
+	inline double NormalCdfSweep(double x) // function to calculate the standard normal cdf with the Abramowitz and Stegun polynomial, branch free
+	{
+		double tail = NormalTailSweep(fabs(x));
+		return x > 0.0 ? 1.0 - tail : tail;
+	}
+
+	inline double NormalCdf(double x, CdfTier tier = CdfExact) // function to calculate the standard normal cdf in the requested tier
+	{
+		switch (tier)
+		{
+		case CdfRisk: return NormalCdfRisk(x);
+		case CdfSweep: return NormalCdfSweep(x);
+		default: return NormalCdfExact(x);
+		}
+	}
+
+	inline double NormalCdfInverse(double p) // function to calculate the standard normal quantile of p in (0, 1)
+	{
+		// Acklam's rational approximation, relative error 1.2e-9, refined by one Halley step on the exact cdf; the result
+		// agrees with boost::math::quantile to 1e-11, the loss near p = 1 being the rounding of 1 - p
+		double x;
+		if (p < 0.02425 || p > 0.97575)
+		{
+			double q = sqrt(-2.0 * log(p < 0.5 ? p : 1.0 - p));
+			x = (((((-7.784894002430293e-03 * q - 3.223964580411365e-01) * q - 2.400758277161838) * q - 2.549732539343734) * q
+				+ 4.374664141464968) * q + 2.938163982698783)
+				/ ((((7.784695709041462e-03 * q + 3.224671290700398e-01) * q + 2.445134137142996) * q + 3.754408661907416) * q + 1.0);
+			x = (p < 0.5) ? x : -x;
+		}
+		else
+		{
+			double q = p - 0.5, r = q * q;
+			x = (((((-3.969683028665376e+01 * r + 2.209460984245205e+02) * r - 2.759285104469687e+02) * r + 1.383577518672690e+02) * r
+				- 3.066479806614716e+01) * r + 2.506628277459239) * q
+				/ (((((-5.447609879822406e+01 * r + 1.615858368580409e+02) * r - 1.556989798598866e+02) * r + 6.680131188771972e+01) * r
+				- 1.328068155288572e+01) * r + 1.0);
+		}
+		double u = (NormalCdfExact(x) - p) / NormalPdf(x);
+		return x - u / (1.0 + 0.5 * x * u);
+	}
+
+	// Single precision, used by the float instantiation of the batch pricers. Their errors are bounded by float rounding
+	// (about 6e-8 relative) rather than by the approximation, so single precision has two tiers only: CdfExact is erfcf,
+	// CdfRisk and CdfSweep both map to the fast tier NormalCdfSingle
+	const float NormalInvSqrt2Single = 0.70710678f; // 1/sqrt(2)
+	const float NormalInvSqrt2PiSingle = 0.39894228f; // 1/sqrt(2*pi)
+
+	inline float NormalPdfSingle(float x) // function to calculate the standard normal pdf in single precision
+	{
+		return NormalInvSqrt2PiSingle * expf(-0.5f * x * x);
+	}
+
+	inline float NormalTailSingle(float xAbs) // function to calculate N(-xAbs) in single precision with the Abramowitz and Stegun polynomial, branch free
+	{
+		// The polynomial's absolute error of 7.5e-8 is at float resolution; |x| is capped at 13, where the tail underflows
+		xAbs = xAbs < 13.0f ? xAbs : 13.0f;
+		float t = 1.0f / (1.0f + 0.2316419f * xAbs);
+		float poly = t * (0.319381530f + t * (-0.356563782f + t * (1.781477937f + t * (-1.821255978f + t * 1.330274429f))));
+		return NormalInvSqrt2PiSingle * expf(-0.5f * xAbs * xAbs) * poly;
+	}
+
+	inline float NormalCdfSingle(float x) // function to calculate the standard normal cdf in single precision with the Abramowitz and Stegun polynomial, branch free
+	{
+		float tail = NormalTailSingle(fabsf(x));
+		return x > 0.0f ? 1.0f - tail : tail;
+	}
+
+	// Batch forms: out[i] = N(x[i]) or n(x[i]) for i < n. The tier is resolved once per call, outside the loop.
+	// The forms with a complement also give complement[i] = N(-x[i]) from the same tail evaluation, accurate relative to
+	// its size; pricers take N(-d) from there rather than as 1 - N(d)
+	void NormalCdfBatch(const double* x, double* out, size_t n, CdfTier tier = CdfExact); // function to calculate the standard normal cdf of n values
+	void NormalCdfBatch(const double* x, double* out, double* complement, size_t n, CdfTier tier = CdfExact); // function to calculate N(x) and N(-x) of n values
+	void NormalPdfBatch(const double* x, double* out, size_t n); // function to calculate the standard normal pdf of n values
+	void NormalCdfBatch(const float* x, float* out, size_t n, CdfTier tier = CdfExact); // function to calculate the standard normal cdf of n values in single precision
+	void NormalCdfBatch(const float* x, float* out, float* complement, size_t n, CdfTier tier = CdfExact); // function to calculate N(x) and N(-x) of n values in single precision
+	void NormalPdfBatch(const float* x, float* out, size_t n); // function to calculate the standard normal pdf of n values in single precision
+}
+
+#endif
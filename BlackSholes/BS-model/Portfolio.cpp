@@ -0,0 +1,176 @@
+// Group A & B: Source file for a portfolio of European option positions and the parallel aggregation of its risk
+
+#include "Portfolio.h"
+#include "EuroBatch.h"
+#include "Scheduler.h"
+#include <algorithm>
+using namespace std;
+
+namespace Options
+{
+	const size_t PortfolioChunk = 256; // positions per chunk, the leaves of the reduction tree; fixed so the tree never depends on the threads
+	const size_t PortfolioGrain = 16; // chunks per scheduled task
+
+	// Function to add b into a, field by field
+	static void AddTotals(PortfolioTotals& a, const PortfolioTotals& b)
+	{
+		a.Price += b.Price;
+		a.Delta += b.Delta;
+		a.Gamma += b.Gamma;
+		a.Vega += b.Vega;
+		a.Theta += b.Theta;
+		a.Rho += b.Rho;
+	}
+
+	Portfolio::Portfolio() // default constructor
+	{}
+
+	Portfolio::Portfolio(const Portfolio& source) : buckets(source.buckets), index(source.index) // copy constructor
+	{}
+
+	Portfolio::~Portfolio() // destructor
+	{}
+
+	// Function to add a position (type 1 == call, -1 == put) and return the index of its bucket
+	size_t Portfolio::AddPosition(int underlying, int type, double quantity, double T, double sig, double r, double q, double S, double K)
+	{
+		pair<int, double> key(underlying, T);
+		auto it = index.find(key);
+		size_t b;
+		if (it == index.end())
+		{
+			b = buckets.size();
+			buckets.push_back(PortfolioBucket());
+			buckets[b].Underlying = underlying;
+			buckets[b].Expiry = T;
+			index[key] = b;
+		}
+		else
+		{
+			b = it->second;
+		}
+
+		PortfolioBucket& bucket = buckets[b];
+		bucket.sig.push_back(sig);
+		bucket.r.push_back(r);
+		bucket.q.push_back(q);
+		bucket.S.push_back(S);
+		bucket.K.push_back(K);
+		bucket.Phi.push_back(type == 1 ? 1.0 : -1.0);
+		bucket.Quantity.push_back(quantity);
+		return b;
+	}
+
+	size_t Portfolio::Buckets() const // function to return the number of buckets
+	{
+		return buckets.size();
+	}
+
+	const PortfolioBucket& Portfolio::Bucket(size_t i) const // function to return bucket i
+	{
+		return buckets[i];
+	}
+
+	size_t Portfolio::Positions() const // function to return the number of positions
+	{
+		size_t n = 0;
+		for (size_t i = 0; i < buckets.size(); ++i)
+		{
+			n += buckets[i].Size();
+		}
+		return n;
+	}
+
+	// Function to calculate the position-weighted totals per bucket, per underlying and for the portfolio
+	void Portfolio::Aggregate(PortfolioRisk& out, unsigned nThreads, CdfTier tier) const
+	{
+		// Chunk c covers positions [chunkBegin[c], chunkBegin[c] + PortfolioChunk) of bucket chunkBucket[c];
+		// the chunks of bucket b are firstChunk[b] to firstChunk[b + 1] - 1
+		vector<size_t> firstChunk(buckets.size() + 1, 0), chunkBucket, chunkBegin;
+		for (size_t b = 0; b < buckets.size(); ++b)
+		{
+			firstChunk[b] = chunkBucket.size();
+			for (size_t begin = 0; begin < buckets[b].Size(); begin += PortfolioChunk)
+			{
+				chunkBucket.push_back(b);
+				chunkBegin.push_back(begin);
+			}
+		}
+		firstChunk[buckets.size()] = chunkBucket.size();
+		size_t nChunks = chunkBucket.size();
+
+		// Leaves: every chunk is priced by the batch kernel and summed position by position in index order
+		PortfolioTotals zero = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+		vector<PortfolioTotals> partial(nChunks, zero);
+		ParallelFor(nChunks, PortfolioGrain, [&](size_t begin, size_t end)
+		{
+			double T[PortfolioChunk], cp[PortfolioChunk], pp[PortfolioChunk], cd[PortfolioChunk], pd[PortfolioChunk], ga[PortfolioChunk], ve[PortfolioChunk];
+			double ct[PortfolioChunk], pt[PortfolioChunk], cr[PortfolioChunk], pr[PortfolioChunk];
+			EuroGreeksArrays g = { cp, pp, cd, pd, ga, ve, ct, pt, cr, pr };
+
+			for (size_t c = begin; c < end; ++c)
+			{
+				const PortfolioBucket& bucket = buckets[chunkBucket[c]];
+				size_t first = chunkBegin[c];
+				size_t m = min(PortfolioChunk, bucket.Size() - first);
+				fill(T, T + m, bucket.Expiry);
+				EuroBatchGreeks(T, &bucket.sig[first], &bucket.r[first], &bucket.q[first], &bucket.S[first], &bucket.K[first], g, m, tier);
+
+				PortfolioTotals sum = zero;
+				for (size_t i = 0; i < m; ++i)
+				{
+					double w = bucket.Quantity[first + i];
+					bool isCall = bucket.Phi[first + i] > 0.0;
+					sum.Price += w * (isCall ? cp[i] : pp[i]);
+					sum.Delta += w * (isCall ? cd[i] : pd[i]);
+					sum.Gamma += w * ga[i];
+					sum.Vega += w * ve[i];
+					sum.Theta += w * (isCall ? ct[i] : pt[i]);
+					sum.Rho += w * (isCall ? cr[i] : pr[i]);
+				}
+				partial[c] = sum;
+			}
+		}, nThreads);
+
+		// Tree: at level w the chunk at local index i (a multiple of 2w) absorbs the chunk at i + w of the same bucket.
+		// The pairs of one level are independent, so each level is one parallel loop over the chunks
+		size_t longest = 0;
+		for (size_t b = 0; b < buckets.size(); ++b)
+		{
+			longest = max(longest, firstChunk[b + 1] - firstChunk[b]);
+		}
+		for (size_t w = 1; w < longest; w *= 2)
+		{
+			ParallelFor(nChunks, PortfolioGrain * 64, [&](size_t begin, size_t end)
+			{
+				for (size_t c = begin; c < end; ++c)
+				{
+					size_t b = chunkBucket[c];
+					size_t local = c - firstChunk[b];
+					if (local % (2 * w) == 0 && local + w < firstChunk[b + 1] - firstChunk[b])
+					{
+						AddTotals(partial[c], partial[c + w]);
+					}
+				}
+			}, nThreads);
+		}
+
+		// Buckets into underlyings and the total, in bucket and then underlying order
+		out.Bucket.assign(buckets.size(), zero);
+		out.Underlying.clear();
+		out.Total = zero;
+		for (size_t b = 0; b < buckets.size(); ++b)
+		{
+			if (firstChunk[b + 1] > firstChunk[b])
+			{
+				out.Bucket[b] = partial[firstChunk[b]];
+			}
+			auto it = out.Underlying.insert(make_pair(buckets[b].Underlying, zero)).first;
+			AddTotals(it->second, out.Bucket[b]);
+		}
+		for (auto it = out.Underlying.begin(); it != out.Underlying.end(); ++it)
+		{
+			AddTotals(out.Total, it->second);
+		}
+	}
+}
@@ -0,0 +1,62 @@
+// Group A & B: Header file for a portfolio of European option positions and the parallel aggregation of its risk
+
+#ifndef PortfolioHPP
+#define PortfolioHPP
+
+#include "NormalCdf.h"
+#include <vector>
+#include <map>
+#include <cstddef>
+using namespace std;
+
+namespace Options
+{
+	// Position-weighted price and first order Greeks, each the sum of quantity * (call or put) value over the positions
+	struct PortfolioTotals
+	{
+		double Price, Delta, Gamma, Vega, Theta, Rho;
+	};
+
+	// Positions of one underlying and one expiry, held as structure of arrays so the batch kernels read them directly.
+	// Phi is 1 for a call and -1 for a put
+	struct PortfolioBucket
+	{
+		int Underlying;
+		double Expiry;
+		vector<double> sig, r, q, S, K, Phi, Quantity;
+
+		size_t Size() const { return K.size(); } // function to return the number of positions in the bucket
+	};
+
+	// Risk of a portfolio: Bucket[i] belongs to Buckets()[i], Underlying holds the sum of its buckets and Total the sum of all
+	struct PortfolioRisk
+	{
+		vector<PortfolioTotals> Bucket;
+		map<int, PortfolioTotals> Underlying;
+		PortfolioTotals Total;
+	};
+
+	class Portfolio
+	{
+		private:
+			vector<PortfolioBucket> buckets; // in order of creation
+			map<pair<int, double>, size_t> index; // (underlying, expiry) to bucket
+
+		public:
+			Portfolio(); // default constructor
+			Portfolio(const Portfolio& source); // copy constructor
+			~Portfolio(); // destructor
+
+			size_t AddPosition(int underlying, int type, double quantity, double T, double sig, double r, double q, double S, double K); // function to add a position (type 1 == call, -1 == put) and return the index of its bucket
+			size_t Buckets() const; // function to return the number of buckets
+			const PortfolioBucket& Bucket(size_t i) const; // function to return bucket i
+			size_t Positions() const; // function to return the number of positions
+
+			// The positions of each bucket are split into chunks of fixed size, the chunks are priced and summed in parallel and
+			// the chunk sums of each bucket are combined by a pairwise tree whose shape depends on the bucket size only. Every
+			// addition therefore happens in the same order whatever nThreads is (0 == all cores), and so do the rounding errors
+			void Aggregate(PortfolioRisk& out, unsigned nThreads = 0, CdfTier tier = CdfExact) const; // function to calculate the position-weighted totals per bucket, per underlying and for the portfolio
+	};
+}
+
+#endif
@@ -0,0 +1,90 @@
+// Group A & B: Source file for the parallel scenario-grid engine for Plain (European) options
+
+#include "ScenarioEngine.h"
+#include "Scheduler.h"
+#include <iomanip>
+#include <algorithm>
+using namespace std;
+
+namespace Options
+{
+	const size_t ScenarioGrain = 4096; // scenarios per scheduled chunk, large enough to hide the cost of stealing
+	const size_t ScenarioBlock = 256; // scenarios transposed to structure of arrays at a time, so the block stays in L1 cache
+
+	void ScenarioResults::Resize(size_t n) // function to size every column for n scenarios, reusing the storage when it is large enough
+	{
+		vector<double>* columns[] = { &CallPrice, &PutPrice, &CallDelta, &PutDelta, &Gamma, &Vega, &CallTheta, &PutTheta, &CallRho, &PutRho };
+		for (auto c : columns)
+		{
+			c->resize(n);
+		}
+	}
+
+	size_t ScenarioResults::Size() const // function to return the number of scenarios held
+	{
+		return CallPrice.size();
+	}
+
+	EuroGreeksArrays ScenarioResults::Arrays(size_t offset) // function to return pointers into the columns, starting at scenario offset
+	{
+		EuroGreeksArrays a = { &CallPrice[0] + offset, &PutPrice[0] + offset, &CallDelta[0] + offset, &PutDelta[0] + offset, &Gamma[0] + offset, &Vega[0] + offset,
+			&CallTheta[0] + offset, &PutTheta[0] + offset, &CallRho[0] + offset, &PutRho[0] + offset };
+		return a;
+	}
+
+	// Function to price every row of the scenario matrix across nThreads threads (0 == all cores)
+	void PriceScenarios(const double* scenarios, size_t nScenarios, ScenarioResults& out, unsigned nThreads, CdfTier tier)
+	{
+		out.Resize(nScenarios);
+		if (nScenarios == 0)
+		{
+			return;
+		}
+
+		ParallelFor(nScenarios, ScenarioGrain, [&](size_t begin, size_t end)
+		{
+			double T[ScenarioBlock], K[ScenarioBlock], sig[ScenarioBlock], r[ScenarioBlock], S[ScenarioBlock], q[ScenarioBlock];
+
+			for (size_t start = begin; start < end; start += ScenarioBlock)
+			{
+				size_t m = min(ScenarioBlock, end - start);
+
+				// Transpose the rows of this block into the structure of arrays the batch kernel reads
+				for (size_t i = 0; i < m; ++i)
+				{
+					const double* row = scenarios + (start + i) * ScColumns;
+					T[i] = row[ScTime];
+					K[i] = row[ScStrike];
+					sig[i] = row[ScVolatility];
+					r[i] = row[ScRate];
+					S[i] = row[ScUnderlying];
+					q[i] = row[ScDividend];
+				}
+
+				EuroBatchGreeks(T, sig, r, q, S, K, out.Arrays(start), m, tier);
+			}
+		}, nThreads);
+	}
+
+	// Function to print the scenarios with their call and put prices
+	void PrintScenarioPrices(ostream& os, const double* scenarios, size_t nScenarios, const ScenarioResults& res)
+	{
+		os << setw(10) << "Time" << setw(10) << "Strike" << setw(15) << "Volatility" << setw(10) << "Rate" << setw(15) << "Underlying" << setw(10) << "Dividend" << setw(15) << "Call Price" << setw(15) << "Put Price" << endl;
+		for (size_t i = 0; i < nScenarios; ++i)
+		{
+			const double* row = scenarios + i * ScColumns;
+			os << setw(10) << row[0] << setw(10) << row[1] << setw(15) << row[2] << setw(10) << row[3] << setw(15) << row[4] << setw(10) << row[5] << setw(15) << res.CallPrice[i] << setw(15) << res.PutPrice[i] << endl;
+		}
+	}
+
+	// Function to print the scenarios with their call and put deltas
+	void PrintScenarioDeltas(ostream& os, const double* scenarios, size_t nScenarios, const ScenarioResults& res)
+	{
+		os << setw(10) << "Time" << setw(10) << "Strike" << setw(15) << "Volatility" << setw(10) << "Rate" << setw(15) << "Underlying" << setw(10) << "Dividend" << setw(15) << "Call Delta" << setw(15) << "Put Delta" << endl;
+		for (size_t i = 0; i < nScenarios; ++i)
+		{
+			const double* row = scenarios + i * ScColumns;
+			os << setw(10) << row[0] << setw(10) << row[1] << setw(15) << row[2] << setw(10) << row[3] << setw(15) << row[4] << setw(10) << row[5] << setw(15) << res.CallDelta[i] << setw(15) << res.PutDelta[i] << endl;
+		}
+	}
+}
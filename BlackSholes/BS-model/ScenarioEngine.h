@@ -0,0 +1,47 @@
+// Group A & B: Header file for the parallel scenario-grid engine for Plain (European) options
+
+#ifndef ScenarioEngineHPP
+#define ScenarioEngineHPP
+
+#include "EuroBatch.h"
+#include <iostream>
+#include <vector>
+using namespace std;
+
+namespace Options
+{
+	// Columns of one row of the flat, row-major scenario matrix, in the order used by EuroOption::MultiFactorPricer
+	enum ScenarioColumn
+	{
+		ScTime = 0,
+		ScStrike = 1,
+		ScVolatility = 2,
+		ScRate = 3,
+		ScUnderlying = 4,
+		ScDividend = 5,
+		ScColumns = 6 // row stride
+	};
+
+	// Columnar prices and first order Greeks of every scenario, element i belongs to row i of the scenario matrix
+	class ScenarioResults
+	{
+	public:
+		vector<double> CallPrice, PutPrice;
+		vector<double> CallDelta, PutDelta;
+		vector<double> Gamma, Vega;
+		vector<double> CallTheta, PutTheta;
+		vector<double> CallRho, PutRho;
+
+		void Resize(size_t n); // function to size every column for n scenarios, reusing the storage when it is large enough
+		size_t Size() const; // function to return the number of scenarios held
+		EuroGreeksArrays Arrays(size_t offset = 0); // function to return pointers into the columns, starting at scenario offset
+	};
+
+	void PriceScenarios(const double* scenarios, size_t nScenarios, ScenarioResults& out, unsigned nThreads = 0, CdfTier tier = CdfExact); // function to price every row of the scenario matrix across nThreads threads (0 == all cores)
+
+	// Optional printing sinks, kept apart from the pricing so large runs need not format anything
+	void PrintScenarioPrices(ostream& os, const double* scenarios, size_t nScenarios, const ScenarioResults& res); // function to print the scenarios with their call and put prices
+	void PrintScenarioDeltas(ostream& os, const double* scenarios, size_t nScenarios, const ScenarioResults& res); // function to print the scenarios with their call and put deltas
+}
+
+#endif
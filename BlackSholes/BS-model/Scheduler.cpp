@@ -0,0 +1,281 @@
+// Group A & B: Source file for the work-stealing parallel loop used by the batch engines
+
+#include "Scheduler.h"
+#include <thread>
+#include <mutex>
+#include <vector>
+#include <memory>
+#include <exception>
+#include <algorithm>
+using namespace std;
+
+namespace Options
+{
+	// Share of the index range still to be done by one worker, guarded by its own lock so owner and thieves can meet
+	struct WorkShare
+	{
+		mutex lock;
+		size_t begin;
+		size_t end;
+	};
+
+	unsigned HardwareThreads() // function to return the number of hardware threads, at least 1
+	{
+		unsigned n = thread::hardware_concurrency();
+		return (n == 0) ? 1 : n;
+	}
+
+	// Function to run body over [0, n) on a pool of threads
+	void ParallelFor(size_t n, size_t grain, const function<void(size_t, size_t)>& body, unsigned nThreads)
+	{
+		if (n == 0)
+		{
+			return;
+		}
+		grain = max(grain, size_t(1));
+		nThreads = (nThreads == 0) ? HardwareThreads() : nThreads;
+		nThreads = unsigned(min(size_t(nThreads), (n + grain - 1) / grain));
+
+		if (nThreads <= 1)
+		{
+			for (size_t b = 0; b < n; b += grain)
+			{
+				body(b, min(b + grain, n));
+			}
+			return;
+		}
+
+		unique_ptr<WorkShare[]> shares(new WorkShare[nThreads]);
+		for (unsigned w = 0; w < nThreads; ++w)
+		{
+			shares[w].begin = n * w / nThreads;
+			shares[w].end = n * (w + 1) / nThreads;
+		}
+
+		mutex errorLock;
+		exception_ptr error;
+
+		auto worker = [&](unsigned w)
+		{
+			try
+			{
+				while (true)
+				{
+					// Take the next chunk from the front of the own share
+					size_t b = 0, e = 0;
+					{
+						lock_guard<mutex> guard(shares[w].lock);
+						if (shares[w].begin < shares[w].end)
+						{
+							b = shares[w].begin;
+							e = min(b + grain, shares[w].end);
+							shares[w].begin = e;
+						}
+					}
+					if (b < e)
+					{
+						body(b, e);
+						continue;
+					}
+
+					// Own share is empty: steal the back half of the largest share left
+					unsigned victim = w;
+					size_t most = 0;
+					for (unsigned v = 0; v < nThreads; ++v)
+					{
+						lock_guard<mutex> guard(shares[v].lock);
+						if (v != w && shares[v].end - shares[v].begin > most)
+						{
+							most = shares[v].end - shares[v].begin;
+							victim = v;
+						}
+					}
+					if (victim == w)
+					{
+						return; // nothing left anywhere
+					}
+
+					{
+						lock_guard<mutex> guard(shares[victim].lock);
+						size_t left = shares[victim].end - shares[victim].begin;
+						if (left == 0)
+						{
+							continue; // the owner finished it meanwhile, look again
+						}
+						size_t mid = shares[victim].begin + left / 2;
+						b = mid;
+						e = shares[victim].end;
+						shares[victim].end = mid;
+					}
+					{
+						lock_guard<mutex> guard(shares[w].lock);
+						shares[w].begin = b;
+						shares[w].end = e;
+					}
+				}
+			}
+			catch (...)
+			{
+				lock_guard<mutex> guard(errorLock);
+				if (!error)
+				{
+					error = current_exception();
+				}
+
+				// Drain every share so the other workers stop soon
+				for (unsigned v = 0; v < nThreads; ++v)
+				{
+					lock_guard<mutex> guard2(shares[v].lock);
+					shares[v].begin = shares[v].end;
+				}
+			}
+		};
+
+		vector<thread> pool;
+		for (unsigned w = 1; w < nThreads; ++w)
+		{
+			pool.push_back(thread(worker, w));
+		}
+		worker(0);
+		for (auto& t : pool)
+		{
+			t.join();
+		}
+
+		if (error)
+		{
+			rethrow_exception(error);
+		}
+	}
+
+	WorkerPool::WorkerPool(unsigned nThreads) : job(0), jobSize(0), jobGrain(1), next(0), jobThreads(1), generation(0), busy(0), stop(false) // constructor that starts nThreads - 1 workers
+	{
+		nThreads = (nThreads == 0) ? HardwareThreads() : nThreads;
+		for (unsigned w = 1; w < nThreads; ++w)
+		{
+			workers.push_back(thread(&WorkerPool::Work, this, w));
+		}
+	}
+
+	WorkerPool::~WorkerPool() // destructor that stops and joins the workers
+	{
+		{
+			lock_guard<mutex> guard(lock);
+			stop = true;
+		}
+		wake.notify_all();
+		for (auto& t : workers)
+		{
+			t.join();
+		}
+	}
+
+	unsigned WorkerPool::Threads() const // function to return the threads of the pool, the calling thread included
+	{
+		return unsigned(workers.size()) + 1;
+	}
+
+	// Function to run chunks of the current loop until none is left. After an exception the counter is moved past the end,
+	// so every thread stops after its current chunk
+	void WorkerPool::Take()
+	{
+		while (true)
+		{
+			size_t b = next.fetch_add(jobGrain);
+			if (b >= jobSize)
+			{
+				return;
+			}
+			try
+			{
+				(*job)(b, min(b + jobGrain, jobSize));
+			}
+			catch (...)
+			{
+				lock_guard<mutex> guard(lock);
+				if (!error)
+				{
+					error = current_exception();
+				}
+				next = jobSize;
+			}
+		}
+	}
+
+	// Function run by worker w: wait for a loop, take part if the loop uses more than w threads, repeat until the pool stops
+	void WorkerPool::Work(unsigned w)
+	{
+		unsigned seen = 0;
+		while (true)
+		{
+			{
+				unique_lock<mutex> guard(lock);
+				wake.wait(guard, [&] { return stop || generation != seen; });
+				if (stop)
+				{
+					return;
+				}
+				seen = generation;
+				if (w >= jobThreads)
+				{
+					continue;
+				}
+			}
+
+			Take();
+
+			lock_guard<mutex> guard(lock);
+			if (--busy == 0)
+			{
+				finished.notify_one();
+			}
+		}
+	}
+
+	// Function to run body over [0, n) on at most nThreads of the pool's threads. A loop that fits one thread runs on the
+	// calling thread alone and never touches the workers
+	void WorkerPool::Run(size_t n, size_t grain, const function<void(size_t, size_t)>& body, unsigned nThreads)
+	{
+		if (n == 0)
+		{
+			return;
+		}
+		grain = max(grain, size_t(1));
+		nThreads = (nThreads == 0) ? Threads() : min(nThreads, Threads());
+		nThreads = unsigned(min(size_t(nThreads), (n + grain - 1) / grain));
+
+		if (nThreads <= 1)
+		{
+			for (size_t b = 0; b < n; b += grain)
+			{
+				body(b, min(b + grain, n));
+			}
+			return;
+		}
+
+		{
+			lock_guard<mutex> guard(lock);
+			job = &body;
+			jobSize = n;
+			jobGrain = grain;
+			next = 0;
+			jobThreads = nThreads;
+			busy = nThreads - 1;
+			error = exception_ptr();
+			++generation;
+		}
+		wake.notify_all();
+
+		Take();
+
+		unique_lock<mutex> guard(lock);
+		finished.wait(guard, [&] { return busy == 0; });
+		job = 0;
+		if (error)
+		{
+			exception_ptr thrown = error;
+			error = exception_ptr();
+			rethrow_exception(thrown);
+		}
+	}
+}
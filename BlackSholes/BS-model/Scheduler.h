@@ -0,0 +1,59 @@
+// Group A & B: Header file for the work-stealing parallel loop used by the batch engines
+
+#ifndef SchedulerHPP
+#define SchedulerHPP
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+using namespace std;
+
+namespace Options
+{
+	unsigned HardwareThreads(); // function to return the number of hardware threads, at least 1
+
+	// Calls body(begin, end) on disjoint chunks of at most grain indices until [0, n) is covered. Each thread starts on an
+	// equal share of the range and, once it runs dry, steals the back half of the largest remaining share of another
+	// thread. The calling thread takes part; nThreads == 0 means HardwareThreads(). An exception thrown by body is
+	// rethrown on the calling thread after all workers have stopped.
+	void ParallelFor(size_t n, size_t grain, const function<void(size_t, size_t)>& body, unsigned nThreads = 0); // function to run body over [0, n) on a pool of threads
+
+	// Threads started once and kept waiting for work, for callers that run many small loops (the tick engine runs one per
+	// update) where starting threads on every call, as ParallelFor does, would cost more than the loop. Run() hands out
+	// chunks of grain indices from a shared counter; the calling thread takes part and the call returns once [0, n) is
+	// covered. An exception thrown by body is rethrown on the calling thread. A pool runs one loop at a time.
+	class WorkerPool
+	{
+		private:
+			vector<thread> workers;
+			mutex lock;
+			condition_variable wake, finished;
+			const function<void(size_t, size_t)>* job; // loop of the current generation
+			size_t jobSize, jobGrain;
+			atomic<size_t> next; // first index not yet handed out
+			unsigned jobThreads; // threads of the current loop, the calling thread included
+			unsigned generation; // loops started, a worker waits for it to move
+			unsigned busy; // workers still in the current loop
+			bool stop;
+			exception_ptr error;
+
+			void Work(unsigned w); // function run by worker w: wait for a loop, take part, repeat until the pool stops
+			void Take(); // function to run chunks of the current loop until none is left
+
+		public:
+			WorkerPool(unsigned nThreads = 0); // constructor that starts nThreads - 1 workers, the calling thread of Run being the last; 0 means HardwareThreads()
+			WorkerPool(const WorkerPool& source) = delete;
+			WorkerPool& operator = (const WorkerPool& source) = delete;
+			~WorkerPool(); // destructor that stops and joins the workers
+
+			unsigned Threads() const; // function to return the threads of the pool, the calling thread included
+			void Run(size_t n, size_t grain, const function<void(size_t, size_t)>& body, unsigned nThreads = 0); // function to run body over [0, n) on at most nThreads of the pool's threads, 0 means all
+	};
+}
+
+#endif
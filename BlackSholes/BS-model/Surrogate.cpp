@@ -0,0 +1,408 @@
+// Group A & B: Source file for a piecewise Chebyshev surrogate of the normalised Black-Scholes price
+
+#include "Surrogate.h"
+#include "EuroFormula.h"
+#include "NormalCdf.h"
+#include <cmath>
+#include <algorithm>
+#include <string>
+#include <iomanip>
+#include <limits>
+using namespace std;
+
+namespace Options
+{
+	const size_t SurrogateBlock = 64; // contracts per block of the batch evaluator
+	const int SurrogateCheck = 16; // check points per cell and direction used for the observed error
+	const int SurrogateMaxDegree = 15; // largest polynomial degree in each direction
+	const size_t SurrogateMaxBytes = 1 << 20; // largest coefficient table Load accepts, far above the 32 KB L1 budget
+	const double SurrogateEps = numeric_limits<double>::epsilon();
+	const double Pi = 3.14159265358979323846;
+
+	PriceSurrogate::PriceSurrogate() : xMin(0.0), xMax(0.0), sMin(0.0), sMax(0.0), cellsX(0), cellsS(0), degree(0), invHx(0.0), invHs(0.0), maxError(0.0), observedError(0.0) // default constructor
+	{}
+
+	PriceSurrogate::PriceSurrogate(double xLow, double xHigh, size_t nx, double sLow, double sHigh, size_t ns, int deg, double tolerance) // constructor that fits the surrogate (offline builder), empty if the error bound exceeds tolerance
+		: xMin(xLow), xMax(xHigh), sMin(sLow), sMax(sHigh), cellsX(nx), cellsS(ns), degree(min(max(deg, 0), SurrogateMaxDegree)), invHx(nx / (xHigh - xLow)), invHs(ns / (sHigh - sLow)), maxError(0.0), observedError(0.0)
+	{
+		Fit();
+		if (!(maxError <= tolerance))
+		{
+			coef.clear();
+		}
+	}
+
+	double PriceSurrogate::Exact(double x, double s) const // function to calculate the normalised call price with the closed form
+	{
+		return NormalCdfExact(-x + 0.5 * s) - exp(x * s) * NormalCdfExact(-x - 0.5 * s);
+	}
+
+	// Function to calculate the tensor Chebyshev coefficients of c on cell (a, b) up to degree q - 1: c is sampled at the q x q
+	// Chebyshev nodes and cc[m * q + n], the coefficient of T_m(u) T_n(v), follows from the discrete cosine transform, taken one
+	// direction at a time
+	void PriceSurrogate::CellChebyshev(size_t a, size_t b, int q, vector<double>& cc) const
+	{
+		double hx = (xMax - xMin) / cellsX;
+		double hs = (sMax - sMin) / cellsS;
+		vector<double> cosines(q * q), values(q * q), half(q * q);
+		for (int m = 0; m < q; ++m)
+		{
+			for (int i = 0; i < q; ++i)
+			{
+				cosines[m * q + i] = cos(Pi * m * (i + 0.5) / q);
+			}
+		}
+		for (int i = 0; i < q; ++i)
+		{
+			double nodeX = cos(Pi * (i + 0.5) / q);
+			for (int j = 0; j < q; ++j)
+			{
+				double nodeS = cos(Pi * (j + 0.5) / q);
+				values[i * q + j] = Exact(xMin + (a + 0.5 + 0.5 * nodeX) * hx, sMin + (b + 0.5 + 0.5 * nodeS) * hs);
+			}
+		}
+
+		// half[m * q + j] = sum_i values(i, j) cos(pi m (i + 1/2) / q), then the same in the second direction
+		for (int m = 0; m < q; ++m)
+		{
+			for (int j = 0; j < q; ++j)
+			{
+				double sum = 0.0;
+				for (int i = 0; i < q; ++i)
+				{
+					sum += values[i * q + j] * cosines[m * q + i];
+				}
+				half[m * q + j] = sum;
+			}
+		}
+		cc.assign(q * q, 0.0);
+		for (int m = 0; m < q; ++m)
+		{
+			for (int n = 0; n < q; ++n)
+			{
+				double sum = 0.0;
+				for (int j = 0; j < q; ++j)
+				{
+					sum += half[m * q + j] * cosines[n * q + j];
+				}
+				cc[m * q + n] = sum * (m > 0 ? 2.0 : 1.0) * (n > 0 ? 2.0 : 1.0) / (q * q);
+			}
+		}
+	}
+
+	// Function to calculate the coefficients and the error bound. In each cell the tensor Chebyshev coefficients of degree
+	// (degree) are converted to monomials in the cell coordinates u, v in [-1, 1]; those of degree 2 * degree + 1 give the
+	// truncation bound of the cell, as set out in Surrogate.h
+	void PriceSurrogate::Fit()
+	{
+		int q = degree + 1;
+		coef.assign(cellsX * cellsS * q * q, 0.0);
+
+		// Monomial coefficients of the Chebyshev polynomials, T_m(u) = sum_i cheb[m][i] u^i, and |T_m|(1) = sum_i |cheb[m][i]|
+		vector<double> cheb(q * q, 0.0), chebAbs(q, 0.0);
+		cheb[0] = 1.0;
+		if (q > 1)
+		{
+			cheb[q + 1] = 1.0;
+		}
+		for (int m = 2; m < q; ++m)
+		{
+			for (int i = 0; i < q; ++i)
+			{
+				cheb[m * q + i] = (i > 0 ? 2 * cheb[(m - 1) * q + i - 1] : 0.0) - cheb[(m - 2) * q + i];
+			}
+		}
+		for (int m = 0; m < q; ++m)
+		{
+			for (int i = 0; i < q; ++i)
+			{
+				chebAbs[m] += fabs(cheb[m * q + i]);
+			}
+		}
+
+		int q2 = 2 * q;
+		double bound = 0.0;
+		vector<double> cc, tail;
+		for (size_t a = 0; a < cellsX; ++a)
+		{
+			for (size_t b = 0; b < cellsS; ++b)
+			{
+				CellChebyshev(a, b, q, cc);
+				double* c = &coef[(a * cellsS + b) * q * q];
+				double rounding = 0.0;
+				for (int m = 0; m < q; ++m)
+				{
+					for (int n = 0; n < q; ++n)
+					{
+						for (int i = 0; i <= m; ++i)
+						{
+							for (int j = 0; j <= n; ++j)
+							{
+								c[j * q + i] += cc[m * q + n] * cheb[m * q + i] * cheb[n * q + j];
+							}
+						}
+						rounding += fabs(cc[m * q + n]) * chebAbs[m] * chebAbs[n];
+					}
+				}
+
+				// Truncation: twice the coefficients of degree q to 2q - 1 in either direction
+				CellChebyshev(a, b, q2, tail);
+				double dropped = 0.0;
+				for (int m = 0; m < q2; ++m)
+				{
+					for (int n = 0; n < q2; ++n)
+					{
+						dropped += (m >= q || n >= q) ? fabs(tail[m * q2 + n]) : 0.0;
+					}
+				}
+				bound = max(bound, 2 * dropped + 8 * q * SurrogateEps * rounding);
+			}
+		}
+
+		// The check grid cannot exceed a valid bound; taking the larger keeps MaxError() a bound should it ever do so
+		observedError = CheckError();
+		maxError = max(bound, observedError);
+	}
+
+	// Function to return the largest error on the check grid, evaluated exactly as the pricing functions do
+	double PriceSurrogate::CheckError() const
+	{
+		double worst = 0.0;
+		int points = SurrogateCheck * (int)cellsX;
+		int pointsS = SurrogateCheck * (int)cellsS;
+		for (int i = 0; i <= points; ++i)
+		{
+			for (int j = 0; j <= pointsS; ++j)
+			{
+				double x = xMin + (xMax - xMin) * i / points;
+				double s = sMin + (sMax - sMin) * j / pointsS;
+				worst = max(worst, fabs(NormalizedCall(x, s) - Exact(x, s)));
+			}
+		}
+		return worst;
+	}
+
+	double PriceSurrogate::MaxError() const // function to return the bound on the error of the normalised price over the domain
+	{
+		return maxError;
+	}
+
+	double PriceSurrogate::MaxObservedError() const // function to return the largest error of the normalised price found on the check grid
+	{
+		return observedError;
+	}
+
+	size_t PriceSurrogate::Bytes() const // function to return the size of the coefficient table
+	{
+		return coef.size() * sizeof(double);
+	}
+
+	bool PriceSurrogate::Empty() const // function to tell whether the surrogate has no table, so that every price is exact
+	{
+		return coef.empty();
+	}
+
+	bool PriceSurrogate::InDomain(double x, double s) const // function to tell whether (x, s) is covered by the surrogate
+	{
+		return !coef.empty() && x >= xMin && x <= xMax && s >= sMin && s <= sMax;
+	}
+
+	// Function to evaluate a cell polynomial with Q coefficients in each direction, stored with the powers of u contiguous.
+	// The Horner chain in v of each power of u does not depend on the running Horner sum in u, so the processor overlaps
+	// the Q chains; Q is a constant so that the compiler can unroll them
+	template <int Q>
+	static inline double CellPolynomial(const double* c, double u, double v)
+	{
+		double result = 0.0;
+		for (int i = Q - 1; i >= 0; --i)
+		{
+			double inner = c[(Q - 1) * Q + i];
+			for (int j = Q - 2; j >= 0; --j)
+			{
+				inner = inner * v + c[j * Q + i];
+			}
+			result = result * u + inner;
+		}
+		return result;
+	}
+
+	// Function to evaluate a cell polynomial of any degree, for degrees without a constant instance
+	static double CellPolynomial(const double* c, int q, double u, double v)
+	{
+		double result = 0.0;
+		for (int i = q - 1; i >= 0; --i)
+		{
+			double inner = c[(q - 1) * q + i];
+			for (int j = q - 2; j >= 0; --j)
+			{
+				inner = inner * v + c[j * q + i];
+			}
+			result = result * u + inner;
+		}
+		return result;
+	}
+
+	// Function to evaluate the normalised call price c(x, s) without the domain check. The cell index is clamped (the
+	// conditional moves compile to min/max instructions), so a point just outside the domain evaluates the nearest cell;
+	// only the callers decide on the fallback
+	double PriceSurrogate::NormalizedCall(double x, double s) const
+	{
+		int q = degree + 1;
+		double fx = (x - xMin) * invHx;
+		double fs = (s - sMin) * invHs;
+		double lastX = (double)(cellsX - 1);
+		double lastS = (double)(cellsS - 1);
+		fx = (fx > 0.0) ? fx : 0.0;
+		fs = (fs > 0.0) ? fs : 0.0;
+		int a = (int)((fx < lastX) ? fx : lastX);
+		int b = (int)((fs < lastS) ? fs : lastS);
+		double u = 2 * (fx - a) - 1;
+		double v = 2 * (fs - b) - 1;
+
+		// The switch depends on the surrogate only, so it is predicted perfectly
+		const double* c = &coef[(a * cellsS + b) * q * q];
+		switch (q)
+		{
+		case 6: return CellPolynomial<6>(c, u, v);
+		case 7: return CellPolynomial<7>(c, u, v);
+		case 8: return CellPolynomial<8>(c, u, v);
+		case 9: return CellPolynomial<9>(c, u, v);
+		default: return CellPolynomial(c, q, u, v);
+		}
+	}
+
+	double PriceSurrogate::CallPrice(double x, double s, double fwdS) const // function to calculate a call price from x, s and fwdS = S * exp(-q * T), exact outside the domain
+	{
+		return fwdS * (InDomain(x, s) ? NormalizedCall(x, s) : Exact(x, s));
+	}
+
+	double PriceSurrogate::EuroCallPrice(double T, double sig, double r, double q, double S, double K) const // function to calculate the price of a European call option, exact outside the domain
+	{
+		double s = sig * sqrt(T);
+		double x = (log(K / S) - (r - q) * T) / s;
+		if (!InDomain(x, s))
+		{
+			return EuroCallFormula(T, sig, r, q, S, K);
+		}
+		return S * exp(-q * T) * NormalizedCall(x, s);
+	}
+
+	double PriceSurrogate::EuroPutPrice(double T, double sig, double r, double q, double S, double K) const // function to calculate the price of a European put option by put-call parity, exact outside the domain
+	{
+		double s = sig * sqrt(T);
+		double x = (log(K / S) - (r - q) * T) / s;
+		if (!InDomain(x, s))
+		{
+			return EuroPutFormula(T, sig, r, q, S, K);
+		}
+		return S * exp(-q * T) * NormalizedCall(x, s) - S * exp(-q * T) + K * exp(-r * T);
+	}
+
+	// Function to price n European call and put options. Every contract of a block is evaluated branch free on the surrogate,
+	// then the (rare) contracts outside the domain are overwritten with the exact formula
+	void PriceSurrogate::EuroBatchPrice(const double* T, const double* sig, const double* r, const double* q, const double* S, const double* K, double* call, double* put, size_t n) const
+	{
+		double x[SurrogateBlock], s[SurrogateBlock], fwdS[SurrogateBlock], disK[SurrogateBlock];
+		int outside[SurrogateBlock];
+
+		for (size_t start = 0; start < n; start += SurrogateBlock)
+		{
+			size_t m = min(SurrogateBlock, n - start);
+			int misses = 0;
+
+			BATCH_LOOP
+			for (size_t i = 0; i < m; ++i)
+			{
+				size_t j = start + i;
+				s[i] = sig[j] * sqrt(T[j]);
+				x[i] = (log(K[j] / S[j]) - (r[j] - q[j]) * T[j]) / s[i];
+				fwdS[i] = S[j] * exp(-q[j] * T[j]);
+				disK[i] = K[j] * exp(-r[j] * T[j]);
+				outside[i] = (x[i] >= xMin && x[i] <= xMax && s[i] >= sMin && s[i] <= sMax) ? 0 : 1;
+				misses += outside[i];
+			}
+
+			for (size_t i = 0; i < m; ++i)
+			{
+				double c = coef.empty() ? 0.0 : fwdS[i] * NormalizedCall(x[i], s[i]);
+				call[start + i] = c;
+				put[start + i] = c - fwdS[i] + disK[i];
+			}
+
+			if (misses == 0 && !coef.empty())
+			{
+				continue;
+			}
+			for (size_t i = 0; i < m; ++i)
+			{
+				size_t j = start + i;
+				if (outside[i] || coef.empty())
+				{
+					call[j] = EuroCallFormula(T[j], sig[j], r[j], q[j], S[j], K[j]);
+					put[j] = EuroPutFormula(T[j], sig[j], r[j], q[j], S[j], K[j]);
+				}
+			}
+		}
+	}
+
+	// Function to write the surrogate as text, doubles in full precision
+	void PriceSurrogate::Save(ostream& out) const
+	{
+		streamsize precision = out.precision(numeric_limits<double>::max_digits10);
+		out << "PriceSurrogate 2" << endl;
+		out << xMin << " " << xMax << " " << cellsX << " " << sMin << " " << sMax << " " << cellsS << " " << degree << " " << maxError << " " << observedError << endl;
+		for (size_t i = 0; i < coef.size(); ++i)
+		{
+			out << coef[i] << ((i + 1) % (degree + 1) == 0 ? "\n" : " ");
+		}
+		out.precision(precision);
+	}
+
+	// Function to read a surrogate written by Save, false (and the surrogate unchanged) on malformed input. The cell counts are
+	// checked one by one before their product, so a corrupt header can neither overflow the table size nor allocate more than 1 MB.
+	// A table whose stored bound exceeds tolerance is rejected, and so is one that misses its stored bound on the check grid
+	bool PriceSurrogate::Load(istream& in, double tolerance)
+	{
+		string name;
+		int version = 0;
+		PriceSurrogate loaded;
+		if (!(in >> name >> version) || name != "PriceSurrogate" || version != 2)
+		{
+			return false;
+		}
+		if (!(in >> loaded.xMin >> loaded.xMax >> loaded.cellsX >> loaded.sMin >> loaded.sMax >> loaded.cellsS >> loaded.degree >> loaded.maxError >> loaded.observedError))
+		{
+			return false;
+		}
+		if (!(loaded.maxError <= tolerance))
+		{
+			return false;
+		}
+		if (loaded.cellsX == 0 || loaded.cellsS == 0 || loaded.degree < 0 || loaded.degree > SurrogateMaxDegree || !(loaded.xMax > loaded.xMin) || !(loaded.sMax > loaded.sMin))
+		{
+			return false;
+		}
+		size_t perCell = (loaded.degree + 1) * (loaded.degree + 1) * sizeof(double);
+		if (loaded.cellsX > SurrogateMaxBytes / perCell || loaded.cellsS > SurrogateMaxBytes / perCell || loaded.cellsX * loaded.cellsS > SurrogateMaxBytes / perCell)
+		{
+			return false;
+		}
+
+		loaded.coef.resize(loaded.cellsX * loaded.cellsS * (loaded.degree + 1) * (loaded.degree + 1));
+		for (size_t i = 0; i < loaded.coef.size(); ++i)
+		{
+			if (!(in >> loaded.coef[i]))
+			{
+				return false;
+			}
+		}
+		loaded.invHx = loaded.cellsX / (loaded.xMax - loaded.xMin);
+		loaded.invHs = loaded.cellsS / (loaded.sMax - loaded.sMin);
+		if (!(loaded.CheckError() <= loaded.maxError))
+		{
+			return false;
+		}
+		*this = loaded;
+		return true;
+	}
+}
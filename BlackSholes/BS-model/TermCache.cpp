@@ -0,0 +1,206 @@
+// Group A & B: Source file for a cache of zero rates, sqrt(T) and discount factors per (curve, expiry)
+
+#include "TermCache.h"
+#include <algorithm>
+#include <cmath>
+using namespace std;
+
+namespace Options
+{
+	const size_t TermBlock = 64; // contracts gathered per call of the batch kernels, so the scratch arrays stay in L1 cache
+
+	TermCache::TermCache() : generation(0) // default constructor
+	{}
+
+	TermCache::TermCache(const TermCache& source) : curveOf(source.curveOf), expiry(source.expiry), zero(source.zero), rootT(source.rootT), discount(source.discount),
+		stamp(source.stamp), index(source.index), curves(source.curves), generation(source.generation) // copy constructor
+	{}
+
+	TermCache::~TermCache() // destructor
+	{}
+
+	// Function to return the zero rate of the curve at T, linear between pillars and flat outside them
+	double TermCache::Interpolate(const Curve& c, double T)
+	{
+		size_t m = c.tenor.size();
+		if (m == 0) return 0.0;
+		if (T <= c.tenor[0]) return c.zero[0];
+		if (T >= c.tenor[m - 1]) return c.zero[m - 1];
+
+		size_t hi = upper_bound(c.tenor.begin(), c.tenor.end(), T) - c.tenor.begin();
+		size_t lo = hi - 1;
+		double w = (T - c.tenor[lo]) / (c.tenor[hi] - c.tenor[lo]);
+		return c.zero[lo] + w * (c.zero[hi] - c.zero[lo]);
+	}
+
+	// Function to set the zero rate of a term and recalculate its discount factor
+	void TermCache::Update(size_t term, double z)
+	{
+		zero[term] = z;
+		discount[term] = exp(-z * expiry[term]);
+		stamp[term] = generation;
+	}
+
+	// Function to return the term of (curve, T), adding it from the curve's pillars if new
+	size_t TermCache::Term(int curve, double T)
+	{
+		pair<int, double> key(curve, T);
+		auto it = index.find(key);
+		if (it != index.end()) return it->second;
+
+		size_t term = expiry.size();
+		Curve& c = curves[curve];
+		curveOf.push_back(curve);
+		expiry.push_back(T);
+		zero.push_back(0.0);
+		rootT.push_back(sqrt(T));
+		discount.push_back(1.0);
+		stamp.push_back(0);
+		c.terms.push_back(term);
+		index[key] = term;
+
+		++generation;
+		Update(term, Interpolate(c, T));
+		return term;
+	}
+
+	// Function to return the number of terms
+	size_t TermCache::Terms() const
+	{
+		return expiry.size();
+	}
+
+	// Function to return the number of terms on a curve
+	size_t TermCache::CurveTerms(int curve) const
+	{
+		auto it = curves.find(curve);
+		return it == curves.end() ? 0 : it->second.terms.size();
+	}
+
+	// Function to replace the pillars of a curve and recalculate its terms. tenor must be increasing and as long as zero
+	void TermCache::SetCurve(int curve, const vector<double>& tenor, const vector<double>& zeroRates)
+	{
+		Curve& c = curves[curve];
+		c.tenor = tenor;
+		c.zero = zeroRates;
+
+		++generation;
+		for (size_t t : c.terms)
+		{
+			Update(t, Interpolate(c, expiry[t]));
+		}
+	}
+
+	// Function to shift a curve in parallel by dz and recalculate its terms from the shifted pillars, which drops any override
+	void TermCache::ShiftCurve(int curve, double dz)
+	{
+		Curve& c = curves[curve];
+		for (double& z : c.zero)
+		{
+			z += dz;
+		}
+
+		++generation;
+		for (size_t t : c.terms)
+		{
+			Update(t, Interpolate(c, expiry[t]));
+		}
+	}
+
+	// Function to override the zero rate of one term; the override holds until the next SetCurve or ShiftCurve of its curve
+	void TermCache::SetZeroRate(size_t term, double z)
+	{
+		++generation;
+		Update(term, z);
+	}
+
+	// Function to return the curve of a term
+	int TermCache::CurveOf(size_t term) const
+	{
+		return curveOf[term];
+	}
+
+	// Function to return the expiry of a term
+	double TermCache::Expiry(size_t term) const
+	{
+		return expiry[term];
+	}
+
+	// Function to return the zero rate of a term
+	double TermCache::Zero(size_t term) const
+	{
+		return zero[term];
+	}
+
+	// Function to return sqrt(T) of a term
+	double TermCache::RootT(size_t term) const
+	{
+		return rootT[term];
+	}
+
+	// Function to return the discount factor of a term
+	double TermCache::Discount(size_t term) const
+	{
+		return discount[term];
+	}
+
+	// Function to return the generation of the last change of a term
+	unsigned TermCache::Stamp(size_t term) const
+	{
+		return stamp[term];
+	}
+
+	// Function to return the current generation, the stamp of the latest change
+	unsigned TermCache::Generation() const
+	{
+		return generation;
+	}
+
+	// Function to price n European call and put options, gathering the terms of each block into contiguous scratch arrays
+	void TermCache::EuroBatchPrice(const size_t* rateTerm, const size_t* divTerm, const double* sig, const double* S, const double* K, double* call, double* put, size_t n, CdfTier tier) const
+	{
+		double T[TermBlock], r[TermBlock], q[TermBlock], sqrtT[TermBlock], discR[TermBlock], discQ[TermBlock];
+
+		for (size_t start = 0; start < n; start += TermBlock)
+		{
+			size_t m = min(TermBlock, n - start);
+			for (size_t i = 0; i < m; ++i)
+			{
+				size_t a = rateTerm[start + i], b = divTerm[start + i];
+				T[i] = expiry[a];
+				sqrtT[i] = rootT[a];
+				r[i] = zero[a];
+				discR[i] = discount[a];
+				q[i] = zero[b];
+				discQ[i] = discount[b];
+			}
+
+			Options::EuroBatchPrice(T, sig + start, r, q, S + start, K + start, sqrtT, discR, discQ, call + start, put + start, m, tier);
+		}
+	}
+
+	// Function to calculate prices and first order Greeks of n call and put options, gathering the terms of each block as above
+	void TermCache::EuroBatchGreeks(const size_t* rateTerm, const size_t* divTerm, const double* sig, const double* S, const double* K, const EuroGreeksArrays& out, size_t n, CdfTier tier) const
+	{
+		double T[TermBlock], r[TermBlock], q[TermBlock], sqrtT[TermBlock], discR[TermBlock], discQ[TermBlock];
+
+		for (size_t start = 0; start < n; start += TermBlock)
+		{
+			size_t m = min(TermBlock, n - start);
+			for (size_t i = 0; i < m; ++i)
+			{
+				size_t a = rateTerm[start + i], b = divTerm[start + i];
+				T[i] = expiry[a];
+				sqrtT[i] = rootT[a];
+				r[i] = zero[a];
+				discR[i] = discount[a];
+				q[i] = zero[b];
+				discQ[i] = discount[b];
+			}
+
+			EuroGreeksArrays block = { out.CallPrice + start, out.PutPrice + start, out.CallDelta + start, out.PutDelta + start, out.Gamma + start, out.Vega + start,
+				out.CallTheta + start, out.PutTheta + start, out.CallRho + start, out.PutRho + start };
+			Options::EuroBatchGreeks(T, sig + start, r, q, S + start, K + start, sqrtT, discR, discQ, block, m, tier);
+		}
+	}
+}
@@ -0,0 +1,66 @@
+// Group A & B: Header file for a cache of zero rates, sqrt(T) and discount factors per (curve, expiry)
+
+#ifndef TermCacheHPP
+#define TermCacheHPP
+
+#include "EuroBatch.h"
+#include <vector>
+#include <map>
+#include <cstddef>
+using namespace std;
+
+namespace Options
+{
+	// Every (curve, expiry) pair a book uses is a term, numbered in order of creation. A term holds its zero rate, sqrt(T) and
+	// discount factor exp(-zero * T), so a contract refers to a rate term and a dividend term instead of carrying r and q, and
+	// its forward is S * Discount(dividend term) / Discount(rate term). A curve is a set of pillars with linear interpolation
+	// of the zero rate and flat extrapolation; an update recalculates only the terms of that curve, so it costs O(expiries)
+	// whatever the number of contracts. Each change stamps the terms it touched with a new generation
+	class TermCache
+	{
+		private:
+			struct Curve
+			{
+				vector<double> tenor, zero; // pillars in increasing tenor
+				vector<size_t> terms; // terms on this curve
+			};
+
+			vector<int> curveOf;
+			vector<double> expiry, zero, rootT, discount;
+			vector<unsigned> stamp; // generation of the last change of each term
+			map<pair<int, double>, size_t> index; // (curve, expiry) to term
+			map<int, Curve> curves;
+			unsigned generation;
+
+			static double Interpolate(const Curve& c, double T); // function to return the zero rate of the curve at T
+			void Update(size_t term, double z); // function to set the zero rate of a term and recalculate its discount factor
+
+		public:
+			TermCache(); // default constructor
+			TermCache(const TermCache& source); // copy constructor
+			~TermCache(); // destructor
+
+			size_t Term(int curve, double T); // function to return the term of (curve, T), adding it from the curve's pillars if new
+			size_t Terms() const; // function to return the number of terms
+			size_t CurveTerms(int curve) const; // function to return the number of terms on a curve
+
+			void SetCurve(int curve, const vector<double>& tenor, const vector<double>& zeroRates); // function to replace the pillars of a curve and recalculate its terms
+			void ShiftCurve(int curve, double dz); // function to shift a curve in parallel by dz and recalculate its terms
+			void SetZeroRate(size_t term, double z); // function to override the zero rate of one term until the next SetCurve or ShiftCurve of its curve
+
+			int CurveOf(size_t term) const; // function to return the curve of a term
+			double Expiry(size_t term) const; // function to return the expiry of a term
+			double Zero(size_t term) const; // function to return the zero rate of a term
+			double RootT(size_t term) const; // function to return sqrt(T) of a term
+			double Discount(size_t term) const; // function to return the discount factor of a term
+			unsigned Stamp(size_t term) const; // function to return the generation of the last change of a term
+			unsigned Generation() const; // function to return the current generation, the stamp of the latest change
+
+			// Batch pricers reading T, r, q, sqrt(T) and the discount factors from the terms, so no exp or sqrt is evaluated. Contract
+			// i uses rateTerm[i] and divTerm[i], which must share the same expiry
+			void EuroBatchPrice(const size_t* rateTerm, const size_t* divTerm, const double* sig, const double* S, const double* K, double* call, double* put, size_t n, CdfTier tier = CdfExact) const; // function to price n European call and put options
+			void EuroBatchGreeks(const size_t* rateTerm, const size_t* divTerm, const double* sig, const double* S, const double* K, const EuroGreeksArrays& out, size_t n, CdfTier tier = CdfExact) const; // function to calculate prices and first order Greeks of n call and put options
+	};
+}
+
+#endif
@@ -2,14 +2,1602 @@
 
 #include "EuroOption.h"
 #include "AmericanOption.h"
+#include "EuroBatch.h"
+#include "NormalCdf.h"
+#include "ImpliedVol.h"
+#include "ScenarioEngine.h"
+#include "Scheduler.h"
+#include "Ladder.h"
+#include "Aad.h"
+#include "EuroFormula.h"
+#include "AmericanBatch.h"
+#include "Surrogate.h"
+#include "Portfolio.h"
+#include "TermCache.h"
+#include "TickEngine.h"
+#include "Arbitrage.h"
+#include "VolSurface.h"
+#include <sstream>
+#include <cstring>
 #include <iostream>
 #include <cmath>
 #include <boost/math/distributions/normal.hpp>
 #include <vector>
+#include <chrono>
+#include <thread>
 using namespace std;
 using namespace boost::math;
 using namespace Options;
 
+// Contract terms of a test book held as structure of arrays
+struct TestBook
+{
+	vector<double> T, sig, r, q, S, K;
+	size_t size() const { return T.size(); }
+};
+
+// Grid of maturities 0.25 to 2.0, volatilities 0.1 to 0.6 and strikes 50 to 150 on a spot of 100
+TestBook MakeTestBook()
+{
+	TestBook b;
+	for (int i = 1; i <= 8; ++i)
+	{
+		for (int j = 1; j <= 6; ++j)
+		{
+			for (int k = 0; k < 21; ++k)
+			{
+				b.T.push_back(0.25 * i); b.sig.push_back(0.1 * j); b.r.push_back(0.05); b.q.push_back(0.02); b.S.push_back(100); b.K.push_back(50 + 5 * k);
+			}
+		}
+	}
+	return b;
+}
+
+// Reference put price in long double from N(-d) = erfc(d / sqrt(2)) / 2, for deep out of the money puts whose value
+// 1 - N(d) would lose
+double ReferencePut(double T, double sig, double r, double q, double S, double K)
+{
+	long double sigSqrtT = (long double)sig * sqrtl(T);
+	long double d1 = (logl((long double)S / K) + ((long double)r - q + (long double)sig * sig / 2) * T) / sigSqrtT;
+	long double d2 = d1 - sigSqrtT;
+	return (double)(K * expl(-(long double)r * T) * erfcl(d2 / sqrtl(2.0L)) / 2 - S * expl(-(long double)q * T) * erfcl(d1 / sqrtl(2.0L)) / 2);
+}
+
+// Deep out of the money puts on a spot of 100, T = 0.25, sig = 0.2, r = 0.05, strikes 50 down to 30 (prices 8e-13 to 1e-34)
+TestBook MakeDeepPutBook()
+{
+	TestBook b;
+	for (int k = 0; k < 5; ++k)
+	{
+		b.T.push_back(0.25); b.sig.push_back(0.2); b.r.push_back(0.05); b.q.push_back(0.0); b.S.push_back(100); b.K.push_back(50 - 5 * k);
+	}
+	return b;
+}
+
+// Compare the batch pricer with EuroOption over a grid of contracts, both the vectorised and the scalar path
+void TestEuroBatch()
+{
+	TestBook b = MakeTestBook();
+	size_t n = b.size();
+	vector<double> call(n), put(n), callScalar(n), putScalar(n);
+	EuroBatchPrice(&b.T[0], &b.sig[0], &b.r[0], &b.q[0], &b.S[0], &b.K[0], &call[0], &put[0], n);
+	EuroBatchPriceScalar(&b.T[0], &b.sig[0], &b.r[0], &b.q[0], &b.S[0], &b.K[0], &callScalar[0], &putScalar[0], n);
+
+	double maxErr = 0.0, maxErrScalar = 0.0;
+	for (size_t i = 0; i < n; ++i)
+	{
+		EuroOption op(b.T[i], b.sig[i], b.r[i], b.q[i], b.S[i], b.K[i]);
+		maxErr = max(maxErr, max(fabs(call[i] - op.EuroCallPrice()), fabs(put[i] - op.EuroPutPrice())));
+		maxErrScalar = max(maxErrScalar, max(fabs(callScalar[i] - op.EuroCallPrice()), fabs(putScalar[i] - op.EuroPutPrice())));
+	}
+
+	cout << "Batch pricing of " << n << " European options - " << endl;
+	cout << "Max difference to EuroOption, vectorised path: " << maxErr << (maxErr < 1e-12 ? " (ok)" : " (FAILED)") << endl;
+	cout << "Max difference to EuroOption, scalar path: " << maxErrScalar << (maxErrScalar < 1e-12 ? " (ok)" : " (FAILED)") << endl;
+
+	// Deep out of the money puts, relative to their own size. Only the Exact tier is relatively accurate in the far tail,
+	// Risk and Sweep keep their absolute bounds there
+	TestBook d = MakeDeepPutBook();
+	vector<double> dCall(d.size()), dPut(d.size());
+	EuroBatchPrice(&d.T[0], &d.sig[0], &d.r[0], &d.q[0], &d.S[0], &d.K[0], &dCall[0], &dPut[0], d.size());
+	double maxRel = 0.0;
+	for (size_t i = 0; i < d.size(); ++i)
+	{
+		maxRel = max(maxRel, fabs(dPut[i] / ReferencePut(d.T[i], d.sig[i], d.r[i], d.q[i], d.S[i], d.K[i]) - 1));
+	}
+	cout << "Max relative error of deep out of the money puts: " << maxRel << (maxRel < 1e-12 ? " (ok)" : " (FAILED)") << endl;
+}
+
+// Compare the fused price and Greeks (single contract and batch) with the individual EuroOption functions
+void TestAllGreeks()
+{
+	TestBook b = MakeTestBook();
+	size_t n = b.size();
+	vector<double> cp(n), pp(n), cd(n), pd(n), ga(n), ve(n), ct(n), pt(n), cr(n), pr(n);
+	EuroGreeksArrays out = { &cp[0], &pp[0], &cd[0], &pd[0], &ga[0], &ve[0], &ct[0], &pt[0], &cr[0], &pr[0] };
+	EuroBatchGreeks(&b.T[0], &b.sig[0], &b.r[0], &b.q[0], &b.S[0], &b.K[0], out, n);
+
+	double maxErr = 0.0, maxErrBatch = 0.0, maxErrRho = 0.0;
+	for (size_t i = 0; i < n; ++i)
+	{
+		EuroOption op(b.T[i], b.sig[i], b.r[i], b.q[i], b.S[i], b.K[i]);
+		EuroGreeks g = op.AllGreeks();
+
+		double single[] = { op.EuroCallPrice(), op.EuroPutPrice(), op.CallDelta(), op.PutDelta(), op.Gamma(), op.Vega(), op.CallTheta(), op.PutTheta() };
+		double fused[] = { g.CallPrice, g.PutPrice, g.CallDelta, g.PutDelta, g.Gamma, g.Vega, g.CallTheta, g.PutTheta };
+		double batch[] = { cp[i], pp[i], cd[i], pd[i], ga[i], ve[i], ct[i], pt[i] };
+		for (int k = 0; k < 8; ++k)
+		{
+			maxErr = max(maxErr, fabs(fused[k] - single[k]));
+			maxErrBatch = max(maxErrBatch, fabs(batch[k] - single[k]));
+		}
+		maxErrBatch = max(maxErrBatch, max(fabs(cr[i] - g.CallRho), fabs(pr[i] - g.PutRho)));
+
+		// Rho has no single function, check it against a central difference in the rate
+		double h = 1e-5;
+		EuroOption up(op), down(op);
+		up.SetRate(b.r[i] + h);
+		down.SetRate(b.r[i] - h);
+		maxErrRho = max(maxErrRho, fabs(g.CallRho - (up.EuroCallPrice() - down.EuroCallPrice()) / (2 * h)));
+		maxErrRho = max(maxErrRho, fabs(g.PutRho - (up.EuroPutPrice() - down.EuroPutPrice()) / (2 * h)));
+	}
+
+	cout << "Fused price and Greeks of " << n << " European options - " << endl;
+	cout << "Max difference of AllGreeks to the single functions: " << maxErr << (maxErr < 1e-10 ? " (ok)" : " (FAILED)") << endl;
+	cout << "Max difference of EuroBatchGreeks to the single functions: " << maxErrBatch << (maxErrBatch < 1e-10 ? " (ok)" : " (FAILED)") << endl;
+	cout << "Max difference of rho to a central difference: " << maxErrRho << (maxErrRho < 1e-4 ? " (ok)" : " (FAILED)") << endl;
+
+	// Deep out of the money puts, relative to their own size, from the batch kernel and the pure AllGreeks
+	TestBook d = MakeDeepPutBook();
+	size_t nd = d.size();
+	vector<double> dcp(nd), dpp(nd), dcd(nd), dpd(nd), dga(nd), dve(nd), dct(nd), dpt(nd), dcr(nd), dpr(nd);
+	EuroGreeksArrays dOut = { &dcp[0], &dpp[0], &dcd[0], &dpd[0], &dga[0], &dve[0], &dct[0], &dpt[0], &dcr[0], &dpr[0] };
+	EuroBatchGreeks(&d.T[0], &d.sig[0], &d.r[0], &d.q[0], &d.S[0], &d.K[0], dOut, nd);
+	double maxRel = 0.0;
+	for (size_t i = 0; i < nd; ++i)
+	{
+		EuroParams p = { d.T[i], d.sig[i], d.r[i], d.q[i], d.S[i], d.K[i] };
+		double ref = ReferencePut(d.T[i], d.sig[i], d.r[i], d.q[i], d.S[i], d.K[i]);
+		EuroOption op(d.T[i], d.sig[i], d.r[i], d.q[i], d.S[i], d.K[i]);
+		maxRel = max(maxRel, max(fabs(dpp[i] / ref - 1), fabs(EuroOption::AllGreeks(p).PutPrice / ref - 1)));
+		maxRel = max(maxRel, max(fabs(op.EuroPutPrice() / ref - 1), fabs(op.AllGreeks().PutPrice / ref - 1)));
+	}
+	cout << "Max relative error of deep out of the money puts: " << maxRel << (maxRel < 1e-12 ? " (ok)" : " (FAILED)") << endl;
+}
+
+// Check the higher order Greeks against central differences of the batch first order Greeks and time the extra cost of them
+void TestHigherGreeks()
+{
+	TestBook b = MakeTestBook();
+	size_t n = b.size();
+	vector<double> cp(n), pp(n), cd(n), pd(n), ga(n), ve(n), ct(n), pt(n), cr(n), pr(n);
+	vector<double> va(n), vo(n), cc(n), pc(n), sp(n), co(n);
+	EuroGreeksArrays out = { &cp[0], &pp[0], &cd[0], &pd[0], &ga[0], &ve[0], &ct[0], &pt[0], &cr[0], &pr[0] };
+	EuroHigherGreeksArrays higher = { &va[0], &vo[0], &cc[0], &pc[0], &sp[0], &co[0] };
+	EuroBatchGreeks(&b.T[0], &b.sig[0], &b.r[0], &b.q[0], &b.S[0], &b.K[0], out, higher, n);
+
+	// Bumped first order Greeks, one bump of each parameter up and down
+	vector<double> ucp(n), upp(n), ucd(n), upd(n), uga(n), uve(n), uct(n), upt(n), ucr(n), upr(n);
+	vector<double> dcp(n), dpp(n), dcd(n), dpd(n), dga(n), dve(n), dct(n), dpt(n), dcr(n), dpr(n);
+	EuroGreeksArrays up = { &ucp[0], &upp[0], &ucd[0], &upd[0], &uga[0], &uve[0], &uct[0], &upt[0], &ucr[0], &upr[0] };
+	EuroGreeksArrays down = { &dcp[0], &dpp[0], &dcd[0], &dpd[0], &dga[0], &dve[0], &dct[0], &dpt[0], &dcr[0], &dpr[0] };
+
+	double hSig = 1e-5, hS = 1e-3, hT = 1e-5;
+	double errVanna = 0.0, errVolga = 0.0, errSpeed = 0.0, errCharm = 0.0, errColor = 0.0;
+	vector<double> bumped(n);
+
+	for (size_t i = 0; i < n; ++i) bumped[i] = b.sig[i] + hSig;
+	EuroBatchGreeks(&b.T[0], &bumped[0], &b.r[0], &b.q[0], &b.S[0], &b.K[0], up, n);
+	for (size_t i = 0; i < n; ++i) bumped[i] = b.sig[i] - hSig;
+	EuroBatchGreeks(&b.T[0], &bumped[0], &b.r[0], &b.q[0], &b.S[0], &b.K[0], down, n);
+	for (size_t i = 0; i < n; ++i)
+	{
+		errVanna = max(errVanna, fabs(va[i] - (ucd[i] - dcd[i]) / (2 * hSig)));
+		errVanna = max(errVanna, fabs(va[i] - (upd[i] - dpd[i]) / (2 * hSig)));
+		errVolga = max(errVolga, fabs(vo[i] - (uve[i] - dve[i]) / (2 * hSig)) / max(1.0, fabs(vo[i])));
+	}
+
+	for (size_t i = 0; i < n; ++i) bumped[i] = b.S[i] + hS;
+	EuroBatchGreeks(&b.T[0], &b.sig[0], &b.r[0], &b.q[0], &bumped[0], &b.K[0], up, n);
+	for (size_t i = 0; i < n; ++i) bumped[i] = b.S[i] - hS;
+	EuroBatchGreeks(&b.T[0], &b.sig[0], &b.r[0], &b.q[0], &bumped[0], &b.K[0], down, n);
+	for (size_t i = 0; i < n; ++i)
+	{
+		errSpeed = max(errSpeed, fabs(sp[i] - (uga[i] - dga[i]) / (2 * hS)));
+	}
+
+	// Charm and color are rates in calendar time, so minus the derivative in T
+	for (size_t i = 0; i < n; ++i) bumped[i] = b.T[i] + hT;
+	EuroBatchGreeks(&bumped[0], &b.sig[0], &b.r[0], &b.q[0], &b.S[0], &b.K[0], up, n);
+	for (size_t i = 0; i < n; ++i) bumped[i] = b.T[i] - hT;
+	EuroBatchGreeks(&bumped[0], &b.sig[0], &b.r[0], &b.q[0], &b.S[0], &b.K[0], down, n);
+	for (size_t i = 0; i < n; ++i)
+	{
+		errCharm = max(errCharm, fabs(cc[i] + (ucd[i] - dcd[i]) / (2 * hT)));
+		errCharm = max(errCharm, fabs(pc[i] + (upd[i] - dpd[i]) / (2 * hT)));
+		errColor = max(errColor, fabs(co[i] + (uga[i] - dga[i]) / (2 * hT)));
+	}
+
+	// Cost of the full risk vector relative to prices alone
+	const int reps = 200;
+	double seconds[3];
+	for (int k = 0; k < 3; ++k)
+	{
+		auto begin = chrono::high_resolution_clock::now();
+		for (int rep = 0; rep < reps; ++rep)
+		{
+			if (k == 0) EuroBatchPrice(&b.T[0], &b.sig[0], &b.r[0], &b.q[0], &b.S[0], &b.K[0], &cp[0], &pp[0], n);
+			else if (k == 1) EuroBatchGreeks(&b.T[0], &b.sig[0], &b.r[0], &b.q[0], &b.S[0], &b.K[0], out, n);
+			else EuroBatchGreeks(&b.T[0], &b.sig[0], &b.r[0], &b.q[0], &b.S[0], &b.K[0], out, higher, n);
+		}
+		seconds[k] = chrono::duration<double>(chrono::high_resolution_clock::now() - begin).count();
+	}
+
+	cout << "Higher order Greeks of " << n << " European options against central differences - " << endl;
+	cout << "Vanna: " << errVanna << (errVanna < 1e-6 ? " (ok)" : " (FAILED)") << endl;
+	cout << "Volga (relative): " << errVolga << (errVolga < 1e-6 ? " (ok)" : " (FAILED)") << endl;
+	cout << "Speed: " << errSpeed << (errSpeed < 1e-8 ? " (ok)" : " (FAILED)") << endl;
+	cout << "Charm: " << errCharm << (errCharm < 1e-6 ? " (ok)" : " (FAILED)") << endl;
+	cout << "Color: " << errColor << (errColor < 1e-6 ? " (ok)" : " (FAILED)") << endl;
+	cout << "ns per contract - prices: " << seconds[0] * 1e9 / (reps * n) << ", first order Greeks: " << seconds[1] * 1e9 / (reps * n)
+		<< ", first and higher order Greeks: " << seconds[2] * 1e9 / (reps * n) << endl;
+}
+
+// Gradient of a strip of calls on one underlying with respect to every input by a reverse sweep, checked against the
+// analytic Greeks and timed against bump-and-reprice with CallDeltaApx and GammaApx
+void TestAad()
+{
+	TestBook b = MakeTestBook();
+	size_t n = b.size();
+	double S = b.S[0], r = b.r[0], q = b.q[0];
+
+	// Value of the strip in doubles
+	const int reps = 20;
+	double value = 0.0;
+	auto begin = chrono::high_resolution_clock::now();
+	for (int rep = 0; rep < reps; ++rep)
+	{
+		value = 0.0;
+		for (size_t i = 0; i < n; ++i)
+		{
+			value += EuroCallFormula(b.T[i], b.sig[i], r, q, S, b.K[i]);
+		}
+	}
+	double valueSeconds = chrono::duration<double>(chrono::high_resolution_clock::now() - begin).count() / reps;
+
+	// Value and gradient by AAD. The shared inputs are recorded once; each call is recorded after a checkpoint, swept back
+	// to it and rewound, so the tape never holds more than one call
+	Tape tape;
+	SetActiveTape(&tape);
+	vector<double> dT(n), dSig(n), dK(n);
+	double aadValue = 0.0, dS = 0.0, dR = 0.0, dQ = 0.0;
+	size_t peak = 0;
+	begin = chrono::high_resolution_clock::now();
+	for (int rep = 0; rep < reps; ++rep)
+	{
+		tape.Clear();
+		AReal aS(S), aR(r), aQ(q);
+		size_t mark = tape.Mark();
+		aadValue = 0.0;
+		for (size_t i = 0; i < n; ++i)
+		{
+			AReal aT(b.T[i]), aSig(b.sig[i]), aK(b.K[i]);
+			AReal call = EuroCallFormula(aT, aSig, aR, aQ, aS, aK);
+			aadValue += call.Value();
+			call.Seed(1.0);
+			tape.Propagate(mark);
+			dT[i] = aT.Adjoint(); dSig[i] = aSig.Adjoint(); dK[i] = aK.Adjoint();
+			peak = max(peak, tape.Size());
+			tape.Rewind(mark);
+		}
+		dS = aS.Adjoint(); dR = aR.Adjoint(); dQ = aQ.Adjoint();
+	}
+	double aadSeconds = chrono::duration<double>(chrono::high_resolution_clock::now() - begin).count() / reps;
+	SetActiveTape(0);
+
+	// Reference sensitivities: analytic Greeks from the batch kernel, strike and dividend sensitivities by central differences
+	vector<double> cp(n), pp(n), cd(n), pd(n), ga(n), ve(n), ct(n), pt(n), cr(n), pr(n);
+	EuroGreeksArrays out = { &cp[0], &pp[0], &cd[0], &pd[0], &ga[0], &ve[0], &ct[0], &pt[0], &cr[0], &pr[0] };
+	EuroBatchGreeks(&b.T[0], &b.sig[0], &b.r[0], &b.q[0], &b.S[0], &b.K[0], out, n);
+	double refS = 0.0, refR = 0.0, refQ = 0.0, errPer = 0.0, h = 1e-5;
+	for (size_t i = 0; i < n; ++i)
+	{
+		refS += cd[i]; refR += cr[i];
+		refQ += (EuroCallFormula(b.T[i], b.sig[i], r, q + h, S, b.K[i]) - EuroCallFormula(b.T[i], b.sig[i], r, q - h, S, b.K[i])) / (2 * h);
+		double refK = (EuroCallFormula(b.T[i], b.sig[i], r, q, S, b.K[i] + h) - EuroCallFormula(b.T[i], b.sig[i], r, q, S, b.K[i] - h)) / (2 * h);
+		errPer = max(errPer, max(fabs(dSig[i] - ve[i]), fabs(dT[i] + ct[i])));
+		errPer = max(errPer, fabs(dK[i] - refK) * 1e-3); // the central difference itself is only good to about 1e-8
+	}
+	double errShared = max(fabs(dS - refS) / fabs(refS), max(fabs(dR - refR) / fabs(refR), fabs(dQ - refQ) / fabs(refQ) * 1e-3)); // relative, the sums run over n calls
+
+	// Bump-and-reprice: portfolio delta and gamma by CallDeltaApx and GammaApx on each call, and the full gradient by central
+	// differences in each of the 3n + 3 inputs
+	vector<EuroOption> book;
+	for (size_t i = 0; i < n; ++i)
+	{
+		book.push_back(EuroOption(b.T[i], b.sig[i], r, q, S, b.K[i]));
+	}
+	double bumpDelta = 0.0, bumpGamma = 0.0, bumpGrad = 0.0;
+	begin = chrono::high_resolution_clock::now();
+	for (int rep = 0; rep < reps; ++rep)
+	{
+		bumpDelta = 0.0;
+		for (size_t i = 0; i < n; ++i)
+		{
+			bumpDelta += book[i].CallDeltaApx(S, 1e-4);
+		}
+	}
+	double deltaSeconds = chrono::duration<double>(chrono::high_resolution_clock::now() - begin).count() / reps;
+	begin = chrono::high_resolution_clock::now();
+	for (int rep = 0; rep < reps; ++rep)
+	{
+		bumpGamma = 0.0;
+		for (size_t i = 0; i < n; ++i)
+		{
+			bumpGamma += book[i].GammaApx(S, 1e-2);
+		}
+	}
+	double gammaSeconds = chrono::duration<double>(chrono::high_resolution_clock::now() - begin).count() / reps;
+	begin = chrono::high_resolution_clock::now();
+	for (int rep = 0; rep < reps; ++rep)
+	{
+		bumpGrad = 0.0;
+		for (size_t i = 0; i < n; ++i)
+		{
+			double T = b.T[i], sig = b.sig[i], K = b.K[i];
+			bumpGrad += EuroCallFormula(T + h, sig, r, q, S, K) - EuroCallFormula(T - h, sig, r, q, S, K);
+			bumpGrad += EuroCallFormula(T, sig + h, r, q, S, K) - EuroCallFormula(T, sig - h, r, q, S, K);
+			bumpGrad += EuroCallFormula(T, sig, r, q, S, K + h) - EuroCallFormula(T, sig, r, q, S, K - h);
+			bumpGrad += EuroCallFormula(T, sig, r + h, q, S, K) - EuroCallFormula(T, sig, r - h, q, S, K);
+			bumpGrad += EuroCallFormula(T, sig, r, q + h, S, K) - EuroCallFormula(T, sig, r, q - h, S, K);
+			bumpGrad += EuroCallFormula(T, sig, r, q, S + h, K) - EuroCallFormula(T, sig, r, q, S - h, K);
+		}
+	}
+	double gradSeconds = chrono::duration<double>(chrono::high_resolution_clock::now() - begin).count() / reps;
+
+	// A thread that never set a tape records on its default one
+	double workerValue = -1.0, workerGrad = -1.0;
+	thread worker([&workerValue, &workerGrad]()
+	{
+		AReal zero, x(1.5);
+		AReal y = x * x + exp(x) + zero;
+		y.Seed(1.0);
+		ActiveTape->Propagate();
+		workerValue = y.Value();
+		workerGrad = x.Adjoint();
+	});
+	worker.join();
+	double workerErr = max(fabs(workerValue - (2.25 + std::exp(1.5))), fabs(workerGrad - (3.0 + std::exp(1.5))));
+
+	cout << "Adjoint gradient of a strip of " << n << " calls with respect to " << 3 * n + 3 << " inputs - " << endl;
+	cout << "Value difference to double pricing: " << fabs(aadValue - value) << (fabs(aadValue - value) < 1e-9 ? " (ok)" : " (FAILED)") << endl;
+	cout << "Max difference of vega, theta and strike sensitivity per call: " << errPer << (errPer < 1e-9 ? " (ok)" : " (FAILED)") << endl;
+	cout << "Max relative difference of spot, rate and dividend sensitivity of the strip: " << errShared << (errShared < 1e-9 ? " (ok)" : " (FAILED)") << endl;
+	cout << "Strip delta by AAD " << dS << ", by CallDeltaApx " << bumpDelta << endl;
+	cout << "Peak tape size: " << peak << " nodes" << endl;
+	cout << "Value and derivative recorded on the default tape of a second thread: " << workerErr << (workerErr < 1e-12 ? " (ok)" : " (FAILED)") << endl;
+	cout << "Time in multiples of one valuation (" << valueSeconds * 1e6 << " us) - AAD value and gradient: " << aadSeconds / valueSeconds
+		<< ", CallDeltaApx delta only: " << deltaSeconds / valueSeconds << ", GammaApx gamma only: " << gammaSeconds / valueSeconds
+		<< ", bumped gradient: " << gradSeconds / valueSeconds << endl;
+}
+
+// Reference American price on a Cox-Ross-Rubinstein tree, type 1 == call, -1 == put
+double AmericanTree(int type, double T, double sig, double r, double q, double S, double K, int steps)
+{
+	double dt = T / steps;
+	double u = exp(sig * sqrt(dt));
+	double p = (exp((r - q) * dt) - 1 / u) / (u - 1 / u);
+	double disc = exp(-r * dt);
+	vector<double> value(steps + 1);
+	for (int i = 0; i <= steps; ++i)
+	{
+		value[i] = max(type * (S * pow(u, 2 * i - steps) - K), 0.0);
+	}
+	for (int step = steps - 1; step >= 0; --step)
+	{
+		for (int i = 0; i <= step; ++i)
+		{
+			double cont = disc * (p * value[i + 1] + (1 - p) * value[i]);
+			value[i] = max(cont, type * (S * pow(u, 2 * i - step) - K));
+		}
+	}
+	return value[0];
+}
+
+// Compare the finite maturity American approximations with a binomial tree (they are a few percent off for long dated, high
+// volatility contracts), compare the perpetual limit with AmericanOption and time a book of 500,000 contracts
+void TestAmericanBatch()
+{
+	const char* names[] = { "Barone-Adesi-Whaley", "Bjerksund-Stensland" };
+	AmericanApprox approx[] = { AmBaroneAdesiWhaley, AmBjerksundStensland };
+
+	// Every 7th contract of the test book, against a 2000 step tree
+	TestBook full = MakeTestBook();
+	TestBook b;
+	for (size_t i = 0; i < full.size(); i += 7)
+	{
+		b.T.push_back(full.T[i]); b.sig.push_back(full.sig[i]); b.r.push_back(full.r[i]); b.q.push_back(full.q[i]); b.S.push_back(full.S[i]); b.K.push_back(full.K[i]);
+	}
+	size_t n = b.size();
+	vector<double> treeCall(n), treePut(n), call(n), put(n), eurCall(n), eurPut(n);
+	for (size_t i = 0; i < n; ++i)
+	{
+		treeCall[i] = AmericanTree(1, b.T[i], b.sig[i], b.r[i], b.q[i], b.S[i], b.K[i], 2000);
+		treePut[i] = AmericanTree(-1, b.T[i], b.sig[i], b.r[i], b.q[i], b.S[i], b.K[i], 2000);
+	}
+	EuroBatchPrice(&b.T[0], &b.sig[0], &b.r[0], &b.q[0], &b.S[0], &b.K[0], &eurCall[0], &eurPut[0], n);
+
+	cout << "Finite maturity American options, " << n << " contracts against a 2000 step binomial tree - " << endl;
+	for (int a = 0; a < 2; ++a)
+	{
+		AmericanBatchPrice(&b.T[0], &b.sig[0], &b.r[0], &b.q[0], &b.S[0], &b.K[0], &call[0], &put[0], n, approx[a]);
+		double maxErr = 0.0, maxRel = 0.0;
+		bool bounds = true;
+		for (size_t i = 0; i < n; ++i)
+		{
+			maxErr = max(maxErr, max(fabs(call[i] - treeCall[i]), fabs(put[i] - treePut[i])));
+			maxRel = max(maxRel, max(fabs(call[i] - treeCall[i]) / max(treeCall[i], 1.0), fabs(put[i] - treePut[i]) / max(treePut[i], 1.0))); // absolute below a price of 1
+			bounds = bounds && call[i] >= eurCall[i] - 1e-12 && put[i] >= eurPut[i] - 1e-12;
+			bounds = bounds && call[i] >= b.S[i] - b.K[i] - 1e-12 && put[i] >= b.K[i] - b.S[i] - 1e-12;
+		}
+		cout << names[a] << ": max abs difference " << maxErr << ", max relative difference " << maxRel << (maxRel < 0.05 ? " (ok)" : " (FAILED)")
+			<< ", above European and intrinsic" << (bounds ? " (ok)" : " (FAILED)") << endl;
+	}
+
+	// A very long maturity approaches the perpetual option priced by AmericanOption
+	double T = 5000, sig = 0.3, r = 0.08, q = 0.04, K = 100;
+	double spots[] = { 80, 100, 120 }; // inside both exercise boundaries, where the perpetual formula applies
+	double maxPerp = 0.0;
+	for (int k = 0; k < 3; ++k)
+	{
+		AmericanOption perp(sig, r, r - q, spots[k], K);
+		double c, p;
+		AmericanBatchPrice(&T, &sig, &r, &q, &spots[k], &K, &c, &p, 1);
+		maxPerp = max(maxPerp, max(fabs(c - perp.AmCallPrice()), fabs(p - perp.AmPutPrice())));
+	}
+	cout << "Max difference of Barone-Adesi-Whaley at T = " << T << " to the perpetual AmericanOption: " << maxPerp << (maxPerp < 1e-6 ? " (ok)" : " (FAILED)") << endl;
+
+	// Throughput on 500,000 contracts, the test book repeated
+	size_t big = 500000;
+	TestBook book;
+	for (size_t i = 0; i < big; ++i)
+	{
+		size_t j = i % full.size();
+		book.T.push_back(full.T[j]); book.sig.push_back(full.sig[j]); book.r.push_back(full.r[j]); book.q.push_back(full.q[j]); book.S.push_back(full.S[j] * (1 + 1e-6 * (i / full.size()))); book.K.push_back(full.K[j]);
+	}
+	vector<double> bigCall(big), bigPut(big);
+	const char* tierNames[] = { "Exact", "Risk" };
+	CdfTier tiers[] = { CdfExact, CdfRisk };
+	for (int a = 0; a < 2; ++a)
+	{
+		for (int t = 0; t < 2; ++t)
+		{
+			auto begin = chrono::high_resolution_clock::now();
+			AmericanBatchPrice(&book.T[0], &book.sig[0], &book.r[0], &book.q[0], &book.S[0], &book.K[0], &bigCall[0], &bigPut[0], big, approx[a], tiers[t]);
+			double seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - begin).count();
+			cout << names[a] << " (" << tierNames[t] << " cdf): " << big << " calls and puts in " << seconds << " s on one thread" << endl;
+		}
+	}
+}
+
+// Benchmark the perpetual American pricing path that shares y1 and y2 across scenarios against the original formula,
+// which evaluates y1() or y2() three times and a pow per price, as the spot grid grows
+void TestPerpetualExponents()
+{
+	double sig = 0.1, r = 0.1, B = 0.02, K = 100;
+	AmericanOption am(sig, r, B, 110, K);
+	double vols[] = { 0.1, 0.2, 0.3, 0.4 }; // a multi-factor sweep: every spot of the grid under four volatilities
+
+	cout << "Perpetual American options over a spot grid under 4 volatilities - " << endl;
+	cout << setw(12) << "Spots" << setw(24) << "Original ns/price" << setw(24) << "Cached ns/price" << setw(12) << "Speedup" << setw(22) << "Max rel. difference" << endl;
+	for (size_t spots = 10; spots <= 1000000; spots *= 10)
+	{
+		size_t n = 4 * spots;
+		vector<double> vol(n), rate(n, r), carry(n, B), underlying(n), strike(n, K), call(n), put(n), refCall(n), refPut(n);
+		for (size_t i = 0; i < n; ++i)
+		{
+			vol[i] = vols[i / spots];
+			underlying[i] = 50 + 50.0 * (i % spots) / spots;
+		}
+
+		auto begin = chrono::high_resolution_clock::now();
+		for (size_t i = 0; i < n; ++i)
+		{
+			AmericanOption op(vol[i], rate[i], carry[i], underlying[i], strike[i]);
+			refCall[i] = (K / (op.y1() - 1)) * pow(((underlying[i] / K) * ((op.y1() - 1) / op.y1())), op.y1());
+			refPut[i] = (K / (1 - op.y2())) * pow(((underlying[i] / K) * ((op.y2() - 1) / op.y2())), op.y2());
+		}
+		double original = chrono::duration<double, nano>(chrono::high_resolution_clock::now() - begin).count() / n;
+
+		begin = chrono::high_resolution_clock::now();
+		AmericanOption::PerpetualBatch(vol.data(), rate.data(), carry.data(), underlying.data(), strike.data(), call.data(), put.data(), n);
+		double cached = chrono::duration<double, nano>(chrono::high_resolution_clock::now() - begin).count() / n;
+
+		double maxErr = 0.0;
+		for (size_t i = 0; i < n; ++i)
+		{
+			maxErr = max(maxErr, max(fabs(call[i] / refCall[i] - 1), fabs(put[i] / refPut[i] - 1)));
+		}
+		cout << setw(12) << spots << setw(24) << original << setw(24) << cached << setw(12) << original / cached << setw(16) << maxErr << (maxErr < 1e-12 ? " (ok)" : " (FAILED)") << endl;
+	}
+}
+
+// Build the price surrogate, check its observed error with a margin of 2 on random contracts, the exact fallback outside its domain and a
+// save/load round trip, and time it against the closed form
+void TestSurrogate()
+{
+	auto begin = chrono::high_resolution_clock::now();
+	const double tolerance = 1e-7;
+	PriceSurrogate sur(-5.0, 5.0, 12, 0.005, 1.0, 6, 6, tolerance);
+	double buildSeconds = chrono::duration<double>(chrono::high_resolution_clock::now() - begin).count();
+
+	// Random contracts, most of them inside the domain
+	size_t n = 100000;
+	vector<double> T(n), sig(n), r(n), q(n), S(n), K(n), call(n), put(n);
+	unsigned long long state = 12345;
+	auto uniform = [&state]() { state = state * 6364136223846793005ULL + 1442695040888963407ULL; return (state >> 11) * (1.0 / 9007199254740992.0); };
+	for (size_t i = 0; i < n; ++i)
+	{
+		T[i] = 0.02 + 2.0 * uniform(); sig[i] = 0.05 + 0.6 * uniform(); r[i] = 0.1 * uniform(); q[i] = 0.05 * uniform(); S[i] = 100; K[i] = 40 + 120 * uniform();
+	}
+	sur.EuroBatchPrice(&T[0], &sig[0], &r[0], &q[0], &S[0], &K[0], &call[0], &put[0], n);
+
+	double worst = 0.0, worstOutside = 0.0, worstScalar = 0.0;
+	size_t inside = 0;
+	for (size_t i = 0; i < n; ++i)
+	{
+		double s = sig[i] * sqrt(T[i]);
+		double x = (log(K[i] / S[i]) - (r[i] - q[i]) * T[i]) / s;
+		double scale = S[i] * exp(-q[i] * T[i]);
+		double err = max(fabs(call[i] - EuroCallFormula(T[i], sig[i], r[i], q[i], S[i], K[i])), fabs(put[i] - EuroPutFormula(T[i], sig[i], r[i], q[i], S[i], K[i]))) / scale;
+		worstScalar = max(worstScalar, fabs(call[i] - sur.EuroCallPrice(T[i], sig[i], r[i], q[i], S[i], K[i])) + fabs(put[i] - sur.EuroPutPrice(T[i], sig[i], r[i], q[i], S[i], K[i])));
+		if (sur.InDomain(x, s))
+		{
+			worst = max(worst, err);
+			++inside;
+		}
+		else
+		{
+			worstOutside = max(worstOutside, err);
+		}
+	}
+
+	// Round trip through the text format
+	stringstream stream;
+	sur.Save(stream);
+	string saved = stream.str();
+	PriceSurrogate loaded;
+	bool ok = loaded.Load(stream, tolerance);
+	double worstLoaded = 0.0;
+	for (size_t i = 0; i < n; i += 97)
+	{
+		worstLoaded = max(worstLoaded, fabs(loaded.EuroCallPrice(T[i], sig[i], r[i], q[i], S[i], K[i]) - call[i]));
+	}
+	stringstream broken("PriceSurrogate 2 0 1 2"), huge("PriceSurrogate 2 -5 5 4294967296 0.005 1 4294967296 6 1e-8 1e-8 0");
+	bool rejected = !loaded.Load(broken, tolerance) && !loaded.Load(huge, tolerance);
+
+	// Tables above the tolerance are rejected by the builder and by Load, and so is a table that misses the bound it claims
+	stringstream tight(saved);
+	string corrupt = saved;
+	size_t digit = corrupt.find('\n', corrupt.find('\n') + 1) + 3; // a digit of the first coefficient
+	corrupt[digit] = (corrupt[digit] == '1') ? '2' : '1';
+	stringstream corrupted(corrupt);
+	PriceSurrogate strict(-5.0, 5.0, 12, 0.005, 1.0, 6, 6, 1e-12);
+	bool tolerated = strict.Empty() && !sur.Empty() && !loaded.Load(tight, sur.MaxError() / 2) && !loaded.Load(corrupted, tolerance);
+
+	// Latency of single prices inside the domain
+	const int reps = 20;
+	begin = chrono::high_resolution_clock::now();
+	for (int rep = 0; rep < reps; ++rep)
+	{
+		for (size_t i = 0; i < n; ++i)
+		{
+			call[i] = sur.EuroCallPrice(T[i], sig[i], r[i], q[i], S[i], K[i]);
+		}
+	}
+	double surNs = chrono::duration<double, nano>(chrono::high_resolution_clock::now() - begin).count() / (reps * n);
+	begin = chrono::high_resolution_clock::now();
+	for (int rep = 0; rep < reps; ++rep)
+	{
+		for (size_t i = 0; i < n; ++i)
+		{
+			put[i] = EuroCallFormula(T[i], sig[i], r[i], q[i], S[i], K[i]);
+		}
+	}
+	double exactNs = chrono::duration<double, nano>(chrono::high_resolution_clock::now() - begin).count() / (reps * n);
+
+	// The quote path, with x, s and the discounted underlying held per contract
+	vector<double> xs(n), ss(n), fwdS(n);
+	for (size_t i = 0; i < n; ++i)
+	{
+		ss[i] = sig[i] * sqrt(T[i]);
+		xs[i] = (log(K[i] / S[i]) - (r[i] - q[i]) * T[i]) / ss[i];
+		fwdS[i] = S[i] * exp(-q[i] * T[i]);
+	}
+	begin = chrono::high_resolution_clock::now();
+	for (int rep = 0; rep < reps; ++rep)
+	{
+		for (size_t i = 0; i < n; ++i)
+		{
+			call[i] = sur.CallPrice(xs[i], ss[i], fwdS[i]);
+		}
+	}
+	double quoteNs = chrono::duration<double, nano>(chrono::high_resolution_clock::now() - begin).count() / (reps * n);
+	begin = chrono::high_resolution_clock::now();
+	for (size_t i = 0; i < n; ++i)
+	{
+		EuroOption op(T[i], sig[i], r[i], q[i], S[i], K[i]);
+		put[i] = op.EuroCallPrice();
+	}
+	double optionNs = chrono::duration<double, nano>(chrono::high_resolution_clock::now() - begin).count() / n;
+
+	cout << "Chebyshev price surrogate, " << sur.Bytes() << " bytes, built in " << buildSeconds << " s, error bound " << sur.MaxError() << ", max observed error " << sur.MaxObservedError() << " - " << endl;
+	cout << "Max normalised error of " << inside << " contracts inside the domain: " << worst << (worst <= sur.MaxError() ? " (ok)" : " (FAILED)") << endl;
+	cout << "Max normalised error of " << n - inside << " contracts priced by the fallback: " << worstOutside << (worstOutside < 1e-14 ? " (ok)" : " (FAILED)") << endl;
+	cout << "Max difference of the scalar functions to the batch: " << worstScalar << (worstScalar < 1e-12 ? " (ok)" : " (FAILED)") << endl;
+	cout << "Save and load round trip: " << worstLoaded << (ok && worstLoaded == 0.0 ? " (ok)" : " (FAILED)") << ", malformed input rejected" << (rejected ? " (ok)" : " (FAILED)") << endl;
+	cout << "Tables above the tolerance or missing their bound rejected by the builder and by Load" << (tolerated ? " (ok)" : " (FAILED)") << endl;
+	cout << "ns per call price - surrogate from (T, sig, r, q, S, K): " << surNs << ", surrogate from (x, s, fwdS): " << quoteNs << ", closed form: " << exactNs << ", constructing EuroOption and EuroCallPrice: " << optionNs << endl;
+}
+
+// Aggregate a book of positions on several underlyings and expiries, check the totals against a serial loop over EuroOption
+// and check that they are bit for bit the same for any number of threads
+void TestPortfolio()
+{
+	Portfolio book;
+	unsigned long long state = 2024;
+	auto uniform = [&state]() { state = state * 6364136223846793005ULL + 1442695040888963407ULL; return (state >> 11) * (1.0 / 9007199254740992.0); };
+	double spots[] = { 100, 45, 320, 12.5 };
+	double expiries[] = { 0.1, 0.25, 0.5, 1.0, 2.0 };
+	size_t n = 200000;
+	PortfolioTotals serial = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+	for (size_t i = 0; i < n; ++i)
+	{
+		int u = (int)(uniform() * 4);
+		double T = expiries[(int)(uniform() * 5)];
+		double sig = 0.1 + 0.4 * uniform(), K = spots[u] * (0.7 + 0.6 * uniform()), quantity = (uniform() < 0.5 ? -1 : 1) * (1 + (int)(uniform() * 100));
+		int type = (uniform() < 0.5) ? 1 : -1;
+		book.AddPosition(u, type, quantity, T, sig, 0.05, 0.01, spots[u], K);
+
+		EuroOption op(T, sig, 0.05, 0.01, spots[u], K);
+		EuroGreeks g = op.AllGreeks();
+		serial.Price += quantity * (type == 1 ? g.CallPrice : g.PutPrice);
+		serial.Delta += quantity * (type == 1 ? g.CallDelta : g.PutDelta);
+		serial.Gamma += quantity * g.Gamma;
+		serial.Vega += quantity * g.Vega;
+		serial.Theta += quantity * (type == 1 ? g.CallTheta : g.PutTheta);
+		serial.Rho += quantity * (type == 1 ? g.CallRho : g.PutRho);
+	}
+
+	cout << "Portfolio of " << book.Positions() << " positions in " << book.Buckets() << " buckets - " << endl;
+	PortfolioRisk reference;
+	bool identical = true;
+	unsigned threads[] = { 1, 2, 3, 4, 8 };
+	for (int k = 0; k < 5; ++k)
+	{
+		PortfolioRisk risk;
+		auto begin = chrono::high_resolution_clock::now();
+		book.Aggregate(risk, threads[k]);
+		double seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - begin).count();
+		if (k == 0)
+		{
+			reference = risk;
+		}
+		identical = identical && memcmp(&risk.Total, &reference.Total, sizeof(PortfolioTotals)) == 0;
+		identical = identical && memcmp(&risk.Bucket[0], &reference.Bucket[0], risk.Bucket.size() * sizeof(PortfolioTotals)) == 0;
+		cout << threads[k] << " thread(s): " << seconds * 1e3 << " ms" << endl;
+	}
+
+	double a[] = { reference.Total.Price, reference.Total.Delta, reference.Total.Gamma, reference.Total.Vega, reference.Total.Theta, reference.Total.Rho };
+	double b[] = { serial.Price, serial.Delta, serial.Gamma, serial.Vega, serial.Theta, serial.Rho };
+	double maxRel = 0.0;
+	for (int k = 0; k < 6; ++k)
+	{
+		maxRel = max(maxRel, fabs(a[k] - b[k]) / max(fabs(b[k]), 1.0));
+	}
+	for (auto it = reference.Underlying.begin(); it != reference.Underlying.end(); ++it)
+	{
+		cout << "Underlying " << it->first << ": price " << it->second.Price << ", delta " << it->second.Delta << ", gamma " << it->second.Gamma << ", vega " << it->second.Vega << endl;
+	}
+	cout << "Max relative difference of the totals to a serial loop over EuroOption: " << maxRel << (maxRel < 1e-9 ? " (ok)" : " (FAILED)") << endl;
+	cout << "Totals bit for bit identical for 1 to 8 threads" << (identical ? " (ok)" : " (FAILED)") << endl;
+}
+
+// Price a book through the term cache against the batch pricer given r and q per contract, then check that a curve update
+// touches only the terms of that curve and costs O(expiries) rather than O(contracts)
+void TestTermCache()
+{
+	TermCache cache;
+	vector<double> tenor = { 0.25, 0.5, 1.0, 2.0, 5.0 };
+	cache.SetCurve(0, tenor, { 0.040, 0.042, 0.045, 0.047, 0.050 }); // rates
+	for (int u = 1; u <= 4; ++u)
+	{
+		cache.SetCurve(u, tenor, { 0.005 * u, 0.005 * u, 0.006 * u, 0.006 * u, 0.007 * u }); // dividend yield of underlying u
+	}
+
+	unsigned long long state = 15;
+	auto uniform = [&state]() { state = state * 6364136223846793005ULL + 1442695040888963407ULL; return (state >> 11) * (1.0 / 9007199254740992.0); };
+	size_t n = 200000;
+	vector<size_t> rateTerm(n), divTerm(n);
+	vector<double> T(n), sig(n), r(n), q(n), S(n), K(n);
+	for (size_t i = 0; i < n; ++i)
+	{
+		int u = 1 + (int)(uniform() * 4);
+		T[i] = (1 + (int)(uniform() * 24)) / 12.0;
+		sig[i] = 0.1 + 0.4 * uniform(); S[i] = 100; K[i] = 70 + 60 * uniform();
+		rateTerm[i] = cache.Term(0, T[i]);
+		divTerm[i] = cache.Term(u, T[i]);
+	}
+
+	vector<double> c1(n), p1(n), c2(n), p2(n);
+	auto fill = [&]()
+	{
+		for (size_t i = 0; i < n; ++i)
+		{
+			r[i] = cache.Zero(rateTerm[i]); q[i] = cache.Zero(divTerm[i]);
+		}
+	};
+	auto compare = [&]()
+	{
+		double maxErr = 0.0;
+		for (size_t i = 0; i < n; ++i)
+		{
+			maxErr = max(maxErr, max(fabs(c1[i] - c2[i]), fabs(p1[i] - p2[i])));
+		}
+		return maxErr;
+	};
+
+	fill();
+	auto begin = chrono::high_resolution_clock::now();
+	EuroBatchPrice(&T[0], &sig[0], &r[0], &q[0], &S[0], &K[0], &c1[0], &p1[0], n);
+	double uncached = chrono::duration<double>(chrono::high_resolution_clock::now() - begin).count();
+	begin = chrono::high_resolution_clock::now();
+	cache.EuroBatchPrice(&rateTerm[0], &divTerm[0], &sig[0], &S[0], &K[0], &c2[0], &p2[0], n);
+	double cached = chrono::duration<double>(chrono::high_resolution_clock::now() - begin).count();
+	double priceErr = compare();
+
+	// Parallel shift of the rate curve: only its 24 terms may change
+	unsigned before = cache.Generation();
+	int reps = 1000;
+	begin = chrono::high_resolution_clock::now();
+	for (int k = 0; k < reps; ++k)
+	{
+		cache.ShiftCurve(0, (k % 2 == 0) ? 0.0001 : -0.0001);
+	}
+	double shift = chrono::duration<double>(chrono::high_resolution_clock::now() - begin).count() / reps;
+	cache.ShiftCurve(0, 0.0025);
+	size_t touched = 0, wrong = 0;
+	for (size_t t = 0; t < cache.Terms(); ++t)
+	{
+		bool changed = cache.Stamp(t) > before;
+		touched += changed ? 1 : 0;
+		wrong += (changed != (cache.CurveOf(t) == 0)) ? 1 : 0;
+	}
+
+	fill();
+	EuroBatchPrice(&T[0], &sig[0], &r[0], &q[0], &S[0], &K[0], &c1[0], &p1[0], n);
+	cache.EuroBatchPrice(&rateTerm[0], &divTerm[0], &sig[0], &S[0], &K[0], &c2[0], &p2[0], n);
+	double shiftErr = compare();
+
+	// An override of one term holds until its curve moves: a shift puts it back on the shifted curve
+	size_t term = rateTerm[0];
+	double onCurve = cache.Zero(term);
+	cache.SetZeroRate(term, onCurve + 0.01);
+	bool overridden = cache.Zero(term) == onCurve + 0.01;
+	cache.ShiftCurve(0, 0.0001);
+	cache.ShiftCurve(0, -0.0001);
+	double overrideErr = overridden ? fabs(cache.Zero(term) - onCurve) : 1.0;
+
+	cout << "Term cache: " << n << " contracts on " << cache.Terms() << " terms (" << cache.CurveTerms(0) << " on the rate curve)" << endl;
+	cout << "Batch with r and q per contract: " << uncached * 1e3 << " ms, through the term cache: " << cached * 1e3 << " ms" << endl;
+	cout << "Max price difference to the batch pricer: " << priceErr << (priceErr < 1e-12 ? " (ok)" : " (FAILED)") << endl;
+	cout << "Rate curve shift: " << shift * 1e6 << " us, " << touched << " terms touched, " << wrong << " off the curve" << ((wrong == 0 && touched == cache.CurveTerms(0)) ? " (ok)" : " (FAILED)") << endl;
+	cout << "Max price difference after the shift: " << shiftErr << (shiftErr < 1e-12 ? " (ok)" : " (FAILED)") << endl;
+	cout << "Overridden zero rate after shifting the curve and back: " << overrideErr << (overrideErr < 1e-15 ? " (ok)" : " (FAILED)") << endl;
+}
+
+// Drive a live book through random spot, volatility and rate ticks, check the totals and the published changes against
+// EuroOption, report the latency percentiles per update type and check the spot tick latency of an underlying of 10000
+// contracts against the cost of repricing them
+void TestTickEngine()
+{
+	TickEngine engine;
+	vector<double> tenor = { 0.25, 0.5, 1.0, 2.0 };
+	engine.SetCurve(0, tenor, { 0.040, 0.042, 0.045, 0.047 });
+	double spots[] = { 100, 45, 320, 12.5 };
+	for (int u = 0; u < 4; ++u)
+	{
+		engine.SetCurve(10 + u, tenor, { 0.01, 0.01, 0.012, 0.012 });
+		engine.AddUnderlying(u, spots[u], 0, 10 + u);
+	}
+
+	// Underlying 0 carries 10000 contracts on 20 expiries, the others 1000 each
+	struct Contract { int u, type; double quantity, T, sig, K; };
+	vector<Contract> book;
+	unsigned long long state = 16;
+	auto uniform = [&state]() { state = state * 6364136223846793005ULL + 1442695040888963407ULL; return (state >> 11) * (1.0 / 9007199254740992.0); };
+	for (int u = 0; u < 4; ++u)
+	{
+		int n = (u == 0) ? 10000 : 1000;
+		for (int i = 0; i < n; ++i)
+		{
+			Contract c = { u, (uniform() < 0.5) ? 1 : -1, (uniform() < 0.5 ? -1.0 : 1.0) * (1 + (int)(uniform() * 50)), (1 + (int)(uniform() * 20)) / 10.0, 0.1 + 0.4 * uniform(), spots[u] * (0.7 + 0.6 * uniform()) };
+			engine.AddPosition(c.u, c.type, c.quantity, c.T, c.sig, c.K);
+			book.push_back(c);
+		}
+	}
+	engine.Reprice();
+	PortfolioTotals start = engine.Total(), published = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+	engine.Subscribe([&published](const RiskDelta& d)
+	{
+		published.Price += d.Change.Price; published.Delta += d.Change.Delta; published.Gamma += d.Change.Gamma;
+		published.Vega += d.Change.Vega; published.Theta += d.Change.Theta; published.Rho += d.Change.Rho;
+	});
+
+	// Ticks: mostly spot, some volatility shifts of one expiry, a few rate moves
+	double spot[4] = { spots[0], spots[1], spots[2], spots[3] }, rateShift = 0.0;
+	size_t repriced = 0;
+	for (int k = 0; k < 3000; ++k)
+	{
+		double x = uniform();
+		int u = (uniform() < 0.7) ? 0 : 1 + (int)(uniform() * 3);
+		if (x < 0.8)
+		{
+			spot[u] *= exp(0.001 * (uniform() - 0.5));
+			repriced += engine.OnSpot(u, spot[u]);
+		}
+		else if (x < 0.97)
+		{
+			double T = (1 + (int)(uniform() * 20)) / 10.0, dSig = 0.002 * (uniform() - 0.5);
+			for (Contract& c : book)
+			{
+				if (c.u == u && c.T == T) c.sig += dSig;
+			}
+			repriced += engine.OnVol(u, T, dSig);
+		}
+		else
+		{
+			double dz = 0.0002 * (uniform() - 0.5);
+			rateShift += dz;
+			repriced += engine.OnCurveShift(0, dz);
+		}
+	}
+
+	// Reference: the book priced contract by contract with the rates interpolated from the shifted curve
+	auto zeroRate = [](const vector<double>& t, const vector<double>& z, double T)
+	{
+		if (T <= t.front()) return z.front();
+		if (T >= t.back()) return z.back();
+		size_t hi = upper_bound(t.begin(), t.end(), T) - t.begin();
+		return z[hi - 1] + (T - t[hi - 1]) / (t[hi] - t[hi - 1]) * (z[hi] - z[hi - 1]);
+	};
+	PortfolioTotals serial = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+	for (const Contract& c : book)
+	{
+		double r = zeroRate(tenor, { 0.040, 0.042, 0.045, 0.047 }, c.T) + rateShift, q = zeroRate(tenor, { 0.01, 0.01, 0.012, 0.012 }, c.T);
+		EuroGreeks g = EuroOption(c.T, c.sig, r, q, spot[c.u], c.K).AllGreeks();
+		serial.Price += c.quantity * (c.type == 1 ? g.CallPrice : g.PutPrice);
+		serial.Delta += c.quantity * (c.type == 1 ? g.CallDelta : g.PutDelta);
+		serial.Gamma += c.quantity * g.Gamma;
+		serial.Vega += c.quantity * g.Vega;
+	}
+	const PortfolioTotals& now = engine.Total();
+	double a[] = { now.Price, now.Delta, now.Gamma, now.Vega }, b[] = { serial.Price, serial.Delta, serial.Gamma, serial.Vega };
+	double c[] = { now.Price - start.Price, now.Delta - start.Delta, now.Gamma - start.Gamma, now.Vega - start.Vega }, d[] = { published.Price, published.Delta, published.Gamma, published.Vega };
+	double maxRel = 0.0, maxPub = 0.0;
+	for (int k = 0; k < 4; ++k)
+	{
+		maxRel = max(maxRel, fabs(a[k] - b[k]) / max(fabs(b[k]), 1.0));
+		maxPub = max(maxPub, fabs(c[k] - d[k]) / max(fabs(a[k]), 1.0));
+	}
+
+	cout << "Tick engine: " << engine.Positions() << " positions, " << engine.Positions(0) << " on underlying 0, " << repriced << " contracts repriced by 3000 updates" << endl;
+	cout << "Max relative difference of the totals to EuroOption: " << maxRel << (maxRel < 1e-6 ? " (ok)" : " (FAILED)") << endl;
+	cout << "Max relative difference of the summed published changes to the change of the totals: " << maxPub << (maxPub < 1e-9 ? " (ok)" : " (FAILED)") << endl;
+	bool rejected = engine.AddPosition(99, 1, 1.0, 1.0, 0.2, 100.0) == NoSlice && engine.Totals(99).Price == 0.0 && engine.Positions() == book.size();
+	cout << "Position on an underlying that was not added rejected" << (rejected ? " (ok)" : " (FAILED)") << endl;
+
+	// Latency of spot ticks on the 10000 contract underlying alone
+	engine.ClearLatency();
+	for (int k = 0; k < 2000; ++k)
+	{
+		spot[0] *= exp(0.001 * (uniform() - 0.5));
+		engine.OnSpot(0, spot[0]);
+		if (k % 10 == 0) engine.OnVol(0, (1 + (k / 10) % 20) / 10.0, 0.0001 * ((k % 20 == 0) ? 1 : -1));
+		if (k % 100 == 0) engine.OnCurveShift(0, 0.0001 * ((k % 200 == 0) ? 1 : -1));
+	}
+	const char* names[] = { "spot", "vol", "rate" };
+	for (int t = 0; t < TickTypes; ++t)
+	{
+		const LatencyHistogram& h = engine.Latency(TickType(t));
+		cout << "Latency of " << names[t] << " updates (" << h.Count() << "): p50 " << h.Percentile(50) / 1e3 << " us, p99 " << h.Percentile(99) / 1e3 << " us, max " << h.Max() / 1e3 << " us" << endl;
+	}
+
+	// Same book of underlying 0 on one and four threads with full repricing, and on one thread in the delta-gamma mode
+	TickEngine single(CdfExact, 1), multi(CdfExact, 4), taylor(CdfExact, 1);
+	for (TickEngine* e : { &single, &multi, &taylor })
+	{
+		e->SetCurve(0, tenor, { 0.040, 0.042, 0.045, 0.047 });
+		e->SetCurve(10, tenor, { 0.01, 0.01, 0.012, 0.012 });
+		e->AddUnderlying(0, spot[0], 0, 10);
+		for (const Contract& c : book)
+		{
+			if (c.u == 0) e->AddPosition(c.u, c.type, c.quantity, c.T, c.sig, c.K);
+		}
+		e->Reprice();
+	}
+	taylor.SetSpotMode(SpotDeltaGamma, 0.005);
+	bool same = true;
+	double priceError = 0.0, deltaError = 0.0;
+	for (int k = 0; k < 200; ++k)
+	{
+		spot[0] *= exp(0.001 * (uniform() - 0.5));
+		single.OnSpot(0, spot[0]);
+		multi.OnSpot(0, spot[0]);
+		taylor.OnSpot(0, spot[0]);
+		const PortfolioTotals& x = single.Total(), & y = multi.Total(), & z = taylor.Total();
+		same = same && x.Price == y.Price && x.Delta == y.Delta && x.Gamma == y.Gamma && x.Vega == y.Vega && x.Theta == y.Theta && x.Rho == y.Rho;
+		priceError = max(priceError, fabs(z.Price - x.Price) / max(fabs(x.Price), 1.0));
+		deltaError = max(deltaError, fabs(z.Delta - x.Delta) / max(fabs(x.Delta), fabs(x.Gamma) * spot[0])); // the book is near delta neutral, so against Gamma S as well
+	}
+	cout << "Same totals for 1 and 4 threads" << (same ? " (ok)" : " (FAILED)") << endl;
+	cout << "Delta-gamma spot mode (band 0.5%), max relative error of the Price " << priceError << " and of the Delta " << deltaError << ((priceError < 1e-5 && deltaError < 1e-3) ? " (ok)" : " (FAILED)") << endl;
+
+	// Latency of the delta-gamma mode under the tick mix above: a spot tick reprices only the slices that left the band, the
+	// volatility and curve updates move the anchors
+	size_t spotRepriced = 0;
+	taylor.ClearLatency();
+	for (int k = 0; k < 2000; ++k)
+	{
+		spot[0] *= exp(0.001 * (uniform() - 0.5));
+		spotRepriced += taylor.OnSpot(0, spot[0]);
+		if (k % 10 == 0) taylor.OnVol(0, (1 + (k / 10) % 20) / 10.0, 0.0001 * ((k % 20 == 0) ? 1 : -1));
+		if (k % 100 == 0) taylor.OnCurveShift(0, 0.0001 * ((k % 200 == 0) ? 1 : -1));
+	}
+
+	// The target is a spot tick p99 below 50 us. Full repricing is bounded below by about 50 ns per contract of the
+	// underlying on one thread, so it is reported against the target rather than checked
+	size_t n0 = single.Positions(0);
+	unsigned used = unsigned(min(size_t(engine.Threads()), max(n0 / 2048, size_t(1))));
+	double pass = single.Latency(TickSpot).Percentile(50) / 1e3, p99 = engine.Latency(TickSpot).Percentile(99) / 1e3, p99Taylor = taylor.Latency(TickSpot).Percentile(99) / 1e3;
+	cout << "Spot tick p50 on one thread: " << pass << " us, " << pass * 1e3 / n0 << " ns per contract" << endl;
+	cout << "Spot tick p99 with full repricing on " << used << " thread(s): " << p99 << " us against 50 us" << (p99 < 50 ? " (met)" : " (not met)") << endl;
+	cout << "Spot tick p99 in the delta-gamma mode on one thread: " << p99Taylor << " us against 50 us" << (p99Taylor < 50 ? " (met)" : " (not met)")
+		<< ", " << spotRepriced / 2000.0 << " contracts repriced per spot tick" << endl;
+}
+
+// Check a snapshot of model prices, which must be free of arbitrage, then break a few quotes and check that exactly the
+// expected violations are reported, the same for 1 and 4 threads
+void TestArbitrage()
+{
+	size_t chains = 1000, expiries = 10, strikes = 40, n = chains * expiries * strikes;
+	vector<double> T(n), sig(n), r(n, 0.03), q(n, 0.01), S(n), K(n), call(n), put(n);
+	vector<size_t> chainBegin(chains + 1);
+	for (size_t c = 0; c < chains; ++c)
+	{
+		chainBegin[c] = c * expiries * strikes;
+		for (size_t e = 0; e < expiries; ++e)
+		{
+			for (size_t k = 0; k < strikes; ++k)
+			{
+				size_t j = chainBegin[c] + e * strikes + k;
+				T[j] = 0.1 * (e + 1) * (e + 1); sig[j] = 0.15 + 0.0003 * c; S[j] = 100; K[j] = 60 + 2 * k;
+			}
+		}
+	}
+	chainBegin[chains] = n;
+	EuroBatchPrice(&T[0], &sig[0], &r[0], &q[0], &S[0], &K[0], &call[0], &put[0], n);
+
+	QuoteArrays quotes = { &T[0], &S[0], &r[0], &q[0], &K[0], &call[0], &put[0] };
+	ArbitrageTolerance tol = { 1e-9, 1e-9, 1e-9, 1e-9 };
+	vector<ArbitrageViolation> found;
+	auto begin = chrono::high_resolution_clock::now();
+	size_t clean = ArbitrageCheck(quotes, &chainBegin[0], chains, tol, found);
+	double seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - begin).count();
+
+	// Broken quotes: a put off parity, a call above its lower strike neighbour, and an expiry whose calls are cut by 10%
+	size_t a = chainBegin[7] + 3 * strikes + 20, b = chainBegin[300] + 5 * strikes + 10, c = chainBegin[999] + 8 * strikes;
+	put[a] += 0.05;
+	call[b] = call[b - 1] + 0.01;
+	put[b] = call[b] - (S[b] * exp(-q[b] * T[b]) - K[b] * exp(-r[b] * T[b])); // keep parity
+	for (size_t k = 0; k < strikes; ++k)
+	{
+		call[c + k] *= 0.9;
+		put[c + k] = call[c + k] - (S[c + k] * exp(-q[c + k] * T[c + k]) - K[c + k] * exp(-r[c + k] * T[c + k])); // keep parity
+	}
+	vector<ArbitrageViolation> one, four;
+	ArbitrageCheck(quotes, &chainBegin[0], chains, tol, one, 1);
+	ArbitrageCheck(quotes, &chainBegin[0], chains, tol, four, 4);
+	bool same = one.size() == four.size();
+	for (size_t i = 0; same && i < one.size(); ++i)
+	{
+		same = one[i].Kind == four[i].Kind && one[i].Index == four[i].Index && one[i].Other == four[i].Other && one[i].Excess == four[i].Excess;
+	}
+
+	// Expected: parity at a plus the put strike, spread or butterfly checks around it, a call strike violation at b - 1 with
+	// strike, spread and butterfly checks around b, and calendar violations from expiry 8 into 9 and from 7 into 8 of chain 999
+	size_t parity = 0, callStrike = 0, calendarInto = 0, calendarFrom = 0, stray = 0;
+	for (const ArbitrageViolation& v : one)
+	{
+		bool nearA = v.Index + 2 >= a && v.Index <= a, nearB = v.Index + 2 >= b && v.Index <= b;
+		if (v.Kind == ArbParity && v.Index == a) ++parity;
+		else if (v.Kind == ArbCallStrike && v.Index == b - 1) ++callStrike;
+		else if (v.Kind == ArbCalendar && v.Index >= c - strikes && v.Index < c) ++calendarInto;
+		else if (v.Kind == ArbCalendar && v.Index >= c && v.Index < c + strikes) ++calendarFrom;
+		else if (!((nearA && (v.Kind == ArbPutStrike || v.Kind == ArbPutSpread || v.Kind == ArbPutButterfly)) || (nearB && v.Kind != ArbParity && v.Kind != ArbCalendar))) ++stray;
+	}
+
+	cout << "Arbitrage check of " << chains << " chains, " << n << " contracts: " << seconds * 1e3 << " ms" << endl;
+	cout << "Violations in model prices: " << clean << (clean == 0 ? " (ok)" : " (FAILED)") << endl;
+	cout << "Violations after breaking quotes: " << one.size() << " (parity " << parity << ", call strike " << callStrike << ", calendar " << calendarInto << " into and " << calendarFrom << " out of the cut expiry, unexpected " << stray << ")"
+		<< ((parity == 1 && callStrike == 1 && calendarInto > 0 && calendarFrom == 0 && stray == 0) ? " (ok)" : " (FAILED)") << endl;
+	cout << "Same violations for 1 and 4 threads" << (same ? " (ok)" : " (FAILED)") << endl;
+}
+
+// Validation harness for the single precision batch path: errors of prices and deltas against the double EuroOption over a
+// grid of maturities, volatilities, rates, dividends and strikes, and the throughput of the float against the double kernel
+void TestSinglePrecision()
+{
+	double Ts[] = { 1.0 / 52, 1.0 / 12, 0.25, 0.5, 1.0, 2.0, 5.0 }, sigs[] = { 0.05, 0.1, 0.2, 0.4, 0.8 }, rs[] = { 0.0, 0.02, 0.05, 0.08 }, qs[] = { 0.0, 0.02, 0.05 };
+	vector<double> T, sig, r, q, S, K;
+	for (double t : Ts) for (double v : sigs) for (double rate : rs) for (double div : qs)
+	{
+		for (int k = -10; k <= 10; ++k)
+		{
+			T.push_back(t); sig.push_back(v); r.push_back(rate); q.push_back(div); S.push_back(100); K.push_back(100 * exp(0.05 * k));
+		}
+	}
+	size_t n = T.size();
+	vector<EuroGreeks> reference(n);
+	for (size_t i = 0; i < n; ++i)
+	{
+		reference[i] = EuroOption(T[i], sig[i], r[i], q[i], S[i], K[i]).AllGreeks();
+	}
+
+	vector<float> Tf(T.begin(), T.end()), sigf(sig.begin(), sig.end()), rf(r.begin(), r.end()), qf(q.begin(), q.end()), Sf(S.begin(), S.end()), Kf(K.begin(), K.end());
+	vector<vector<float> > g(10, vector<float>(n));
+	EuroGreeksArraysF out = { &g[0][0], &g[1][0], &g[2][0], &g[3][0], &g[4][0], &g[5][0], &g[6][0], &g[7][0], &g[8][0], &g[9][0] };
+	cout << "Single precision batch over " << n << " contracts against EuroOption - " << endl;
+	cout << setw(10) << "Tier" << setw(20) << "Price abs error" << setw(20) << "Price rel error" << setw(20) << "Delta abs error" << endl;
+	CdfTier tiers[] = { CdfExact, CdfSweep };
+	const char* names[] = { "Exact", "Single" };
+	bool ok = true;
+	for (int t = 0; t < 2; ++t)
+	{
+		EuroBatchGreeks(&Tf[0], &sigf[0], &rf[0], &qf[0], &Sf[0], &Kf[0], out, n, tiers[t]);
+		double absErr = 0.0, relErr = 0.0, deltaErr = 0.0;
+		for (size_t i = 0; i < n; ++i)
+		{
+			double prices[] = { reference[i].CallPrice, reference[i].PutPrice }, single[] = { out.CallPrice[i], out.PutPrice[i] };
+			for (int k = 0; k < 2; ++k)
+			{
+				double err = fabs(single[k] - prices[k]);
+				absErr = max(absErr, err);
+				relErr = (prices[k] >= 0.01) ? max(relErr, err / prices[k]) : relErr; // relative error of prices of at least a cent
+			}
+			deltaErr = max(deltaErr, max(fabs(out.CallDelta[i] - reference[i].CallDelta), fabs(out.PutDelta[i] - reference[i].PutDelta)));
+		}
+		ok = ok && absErr < 1e-4 && relErr < 1e-3 && deltaErr < 1e-5;
+		cout << setw(10) << names[t] << setw(20) << absErr << setw(20) << relErr << setw(20) << deltaErr << endl;
+	}
+	cout << "Errors within 1e-4 absolute, 1e-3 relative (prices of at least a cent) and 1e-5 in delta" << (ok ? " (ok)" : " (FAILED)") << endl;
+
+	// Throughput on 50 copies of the grid
+	size_t copies = 50, m = n * copies;
+	vector<double> Tm, sigm, rm, qm, Sm, Km, cm(m), pm(m);
+	for (size_t c = 0; c < copies; ++c)
+	{
+		Tm.insert(Tm.end(), T.begin(), T.end()); sigm.insert(sigm.end(), sig.begin(), sig.end()); rm.insert(rm.end(), r.begin(), r.end());
+		qm.insert(qm.end(), q.begin(), q.end()); Sm.insert(Sm.end(), S.begin(), S.end()); Km.insert(Km.end(), K.begin(), K.end());
+	}
+	vector<float> Tmf(Tm.begin(), Tm.end()), sigmf(sigm.begin(), sigm.end()), rmf(rm.begin(), rm.end()), qmf(qm.begin(), qm.end()), Smf(Sm.begin(), Sm.end()), Kmf(Km.begin(), Km.end()), cmf(m), pmf(m);
+	auto begin = chrono::high_resolution_clock::now();
+	EuroBatchPrice(&Tm[0], &sigm[0], &rm[0], &qm[0], &Sm[0], &Km[0], &cm[0], &pm[0], m, CdfSweep);
+	double seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - begin).count();
+	cout << "Pricing " << m << " contracts: double (sweep tier) " << seconds * 1e3 << " ms";
+	for (int t = 0; t < 2; ++t)
+	{
+		begin = chrono::high_resolution_clock::now();
+		EuroBatchPrice(&Tmf[0], &sigmf[0], &rmf[0], &qmf[0], &Smf[0], &Kmf[0], &cmf[0], &pmf[0], m, tiers[t]);
+		seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - begin).count();
+		cout << ", float (" << names[t] << ") " << seconds * 1e3 << " ms";
+	}
+	cout << endl;
+}
+
+// Price a book mixing equity, futures and FX options in one call and compare each contract with EuroOption: Black-76 is
+// Black-Scholes-Merton on the futures price with the dividend yield equal to the rate, Garman-Kohlhagen with the foreign
+// rate as the dividend yield. Rho, which differs for Black-76, is checked against a central difference of the model price
+void TestModels()
+{
+	size_t n = 30000;
+	unsigned long long state = 19;
+	auto uniform = [&state]() { state = state * 6364136223846793005ULL + 1442695040888963407ULL; return (state >> 11) * (1.0 / 9007199254740992.0); };
+	vector<EuroModel> model(n);
+	vector<double> T(n), sig(n), r(n), y(n), S(n), K(n);
+	for (size_t i = 0; i < n; ++i)
+	{
+		model[i] = EuroModel((int)(uniform() * EuroModels));
+		T[i] = 0.05 + 3 * uniform(); sig[i] = 0.05 + 0.5 * uniform(); r[i] = 0.08 * uniform(); y[i] = 0.06 * uniform();
+		S[i] = (model[i] == ModelGarmanKohlhagen) ? 1.1 : 100; K[i] = S[i] * (0.7 + 0.6 * uniform());
+	}
+
+	// Group the book by model and gather it into that order
+	vector<size_t> order(n), modelBegin(EuroModels + 1);
+	SortByModel(&model[0], n, &order[0], &modelBegin[0]);
+	vector<double> Tg(n), sigg(n), rg(n), yg(n), Sg(n), Kg(n);
+	for (size_t k = 0; k < n; ++k)
+	{
+		size_t i = order[k];
+		Tg[k] = T[i]; sigg[k] = sig[i]; rg[k] = r[i]; yg[k] = y[i]; Sg[k] = S[i]; Kg[k] = K[i];
+	}
+	vector<vector<double> > g(10, vector<double>(n));
+	EuroGreeksArrays out = { &g[0][0], &g[1][0], &g[2][0], &g[3][0], &g[4][0], &g[5][0], &g[6][0], &g[7][0], &g[8][0], &g[9][0] };
+	auto begin = chrono::high_resolution_clock::now();
+	MixedBatchGreeks(&modelBegin[0], &Tg[0], &sigg[0], &rg[0], &yg[0], &Sg[0], &Kg[0], out);
+	double mixed = chrono::duration<double>(chrono::high_resolution_clock::now() - begin).count();
+	begin = chrono::high_resolution_clock::now();
+	EuroBatchGreeks(&Tg[0], &sigg[0], &rg[0], &yg[0], &Sg[0], &Kg[0], out, n);
+	double spot = chrono::duration<double>(chrono::high_resolution_clock::now() - begin).count();
+	MixedBatchGreeks(&modelBegin[0], &Tg[0], &sigg[0], &rg[0], &yg[0], &Sg[0], &Kg[0], out);
+
+	// Call and put price of contract k under model m with the rate replaced
+	auto price = [&](EuroModel m, size_t k, double rate, double& call, double& put)
+	{
+		switch (m)
+		{
+		case ModelBlack76: ModelBatchPrice<Black76Model>(&Tg[k], &sigg[k], &rate, &yg[k], &Sg[k], &Kg[k], &call, &put, 1); break;
+		default: ModelBatchPrice<SpotModel>(&Tg[k], &sigg[k], &rate, &yg[k], &Sg[k], &Kg[k], &call, &put, 1); break;
+		}
+	};
+
+	double maxErr[EuroModels] = { 0.0, 0.0, 0.0 }, rhoErr = 0.0;
+	for (size_t k = 0; k < n; ++k)
+	{
+		EuroModel m = model[order[k]];
+		double q = (m == ModelBlack76) ? rg[k] : yg[k];
+		EuroGreeks e = EuroOption(Tg[k], sigg[k], rg[k], q, Sg[k], Kg[k]).AllGreeks();
+		double a[] = { out.CallPrice[k], out.PutPrice[k], out.CallDelta[k], out.PutDelta[k], out.Gamma[k] * Sg[k], out.Vega[k], out.CallTheta[k], out.PutTheta[k] };
+		double b[] = { e.CallPrice, e.PutPrice, e.CallDelta, e.PutDelta, e.Gamma * Sg[k], e.Vega, e.CallTheta, e.PutTheta };
+		for (int j = 0; j < 8; ++j)
+		{
+			maxErr[m] = max(maxErr[m], fabs(a[j] - b[j]) / max(fabs(b[j]), 1.0));
+		}
+
+		double h = 1e-6, callUp, putUp, callDown, putDown;
+		price(m, k, rg[k] + h, callUp, putUp);
+		price(m, k, rg[k] - h, callDown, putDown);
+		rhoErr = max(rhoErr, max(fabs((callUp - callDown) / (2 * h) - out.CallRho[k]), fabs((putUp - putDown) / (2 * h) - out.PutRho[k])) / max(fabs(out.CallRho[k]), 1.0));
+	}
+
+	cout << "Mixed book of " << n << " contracts (" << modelBegin[1] << " equity, " << modelBegin[2] - modelBegin[1] << " futures, " << modelBegin[3] - modelBegin[2] << " FX options) - " << endl;
+	cout << "One MixedBatchGreeks call: " << mixed * 1e3 << " ms, EuroBatchGreeks on the same arrays: " << spot * 1e3 << " ms" << endl;
+	const char* names[] = { "Black-Scholes-Merton", "Black-76", "Garman-Kohlhagen" };
+	for (int m = 0; m < EuroModels; ++m)
+	{
+		cout << "Max relative difference of " << names[m] << " prices and Greeks to EuroOption: " << maxErr[m] << (maxErr[m] < 1e-9 ? " (ok)" : " (FAILED)") << endl;
+	}
+	cout << "Max relative difference of rho to a central difference: " << rhoErr << (rhoErr < 1e-5 ? " (ok)" : " (FAILED)") << endl;
+}
+
+// Build a volatility surface from a smooth smile, check that it returns its quotes, interpolates between strikes and
+// linearly in total variance between expiries, that the walking lookup agrees with the scalar one bit for bit, and time
+// a rebuild and the lookups
+void TestVolSurface()
+{
+	auto smile = [](double T, double K) { double x = log(K / 100); return 0.2 + 0.05 * x + 0.3 * x * x / sqrt(1 + T); };
+	size_t expiries = 12, strikes = 25;
+	vector<double> T(expiries), K, vol;
+	vector<size_t> strikeBegin(expiries + 1);
+	for (size_t e = 0; e < expiries; ++e)
+	{
+		T[e] = 0.05 + 0.25 * e * e / 4;
+		strikeBegin[e] = K.size();
+		for (size_t k = 0; k < strikes; ++k)
+		{
+			K.push_back(60 + 5.0 * k);
+			vol.push_back(smile(T[e], K.back()));
+		}
+	}
+	strikeBegin[expiries] = K.size();
+	VolSurface surface;
+	bool built = surface.Build(expiries, &T[0], &strikeBegin[0], &K[0], &vol[0]);
+
+	double knotErr = 0.0, between = 0.0, timeErr = 0.0;
+	for (size_t e = 0; e < expiries; ++e)
+	{
+		for (size_t k = 0; k < strikes; ++k)
+		{
+			knotErr = max(knotErr, fabs(surface.Vol(T[e], K[strikeBegin[e] + k]) - vol[strikeBegin[e] + k]));
+		}
+		for (double x = 62.5; x < 180; x += 5)
+		{
+			between = max(between, fabs(surface.Vol(T[e], x) - smile(T[e], x)));
+		}
+		if (e + 1 < expiries)
+		{
+			double Tm = 0.3 * T[e] + 0.7 * T[e + 1];
+			for (double x = 61; x < 180; x += 7)
+			{
+				double wLo = pow(surface.Vol(T[e], x), 2) * T[e], wHi = pow(surface.Vol(T[e + 1], x), 2) * T[e + 1];
+				timeErr = max(timeErr, fabs(pow(surface.Vol(Tm, x), 2) * Tm - (0.3 * wLo + 0.7 * wHi)));
+			}
+		}
+	}
+
+	// A chain of sorted strikes at one maturity between the quoted expiries, looked up in one walk and one by one
+	size_t n = 1000000;
+	vector<double> Tc(n), Kc(n), walked(n), scalar(n), r(n, 0.03), q(n, 0.01), S(n, 100), call1(n), put1(n), call2(n), put2(n);
+	for (size_t i = 0; i < n; ++i)
+	{
+		Tc[i] = 0.5 + 0.5 * (i / 1000); Kc[i] = 50 + 0.14 * (i % 1000);
+	}
+	auto begin = chrono::high_resolution_clock::now();
+	surface.Vols(&Tc[0], &Kc[0], &walked[0], n);
+	double walkTime = chrono::duration<double>(chrono::high_resolution_clock::now() - begin).count();
+	begin = chrono::high_resolution_clock::now();
+	for (size_t i = 0; i < n; ++i)
+	{
+		scalar[i] = surface.Vol(Tc[i], Kc[i]);
+	}
+	double scalarTime = chrono::duration<double>(chrono::high_resolution_clock::now() - begin).count();
+	bool same = memcmp(&walked[0], &scalar[0], n * sizeof(double)) == 0;
+
+	SurfaceBatchPrice(surface, &Tc[0], &r[0], &q[0], &S[0], &Kc[0], &call1[0], &put1[0], n);
+	EuroBatchPrice(&Tc[0], &walked[0], &r[0], &q[0], &S[0], &Kc[0], &call2[0], &put2[0], n);
+	bool priced = memcmp(&call1[0], &call2[0], n * sizeof(double)) == 0 && memcmp(&put1[0], &put2[0], n * sizeof(double)) == 0;
+
+	// Rebuild from a snapshot of 100 expiries by 200 strikes, and a snapshot with strikes out of order
+	size_t bigE = 100, bigK = 200;
+	vector<double> bigT(bigE), bigStrike, bigVol;
+	vector<size_t> bigBegin(bigE + 1);
+	for (size_t e = 0; e < bigE; ++e)
+	{
+		bigT[e] = 0.02 * (e + 1);
+		bigBegin[e] = bigStrike.size();
+		for (size_t k = 0; k < bigK; ++k)
+		{
+			bigStrike.push_back(50 + 0.5 * k);
+			bigVol.push_back(smile(bigT[e], bigStrike.back()));
+		}
+	}
+	bigBegin[bigE] = bigStrike.size();
+	VolSurface big;
+	big.Build(bigE, &bigT[0], &bigBegin[0], &bigStrike[0], &bigVol[0]);
+	int reps = 20;
+	begin = chrono::high_resolution_clock::now();
+	for (int k = 0; k < reps; ++k)
+	{
+		big.Build(bigE, &bigT[0], &bigBegin[0], &bigStrike[0], &bigVol[0]);
+	}
+	double rebuild = chrono::duration<double>(chrono::high_resolution_clock::now() - begin).count() / reps;
+	swap(bigStrike[5], bigStrike[6]);
+	bool rejected = !big.Build(bigE, &bigT[0], &bigBegin[0], &bigStrike[0], &bigVol[0]) && big.Quotes() == 0;
+
+	cout << "Volatility surface of " << surface.Expiries() << " expiries and " << surface.Quotes() << " quotes - " << endl;
+	cout << "Max difference to the quotes: " << knotErr << ((built && knotErr < 1e-14) ? " (ok)" : " (FAILED)") << endl;
+	cout << "Max difference to the smile between strikes: " << between << (between < 1e-3 ? " (ok)" : " (FAILED)") << endl;
+	cout << "Max difference to linear total variance between expiries: " << timeErr << (timeErr < 1e-14 ? " (ok)" : " (FAILED)") << endl;
+	cout << n << " lookups along sorted strikes: " << walkTime * 1e3 << " ms walking, " << scalarTime * 1e3 << " ms one by one, identical" << (same ? " (ok)" : " (FAILED)") << endl;
+	cout << "SurfaceBatchPrice identical to EuroBatchPrice at the looked up volatilities" << (priced ? " (ok)" : " (FAILED)") << endl;
+	cout << "Rebuild of " << bigE * bigK << " quotes: " << rebuild * 1e6 << " us, snapshot with unsorted strikes rejected" << (rejected ? " (ok)" : " (FAILED)") << endl;
+}
+
+// Accuracy harness for the normal cdf tiers against Boost, scalar and batch forms, plus the effect of each tier on batch prices
+void TestNormalCdf()
+{
+	normal_distribution<> myNormal(0, 1);
+	const char* names[] = { "Exact", "Risk", "Sweep" };
+	CdfTier tiers[] = { CdfExact, CdfRisk, CdfSweep };
+	double bounds[] = { 1e-15, 1e-10, 1e-7 };
+
+	// Points from -12 to 12 in steps of 1e-4, wide enough to cover both tails
+	vector<double> x;
+	for (int i = -120000; i <= 120000; ++i)
+	{
+		x.push_back(i * 1e-4);
+	}
+	size_t n = x.size();
+	vector<double> boostCdf(n), out(n);
+	for (size_t i = 0; i < n; ++i)
+	{
+		boostCdf[i] = cdf(myNormal, x[i]);
+	}
+
+	TestBook b = MakeTestBook();
+	size_t m = b.size();
+	vector<double> call(m), put(m), callExact(m), putExact(m);
+	EuroBatchPriceScalar(&b.T[0], &b.sig[0], &b.r[0], &b.q[0], &b.S[0], &b.K[0], &callExact[0], &putExact[0], m);
+
+	cout << setw(10) << "Tier" << setw(20) << "Scalar max error" << setw(20) << "Batch max error" << setw(20) << "Batch ns/value" << setw(20) << "Price max error" << endl;
+	for (int t = 0; t < 3; ++t)
+	{
+		double maxScalar = 0.0, maxBatch = 0.0, maxPrice = 0.0;
+		for (size_t i = 0; i < n; ++i)
+		{
+			maxScalar = max(maxScalar, fabs(NormalCdf(x[i], tiers[t]) - boostCdf[i]));
+		}
+
+		// Best of five runs, so that a cold cache or a context switch does not decide the order of the tiers
+		double ns = 1e30;
+		for (int run = 0; run < 5; ++run)
+		{
+			auto begin = chrono::high_resolution_clock::now();
+			NormalCdfBatch(&x[0], &out[0], n, tiers[t]);
+			ns = min(ns, chrono::duration<double, nano>(chrono::high_resolution_clock::now() - begin).count() / n);
+		}
+		for (size_t i = 0; i < n; ++i)
+		{
+			maxBatch = max(maxBatch, fabs(out[i] - boostCdf[i]));
+		}
+
+		EuroBatchPrice(&b.T[0], &b.sig[0], &b.r[0], &b.q[0], &b.S[0], &b.K[0], &call[0], &put[0], m, tiers[t]);
+		for (size_t i = 0; i < m; ++i)
+		{
+			maxPrice = max(maxPrice, max(fabs(call[i] - callExact[i]), fabs(put[i] - putExact[i])));
+		}
+
+		bool ok = maxScalar < bounds[t] && maxBatch < bounds[t];
+		cout << setw(10) << names[t] << setw(20) << maxScalar << setw(20) << maxBatch << setw(20) << ns << setw(20) << maxPrice << (ok ? " (ok)" : " (FAILED)") << endl;
+	}
+
+	// The pdf is exact in every tier
+	double maxPdf = 0.0;
+	NormalPdfBatch(&x[0], &out[0], n);
+	for (size_t i = 0; i < n; ++i)
+	{
+		maxPdf = max(maxPdf, max(fabs(out[i] - pdf(myNormal, x[i])), fabs(NormalPdf(x[i]) - pdf(myNormal, x[i]))));
+	}
+	cout << "Pdf max error: " << maxPdf << (maxPdf < 1e-15 ? " (ok)" : " (FAILED)") << endl;
+}
+
+// Invert batch prices of the test book back to volatilities, with a few quotes outside the arbitrage bounds, and time the solver
+void TestImpliedVol()
+{
+	TestBook b = MakeTestBook();
+	size_t n = b.size();
+	vector<double> call(n), put(n), quote(n), vol(n);
+	vector<int> type(n);
+	vector<ImpliedVolStatus> status(n);
+	EuroBatchPrice(&b.T[0], &b.sig[0], &b.r[0], &b.q[0], &b.S[0], &b.K[0], &call[0], &put[0], n);
+
+	// Out of the money side of each strike, as quoted in the market
+	for (size_t i = 0; i < n; ++i)
+	{
+		type[i] = (b.K[i] >= b.S[i]) ? 1 : -1;
+		quote[i] = (type[i] == 1) ? call[i] : put[i];
+	}
+	quote[0] = -0.01; // below intrinsic, as are the deep out of the money quotes whose price rounds to zero
+	quote[1] = b.S[1]; // above the upper bound of a call
+
+	EuroBatchImpliedVol(&quote[0], &type[0], &b.T[0], &b.r[0], &b.q[0], &b.S[0], &b.K[0], &vol[0], &status[0], n);
+
+	int count[4] = { 0, 0, 0, 0 };
+	double maxErr = 0.0;
+	for (size_t i = 0; i < n; ++i)
+	{
+		count[status[i]]++;
+
+		// Only quotes whose price carries information about the volatility can be checked, a price rounding
+		// error of 1e-14 moves the implied volatility by 1e-14 / vega
+		EuroOption op(b.T[i], b.sig[i], b.r[i], b.q[i], b.S[i], b.K[i]);
+		if (status[i] == IvConverged && op.Vega() > 1e-3)
+		{
+			maxErr = max(maxErr, fabs(vol[i] - b.sig[i]));
+		}
+	}
+
+	cout << "Implied volatility of " << n << " quotes - " << endl;
+	cout << "Converged: " << count[IvConverged] << ", not converged: " << count[IvNotConverged] << ", below intrinsic: " << count[IvBelowIntrinsic] << ", above upper bound: " << count[IvAboveUpperBound] << endl;
+	cout << "Max volatility error: " << maxErr << (maxErr < 1e-8 && count[IvNotConverged] == 0 && count[IvAboveUpperBound] == 1 ? " (ok)" : " (FAILED)") << endl;
+
+	// Throughput on a book of about a million quotes
+	size_t copies = 1000;
+	vector<double> bigQuote, bigT, bigR, bigQ, bigS, bigK;
+	vector<int> bigType;
+	for (size_t c = 0; c < copies; ++c)
+	{
+		bigQuote.insert(bigQuote.end(), quote.begin() + 2, quote.end());
+		bigType.insert(bigType.end(), type.begin() + 2, type.end());
+		bigT.insert(bigT.end(), b.T.begin() + 2, b.T.end());
+		bigR.insert(bigR.end(), b.r.begin() + 2, b.r.end());
+		bigQ.insert(bigQ.end(), b.q.begin() + 2, b.q.end());
+		bigS.insert(bigS.end(), b.S.begin() + 2, b.S.end());
+		bigK.insert(bigK.end(), b.K.begin() + 2, b.K.end());
+	}
+	size_t bigN = bigQuote.size();
+	vector<double> bigVol(bigN);
+	vector<ImpliedVolStatus> bigStatus(bigN);
+
+	auto begin = chrono::high_resolution_clock::now();
+	EuroBatchImpliedVol(&bigQuote[0], &bigType[0], &bigT[0], &bigR[0], &bigQ[0], &bigS[0], &bigK[0], &bigVol[0], &bigStatus[0], bigN);
+	double seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - begin).count();
+	cout << "Inversions per second (one thread): " << bigN / seconds << " (target: tens of millions per core when the loops vectorise, see NormalCdf.h)" << endl;
+}
+
+// Price bumped scenarios of one shared const EuroOption from several threads and compare with a serial run
+void TestConstPricing()
+{
+	const EuroOption shared(0.5, 0.36, 0.1, 0.1, 105, 100);
+	const int nThreads = 4;
+	const int nBumps = 10000;
+	vector<double> serial(nBumps), parallel(nBumps);
+
+	for (int i = 0; i < nBumps; ++i)
+	{
+		EuroParams p = shared.Params();
+		p.S += 0.001 * (i - nBumps / 2);
+		p.sig += 1e-5 * (i % 100);
+		serial[i] = EuroOption::EuroCallPrice(p) + EuroOption::CallDelta(p);
+	}
+
+	vector<thread> workers;
+	for (int t = 0; t < nThreads; ++t)
+	{
+		workers.push_back(thread([&shared, &parallel, t, nThreads, nBumps]()
+		{
+			for (int i = t; i < nBumps; i += nThreads)
+			{
+				EuroParams p = shared.Params();
+				p.S += 0.001 * (i - nBumps / 2);
+				p.sig += 1e-5 * (i % 100);
+				parallel[i] = EuroOption::EuroCallPrice(p) + EuroOption::CallDelta(p);
+			}
+		}));
+	}
+	for (auto& w : workers)
+	{
+		w.join();
+	}
+
+	bool same = (serial == parallel) && shared.Params().S == 105 && shared.Params().sig == 0.36;
+	cout << "Pricing " << nBumps << " bumps of a shared option on " << nThreads << " threads: " << (same ? "identical to serial, option unchanged (ok)" : "(FAILED)") << endl;
+
+	// The underlying overloads and the Taylor approximations leave the option untouched as well
+	shared.CallDeltaApx(105, 0.01);
+	shared.GammaApx(105, 0.01);
+	shared.EuroPutPrice(90);
+	cout << "Underlying after bumped pricing: " << shared.Params().S << (shared.Params().S == 105 ? " (ok)" : " (FAILED)") << endl;
+}
+
+// Price a large flat scenario matrix on one and on all cores, check both agree with EuroOption, and print a small grid
+void TestScenarioEngine()
+{
+	size_t n = 1000000;
+	vector<double> scenarios(n * ScColumns);
+	for (size_t i = 0; i < n; ++i)
+	{
+		double* row = &scenarios[i * ScColumns];
+		row[ScTime] = 0.25 + 0.25 * (i % 8);
+		row[ScStrike] = 80 + (i % 41);
+		row[ScVolatility] = 0.1 + 0.05 * (i % 9);
+		row[ScRate] = 0.01 * (i % 7);
+		row[ScUnderlying] = 100 + 0.001 * (i % 1000);
+		row[ScDividend] = 0.005 * (i % 5);
+	}
+
+	ScenarioResults single, all, three;
+	PriceScenarios(&scenarios[0], n, three, 3); // more threads than this machine may have, exercises the stealing
+	auto begin = chrono::high_resolution_clock::now();
+	PriceScenarios(&scenarios[0], n, single, 1);
+	double oneCore = chrono::duration<double>(chrono::high_resolution_clock::now() - begin).count();
+	begin = chrono::high_resolution_clock::now();
+	PriceScenarios(&scenarios[0], n, all);
+	double allCores = chrono::duration<double>(chrono::high_resolution_clock::now() - begin).count();
+
+	double maxErr = 0.0;
+	for (size_t i = 0; i < n; i += 997)
+	{
+		const double* row = &scenarios[i * ScColumns];
+		EuroOption op(row[ScTime], row[ScVolatility], row[ScRate], row[ScDividend], row[ScUnderlying], row[ScStrike]);
+		maxErr = max(maxErr, max(fabs(all.CallPrice[i] - op.EuroCallPrice()), fabs(all.PutDelta[i] - op.PutDelta())));
+	}
+
+	bool same = single.CallPrice == all.CallPrice && single.Vega == all.Vega && single.PutRho == all.PutRho && single.Gamma == three.Gamma;
+	cout << "Scenario engine on " << n << " scenarios - " << endl;
+	cout << "One core: " << oneCore << "s, " << HardwareThreads() << " threads: " << allCores << "s, results identical: " << (same ? "yes (ok)" : "no (FAILED)") << endl;
+	cout << "Max difference to EuroOption: " << maxErr << (maxErr < 1e-12 ? " (ok)" : " (FAILED)") << endl;
+
+	// The printing MultiFactorPricer now prices through the engine and prints through the sink
+	vector<vector<double>> grid = { {0.25, 80, 0.30, 0.08, 60, 0.0}, {0.50, 85, 0.35, 0.1, 65, 0.01}, {1.00, 90, 0.40, 0.12, 70, 0.02} };
+	EuroOption(0.25, 0.30, 0.08, 0.0, 60, 80).MultiFactorPricer(grid);
+}
+
+// Check spot, volatility and rate ladders against the single functions, for European and American options
+void TestLadders()
+{
+	EuroOption op(0.5, 0.36, 0.1, 0.02, 105, 100);
+	AmericanOption am(0.1, 0.1, 0.02, 110, 100);
+
+	// 0.1 does not add up exactly in floating point, the ladder must still have 201 points ending on 80
+	vector<double> spot = op.FactorCNG(60, 80, 0.1);
+	cout << "Spot ladder 60 to 80 in steps of 0.1: " << spot.size() << " points, last " << spot.back() << (spot.size() == 201 && fabs(spot.back() - 80) < 1e-12 ? " (ok)" : " (FAILED)") << endl;
+
+	size_t n = spot.size();
+	vector<double> call(n), put(n), callDelta(n), putDelta(n), amCall(n), amPut(n);
+	op.SpotLadder(spot.data(), n, call.data(), put.data());
+	op.SpotDeltaLadder(spot.data(), n, callDelta.data(), putDelta.data());
+	am.SpotLadder(spot.data(), n, amCall.data(), amPut.data());
+
+	double maxErr = 0.0, maxErrAm = 0.0;
+	for (size_t i = 0; i < n; ++i)
+	{
+		maxErr = max(maxErr, max(fabs(call[i] - op.EuroCallPrice(spot[i])), fabs(put[i] - op.EuroPutPrice(spot[i]))));
+		maxErr = max(maxErr, max(fabs(callDelta[i] - op.CallDelta(spot[i])), fabs(putDelta[i] - op.PutDelta(spot[i]))));
+		maxErrAm = max(maxErrAm, max(fabs(amCall[i] - am.AmCallPrice(spot[i])), fabs(amPut[i] - am.AmPutPrice(spot[i]))));
+	}
+
+	// Volatility and rate ladders, written into preallocated arrays
+	size_t m = 50;
+	vector<double> vol(m), rate(m), volCall(m), volPut(m), rateCall(m), ratePut(m);
+	FillLadder(0.05, 0.01, m, vol.data());
+	FillLadder(0.0, 0.002, m, rate.data());
+	op.VolLadder(vol.data(), m, volCall.data(), volPut.data());
+	op.RateLadder(rate.data(), m, rateCall.data(), ratePut.data());
+	for (size_t i = 0; i < m; ++i)
+	{
+		EuroParams pv = op.Params(), pr = op.Params();
+		pv.sig = vol[i];
+		pr.r = rate[i];
+		maxErr = max(maxErr, max(fabs(volCall[i] - EuroOption::EuroCallPrice(pv)), fabs(volPut[i] - EuroOption::EuroPutPrice(pv))));
+		maxErr = max(maxErr, max(fabs(rateCall[i] - EuroOption::EuroCallPrice(pr)), fabs(ratePut[i] - EuroOption::EuroPutPrice(pr))));
+	}
+
+	cout << "Max difference of the European ladders to the single functions: " << maxErr << (maxErr < 1e-12 ? " (ok)" : " (FAILED)") << endl;
+	cout << "Max difference of the American ladder to the single functions: " << maxErrAm << (maxErrAm < 1e-10 ? " (ok)" : " (FAILED)") << endl;
+}
+
+// Benchmark single-parameter bumps through the setters, which refresh only the dependent cached terms, against
+// recomputing every getter from scratch through the pure functions
+void TestCachedBumps()
+{
+	const int nBumps = 200000;
+	const char* names[] = { "Underlying", "Volatility", "Rate" };
+
+	cout << setw(12) << "Bumped" << setw(20) << "Cached ns/bump" << setw(20) << "Uncached ns/bump" << setw(12) << "Speedup" << setw(20) << "Max difference" << endl;
+	for (int f = 0; f < 3; ++f)
+	{
+		EuroOption op(0.5, 0.36, 0.1, 0.02, 105, 100);
+		double sumCached = 0.0, sumUncached = 0.0, maxErr = 0.0;
+
+		auto begin = chrono::high_resolution_clock::now();
+		for (int i = 0; i < nBumps; ++i)
+		{
+			double bump = 1e-6 * (i % 1000);
+			if (f == 0) op.SetUnderlying(105 + bump);
+			if (f == 1) op.SetVolatility(0.36 + bump);
+			if (f == 2) op.SetRate(0.1 + bump);
+			sumCached += op.EuroCallPrice() + op.EuroPutPrice() + op.CallDelta() + op.PutDelta() + op.Gamma() + op.Vega() + op.CallTheta() + op.PutTheta();
+		}
+		double cached = chrono::duration<double, nano>(chrono::high_resolution_clock::now() - begin).count() / nBumps;
+
+		begin = chrono::high_resolution_clock::now();
+		for (int i = 0; i < nBumps; ++i)
+		{
+			double bump = 1e-6 * (i % 1000);
+			EuroParams p = { 0.5, 0.36, 0.1, 0.02, 105, 100 };
+			if (f == 0) p.S += bump;
+			if (f == 1) p.sig += bump;
+			if (f == 2) p.r += bump;
+			double all = EuroOption::EuroCallPrice(p) + EuroOption::EuroPutPrice(p) + EuroOption::CallDelta(p) + EuroOption::PutDelta(p) + EuroOption::Gamma(p) + EuroOption::Vega(p) + EuroOption::CallTheta(p) + EuroOption::PutTheta(p);
+			sumUncached += all;
+		}
+		double uncached = chrono::duration<double, nano>(chrono::high_resolution_clock::now() - begin).count() / nBumps;
+
+		// The cached getters must agree with the pure functions after the last bump
+		EuroParams p = op.Params();
+		double cachedValues[] = { op.EuroCallPrice(), op.EuroPutPrice(), op.CallDelta(), op.PutDelta(), op.Gamma(), op.Vega(), op.CallTheta(), op.PutTheta(), op.d1(), op.d2() };
+		double pureValues[] = { EuroOption::EuroCallPrice(p), EuroOption::EuroPutPrice(p), EuroOption::CallDelta(p), EuroOption::PutDelta(p), EuroOption::Gamma(p), EuroOption::Vega(p), EuroOption::CallTheta(p), EuroOption::PutTheta(p), EuroOption::d1(p), EuroOption::d2(p) };
+		for (int k = 0; k < 10; ++k)
+		{
+			maxErr = max(maxErr, fabs(cachedValues[k] - pureValues[k]));
+		}
+		maxErr = max(maxErr, fabs(sumCached - sumUncached) / nBumps);
+
+		cout << setw(12) << names[f] << setw(20) << cached << setw(20) << uncached << setw(12) << uncached / cached << setw(20) << maxErr << (maxErr < 1e-12 ? " (ok)" : " (FAILED)") << endl;
+	}
+}
+
 void main()
 {
 	// Calculate and print European Option Prices from batch 1 to 4 
@@ -116,5 +1704,99 @@ void main()
 	vector<vector<double>> scenarios3 = { {80, 0.3, 0.08, 95, 0.0}, {120, 0.25, 0.1, 100, 0.01}, {90, 0.10, 0.12, 105, 0.02}, {95, 0.15, 0.14, 90, 0.03}, {100, 0.05, 0.16, 110, 0.04}, {105, 0.25, 0.18, 115, 0.05},{110, 0.20, 0.20, 120, 0.06} };
 
 	Amop.MultiFactorPricer(scenarios3);*/
+
+	cout << endl;
+
+	// Test the batch (structure-of-arrays) pricer
+	TestEuroBatch();
+
+	cout << endl;
+
+	// Test the fused price and Greeks kernel
+	TestAllGreeks();
+
+	cout << endl;
+
+	// Test the accuracy tiers of the normal cdf
+	TestNormalCdf();
+
+	cout << endl;
+
+	// Test the batch implied volatility solver
+	TestImpliedVol();
+
+	cout << endl;
+
+	// Test pricing a shared option from several threads
+	TestConstPricing();
+
+	cout << endl;
+
+	// Test the parallel scenario engine
+	TestScenarioEngine();
+
+	cout << endl;
+
+	// Test the spot, volatility and rate ladders
+	TestLadders();
+
+	cout << endl;
+
+	// Benchmark the cached terms of EuroOption under single-parameter bumps
+	TestCachedBumps();
+
+	cout << endl;
+
+	// Test the higher order Greeks of the batch kernel
+	TestHigherGreeks();
+
+	cout << endl;
+
+	// Benchmark the adjoint gradient against bump-and-reprice
+	TestAad();
+
+	cout << endl;
+
+	// Test the finite maturity American pricers
+	TestAmericanBatch();
+
+	cout << endl;
+
+	// Benchmark the shared exponents of the perpetual American option
+	TestPerpetualExponents();
+
+	cout << endl;
+
+	// Test the price surrogate
+	TestSurrogate();
+
+	cout << endl;
+
+	// Test the portfolio aggregation
+	TestPortfolio();
+
+	cout << endl;
+	// Test the term structure cache
+	TestTermCache();
+
+	cout << endl;
+	// Test the incremental repricing of a live book
+	TestTickEngine();
+
+	cout << endl;
+	// Test the arbitrage checks of a snapshot
+	TestArbitrage();
+
+	cout << endl;
+	// Test the single precision batch path
+	TestSinglePrecision();
+
+	cout << endl;
+	// Test the model policies on a mixed book
+	TestModels();
+
+	cout << endl;
+	// Test the volatility surface
+	TestVolSurface();
 }
 
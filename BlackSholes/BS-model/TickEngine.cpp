@@ -0,0 +1,512 @@
+// Group A & B: Source file for the incremental repricing of a live option book on spot, volatility and rate ticks
+
+#include "TickEngine.h"
+#include "Scheduler.h"
+#include <algorithm>
+#include <cmath>
+using namespace std;
+
+namespace Options
+{
+	const size_t LatencyLinear = 64; // latencies below this have their own bucket
+	const size_t LatencySteps = 32; // buckets per power of two above it
+	const size_t LatencyBuckets = LatencyLinear + (64 - 6) * LatencySteps;
+	const size_t TickChunk = 256; // contracts per chunk; fixed so the totals never depend on the threads
+	const size_t TickThreadContracts = 2048; // contracts an update needs per thread before another thread pays for its start
+
+	LatencyHistogram::LatencyHistogram() : counts(LatencyBuckets, 0), total(0), largest(0), sum(0.0) // default constructor
+	{}
+
+	// Function to return the bucket of a latency: its top 6 bits select the bucket within its power of two
+	size_t LatencyHistogram::Bucket(unsigned long long ns)
+	{
+		if (ns < LatencyLinear) return size_t(ns);
+
+		size_t e = 6;
+		while ((ns >> (e + 1)) != 0) ++e;
+		return LatencyLinear + (e - 6) * LatencySteps + size_t(ns >> (e - 5)) - LatencySteps;
+	}
+
+	// Function to return the largest latency of a bucket
+	unsigned long long LatencyHistogram::Upper(size_t bucket)
+	{
+		if (bucket < LatencyLinear) return bucket;
+
+		size_t e = (bucket - LatencyLinear) / LatencySteps + 6;
+		unsigned long long lower = (unsigned long long)((bucket - LatencyLinear) % LatencySteps + LatencySteps) << (e - 5);
+		return lower + (1ULL << (e - 5)) - 1;
+	}
+
+	// Function to add a latency
+	void LatencyHistogram::Record(unsigned long long ns)
+	{
+		++counts[Bucket(ns)];
+		++total;
+		largest = max(largest, ns);
+		sum += double(ns);
+	}
+
+	// Function to remove all latencies
+	void LatencyHistogram::Clear()
+	{
+		fill(counts.begin(), counts.end(), 0ULL);
+		total = 0;
+		largest = 0;
+		sum = 0.0;
+	}
+
+	// Function to return the number of latencies
+	unsigned long long LatencyHistogram::Count() const
+	{
+		return total;
+	}
+
+	// Function to return the largest latency
+	unsigned long long LatencyHistogram::Max() const
+	{
+		return largest;
+	}
+
+	// Function to return the mean latency
+	double LatencyHistogram::Mean() const
+	{
+		return (total == 0) ? 0.0 : sum / double(total);
+	}
+
+	// Function to return the latency that p percent of the latencies do not exceed, as the upper bound of its bucket
+	// but never above the largest latency
+	unsigned long long LatencyHistogram::Percentile(double p) const
+	{
+		if (total == 0) return 0;
+
+		unsigned long long rank = (unsigned long long)ceil(p / 100.0 * double(total));
+		rank = max(rank, 1ULL);
+		unsigned long long seen = 0;
+		for (size_t b = 0; b < counts.size(); ++b)
+		{
+			seen += counts[b];
+			if (seen >= rank) return min(Upper(b), largest);
+		}
+		return largest;
+	}
+
+	// Function to return a - b, field by field
+	static PortfolioTotals Difference(const PortfolioTotals& a, const PortfolioTotals& b)
+	{
+		PortfolioTotals d = { a.Price - b.Price, a.Delta - b.Delta, a.Gamma - b.Gamma, a.Vega - b.Vega, a.Theta - b.Theta, a.Rho - b.Rho };
+		return d;
+	}
+
+	// Function to add b into a, field by field
+	static void Accumulate(PortfolioTotals& a, const PortfolioTotals& b)
+	{
+		a.Price += b.Price;
+		a.Delta += b.Delta;
+		a.Gamma += b.Gamma;
+		a.Vega += b.Vega;
+		a.Theta += b.Theta;
+		a.Rho += b.Rho;
+	}
+
+	TickEngine::TickEngine(CdfTier cdfTier, unsigned nThreads) : tier(cdfTier), threads((nThreads == 0) ? HardwareThreads() : nThreads), pool(new WorkerPool(threads)),
+		spotMode(SpotReprice), spotBand(0.005) // constructor with the cdf tier of the batch kernel and the most threads of an update
+	{
+		PortfolioTotals zero = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+		total = zero;
+	}
+
+	TickEngine::TickEngine(const TickEngine& source) : terms(source.terms), slices(source.slices), assets(source.assets), index(source.index), termSlices(source.termSlices),
+		listeners(source.listeners), total(source.total), tier(source.tier), threads(source.threads), pool(new WorkerPool(source.threads)), spotMode(source.spotMode),
+		spotBand(source.spotBand) // copy constructor, the copy starting threads of its own
+	{
+		for (int k = 0; k < TickTypes; ++k)
+		{
+			latency[k] = source.latency[k];
+		}
+	}
+
+	TickEngine::~TickEngine() // destructor
+	{}
+
+	// Function to add an underlying with its rate and dividend curve
+	void TickEngine::AddUnderlying(int underlying, double spot, int rateCurve, int divCurve)
+	{
+		Asset a;
+		a.Spot = spot;
+		a.RateCurve = rateCurve;
+		a.DivCurve = divCurve;
+		PortfolioTotals zero = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+		a.Totals = zero;
+		assets[underlying] = a;
+	}
+
+	// Function to set the pillars of a curve without repricing, e.g. before Reprice
+	void TickEngine::SetCurve(int curve, const vector<double>& tenor, const vector<double>& zero)
+	{
+		terms.SetCurve(curve, tenor, zero);
+	}
+
+	// Function to add a position (type 1 == call, -1 == put) on an added underlying and return its slice. An underlying that
+	// was not added has no spot and no curves, so its positions are rejected rather than priced at zero
+	size_t TickEngine::AddPosition(int underlying, int type, double quantity, double T, double sig, double K)
+	{
+		auto found = assets.find(underlying);
+		if (found == assets.end()) return NoSlice;
+
+		Asset& a = found->second;
+		pair<int, double> key(underlying, T);
+		auto it = index.find(key);
+		size_t b;
+		if (it == index.end())
+		{
+			b = slices.size();
+			slices.push_back(Slice());
+			Slice& s = slices[b];
+			s.Underlying = underlying;
+			s.Expiry = T;
+			s.Anchor = a.Spot;
+			PortfolioTotals zero = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+			s.Priced = zero;
+			s.Totals = zero;
+			a.slices.push_back(b);
+			index[key] = b;
+
+			size_t rate = terms.Term(a.RateCurve, T), div = terms.Term(a.DivCurve, T);
+			termSlices.resize(terms.Terms());
+			termSlices[rate].push_back(b);
+			if (div != rate)
+			{
+				termSlices[div].push_back(b);
+			}
+		}
+		else
+		{
+			b = it->second;
+		}
+
+		Slice& s = slices[b];
+		s.rateTerm.push_back(terms.Term(a.RateCurve, T));
+		s.divTerm.push_back(terms.Term(a.DivCurve, T));
+		s.sig.push_back(sig);
+		s.S.push_back(a.Spot);
+		s.K.push_back(K);
+		s.Phi.push_back(type == 1 ? 1.0 : -1.0);
+		s.Quantity.push_back(quantity);
+		return b;
+	}
+
+	// Function to reprice the touched slices at the spot of their underlying, which becomes their anchor, update their totals
+	// and return the number of contracts repriced. Every chunk is priced by the batch kernel and summed position by position,
+	// and a slice sums its chunks in order, so the totals are the same on any number of threads. Small updates stay on the
+	// calling thread, where handing chunks to the pool would cost more than it saves
+	size_t TickEngine::PriceTouched()
+	{
+		chunkSlice.clear();
+		chunkBegin.clear();
+		size_t contracts = 0;
+		for (size_t b : touched)
+		{
+			Slice& s = slices[b];
+			double spot = assets[s.Underlying].Spot;
+			if (s.Anchor != spot)
+			{
+				fill(s.S.begin(), s.S.end(), spot);
+				s.Anchor = spot;
+			}
+			for (size_t begin = 0; begin < slices[b].Size(); begin += TickChunk)
+			{
+				chunkSlice.push_back(b);
+				chunkBegin.push_back(begin);
+			}
+			contracts += slices[b].Size();
+		}
+		size_t nChunks = chunkSlice.size();
+		chunkTotals.resize(nChunks);
+
+		unsigned nThreads = unsigned(min(size_t(threads), max(contracts / TickThreadContracts, size_t(1))));
+		pool->Run(nChunks, 1, [&](size_t begin, size_t end)
+		{
+			double cp[TickChunk], pp[TickChunk], cd[TickChunk], pd[TickChunk], ga[TickChunk], ve[TickChunk], ct[TickChunk], pt[TickChunk], cr[TickChunk], pr[TickChunk];
+			EuroGreeksArrays g = { cp, pp, cd, pd, ga, ve, ct, pt, cr, pr };
+
+			for (size_t c = begin; c < end; ++c)
+			{
+				const Slice& s = slices[chunkSlice[c]];
+				size_t first = chunkBegin[c];
+				size_t m = min(TickChunk, s.Size() - first);
+				terms.EuroBatchGreeks(&s.rateTerm[first], &s.divTerm[first], &s.sig[first], &s.S[first], &s.K[first], g, m, tier);
+
+				PortfolioTotals sum = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+				for (size_t i = 0; i < m; ++i)
+				{
+					double w = s.Quantity[first + i];
+					bool isCall = s.Phi[first + i] > 0.0;
+					sum.Price += w * (isCall ? cp[i] : pp[i]);
+					sum.Delta += w * (isCall ? cd[i] : pd[i]);
+					sum.Gamma += w * ga[i];
+					sum.Vega += w * ve[i];
+					sum.Theta += w * (isCall ? ct[i] : pt[i]);
+					sum.Rho += w * (isCall ? cr[i] : pr[i]);
+				}
+				chunkTotals[c] = sum;
+			}
+		}, nThreads);
+
+		PortfolioTotals zero = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+		for (size_t c = 0; c < nChunks; ++c)
+		{
+			Slice& s = slices[chunkSlice[c]];
+			if (chunkBegin[c] == 0) s.Totals = zero;
+			Accumulate(s.Totals, chunkTotals[c]);
+		}
+		for (size_t b : touched)
+		{
+			slices[b].Priced = slices[b].Totals;
+		}
+		return contracts;
+	}
+
+	// Function to reprice the whole book, e.g. after adding positions; nothing is published
+	void TickEngine::Reprice()
+	{
+		PortfolioTotals zero = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+		total = zero;
+		touched.clear();
+		for (size_t b = 0; b < slices.size(); ++b)
+		{
+			touched.push_back(b);
+		}
+		PriceTouched();
+
+		for (auto it = assets.begin(); it != assets.end(); ++it)
+		{
+			it->second.Totals = zero;
+			for (size_t b : it->second.slices)
+			{
+				Accumulate(it->second.Totals, slices[b].Totals);
+			}
+			Accumulate(total, it->second.Totals);
+		}
+	}
+
+	// Function to add a listener for the risk changes
+	void TickEngine::Subscribe(const function<void(const RiskDelta&)>& listener)
+	{
+		listeners.push_back(listener);
+	}
+
+	// Function to reprice the touched slices, sum them into their underlyings, record the latency and publish. The totals of an
+	// underlying are summed again over all its slices in a fixed order, so they never drift however many updates are applied
+	size_t TickEngine::Refresh(TickType type, chrono::steady_clock::time_point start)
+	{
+		sort(touched.begin(), touched.end());
+		touched.erase(unique(touched.begin(), touched.end()), touched.end());
+
+		size_t repriced = PriceTouched();
+		for (size_t b : touched)
+		{
+			moved.push_back(slices[b].Underlying);
+		}
+		sort(moved.begin(), moved.end());
+		moved.erase(unique(moved.begin(), moved.end()), moved.end());
+
+		deltas.clear();
+		for (int u : moved)
+		{
+			Asset& a = assets[u];
+			RiskDelta d;
+			d.Type = type;
+			d.Underlying = u;
+			d.Repriced = 0;
+			PortfolioTotals sum = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+			for (size_t b : a.slices)
+			{
+				Accumulate(sum, slices[b].Totals);
+			}
+			for (size_t b : touched)
+			{
+				d.Repriced += (slices[b].Underlying == u) ? slices[b].Size() : 0;
+			}
+			d.Change = Difference(sum, a.Totals);
+			d.Totals = sum;
+			a.Totals = sum;
+			deltas.push_back(d);
+		}
+
+		PortfolioTotals zero = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+		total = zero;
+		for (auto it = assets.begin(); it != assets.end(); ++it)
+		{
+			Accumulate(total, it->second.Totals);
+		}
+
+		latency[type].Record((unsigned long long)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count());
+
+		for (const RiskDelta& d : deltas)
+		{
+			for (const auto& listener : listeners)
+			{
+				listener(d);
+			}
+		}
+		return repriced;
+	}
+
+	// Function to choose how spot ticks update the slices. A slice moved by SpotDeltaGamma keeps its Taylor totals until it
+	// is next repriced, also after switching back to SpotReprice
+	void TickEngine::SetSpotMode(SpotMode mode, double band)
+	{
+		spotMode = mode;
+		spotBand = band;
+	}
+
+	// Function to apply a spot tick and return the number of contracts repriced. With SpotDeltaGamma a slice still inside the
+	// band around its anchor takes its totals from the anchor totals by the second order Taylor step in the spot move
+	size_t TickEngine::OnSpot(int underlying, double spot)
+	{
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		auto it = assets.find(underlying);
+		if (it == assets.end()) return 0;
+
+		it->second.Spot = spot;
+		touched.clear();
+		moved.clear();
+		moved.push_back(underlying);
+		for (size_t b : it->second.slices)
+		{
+			Slice& s = slices[b];
+			double h = spot - s.Anchor;
+			if (spotMode == SpotReprice || fabs(h) > spotBand * s.Anchor)
+			{
+				touched.push_back(b);
+			}
+			else
+			{
+				s.Totals = s.Priced;
+				s.Totals.Price += (s.Priced.Delta + 0.5 * s.Priced.Gamma * h) * h;
+				s.Totals.Delta += s.Priced.Gamma * h;
+			}
+		}
+		return Refresh(TickSpot, start);
+	}
+
+	// Function to shift the volatilities of the slice (underlying, T) by dSig and return the number of contracts repriced
+	size_t TickEngine::OnVol(int underlying, double T, double dSig)
+	{
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		auto it = index.find(pair<int, double>(underlying, T));
+		if (it == index.end()) return 0;
+
+		Slice& s = slices[it->second];
+		for (double& v : s.sig)
+		{
+			v += dSig;
+		}
+		touched.clear();
+		touched.push_back(it->second);
+		moved.clear();
+		return Refresh(TickVol, start);
+	}
+
+	// Function to collect the slices on the terms whose stamp a curve update moved past the generation before it
+	void TickEngine::TouchTerms(unsigned before)
+	{
+		touched.clear();
+		moved.clear();
+		for (size_t t = 0; t < termSlices.size(); ++t)
+		{
+			if (terms.Stamp(t) > before)
+			{
+				touched.insert(touched.end(), termSlices[t].begin(), termSlices[t].end());
+			}
+		}
+	}
+
+	// Function to replace the pillars of a curve and return the number of contracts repriced
+	size_t TickEngine::OnCurve(int curve, const vector<double>& tenor, const vector<double>& zero)
+	{
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		unsigned before = terms.Generation();
+		terms.SetCurve(curve, tenor, zero);
+
+		TouchTerms(before);
+		return Refresh(TickRate, start);
+	}
+
+	// Function to shift a curve in parallel and return the number of contracts repriced
+	size_t TickEngine::OnCurveShift(int curve, double dz)
+	{
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		unsigned before = terms.Generation();
+		terms.ShiftCurve(curve, dz);
+
+		TouchTerms(before);
+		return Refresh(TickRate, start);
+	}
+
+	// Function to return the number of positions
+	size_t TickEngine::Positions() const
+	{
+		size_t n = 0;
+		for (size_t b = 0; b < slices.size(); ++b)
+		{
+			n += slices[b].Size();
+		}
+		return n;
+	}
+
+	// Function to return the number of positions on an underlying
+	size_t TickEngine::Positions(int underlying) const
+	{
+		auto it = assets.find(underlying);
+		if (it == assets.end()) return 0;
+
+		size_t n = 0;
+		for (size_t b : it->second.slices)
+		{
+			n += slices[b].Size();
+		}
+		return n;
+	}
+
+	// Function to return the position-weighted totals of an underlying, zero if it was not added
+	const PortfolioTotals& TickEngine::Totals(int underlying) const
+	{
+		static const PortfolioTotals zero = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+		auto it = assets.find(underlying);
+		return (it == assets.end()) ? zero : it->second.Totals;
+	}
+
+	// Function to return the position-weighted totals of the book
+	const PortfolioTotals& TickEngine::Total() const
+	{
+		return total;
+	}
+
+	// Function to return the most threads an update may use
+	unsigned TickEngine::Threads() const
+	{
+		return threads;
+	}
+
+	// Function to return how spot ticks update the slices
+	SpotMode TickEngine::GetSpotMode() const
+	{
+		return spotMode;
+	}
+
+	// Function to return the latency histogram of an update type
+	const LatencyHistogram& TickEngine::Latency(TickType type) const
+	{
+		return latency[type];
+	}
+
+	// Function to clear the latency histograms
+	void TickEngine::ClearLatency()
+	{
+		for (int k = 0; k < TickTypes; ++k)
+		{
+			latency[k].Clear();
+		}
+	}
+}
@@ -0,0 +1,151 @@
+// Group A & B: Header file for the incremental repricing of a live option book on spot, volatility and rate ticks
+
+#ifndef TickEngineHPP
+#define TickEngineHPP
+
+#include "Portfolio.h"
+#include "TermCache.h"
+#include <vector>
+#include <map>
+#include <functional>
+#include <chrono>
+#include <memory>
+#include <cstddef>
+using namespace std;
+
+namespace Options
+{
+	enum TickType { TickSpot, TickVol, TickRate, TickTypes }; // kinds of update, TickTypes is their number
+
+	// How a spot tick updates the slices of its underlying. SpotReprice reprices every contract. SpotDeltaGamma reprices a
+	// slice only once the spot has left a band around the spot the slice was last priced at (its anchor); inside the band it
+	// moves the anchor totals by the spot move h as Price + Delta h + Gamma h^2 / 2 and Delta + Gamma h, in O(1) per slice.
+	// Per position the Price is then off by about Speed h^3 / 6 and the Delta by Speed h^2 / 2, while Gamma, Vega, Theta and
+	// Rho keep their anchor values, off to first order in h (Speed h, Vanna h, ...). A volatility or curve update reprices its
+	// slices at the current spot, which moves their anchor
+	enum SpotMode { SpotReprice, SpotDeltaGamma };
+
+	class WorkerPool;
+
+	const size_t NoSlice = size_t(-1); // returned by TickEngine::AddPosition for an underlying that was not added
+
+	// Histogram of latencies in nanoseconds. Values below 64 have their own bucket, above that every power of two is split
+	// into 32 buckets, so a percentile is exact to about 3%, whatever the scale
+	class LatencyHistogram
+	{
+		private:
+			vector<unsigned long long> counts;
+			unsigned long long total, largest;
+			double sum;
+
+			static size_t Bucket(unsigned long long ns); // function to return the bucket of a latency
+			static unsigned long long Upper(size_t bucket); // function to return the largest latency of a bucket
+
+		public:
+			LatencyHistogram(); // default constructor, the implicit copy and assignment are member-wise
+
+			void Record(unsigned long long ns); // function to add a latency
+			void Clear(); // function to remove all latencies
+			unsigned long long Count() const; // function to return the number of latencies
+			unsigned long long Max() const; // function to return the largest latency
+			double Mean() const; // function to return the mean latency
+			unsigned long long Percentile(double p) const; // function to return the latency that p percent of the latencies do not exceed (upper bound of its bucket)
+	};
+
+	// Change of the risk of one underlying caused by one update, published after every update that touched it
+	struct RiskDelta
+	{
+		TickType Type;
+		int Underlying;
+		size_t Repriced; // contracts of this underlying repriced by the update
+		PortfolioTotals Change; // new minus old position-weighted totals
+		PortfolioTotals Totals; // new position-weighted totals of the underlying
+	};
+
+	// A live book of European positions indexed by underlying and, below that, by expiry into slices. Each slice holds its
+	// contracts as structure of arrays and depends on one spot, on its own volatilities and on one rate and one dividend term
+	// of the TermCache. An update reprices with the batch kernels only the slices depending on what moved: a spot tick the
+	// slices of its underlying, a volatility tick one slice, a curve update the slices on terms of that curve. The touched
+	// slices are cut into fixed chunks that the scheduler spreads over the threads once an update is large enough to pay
+	// for them on threads the engine starts once. The totals of the repriced slices are summed again and the change per
+	// underlying is published to the listeners
+	class TickEngine
+	{
+		private:
+			struct Slice
+			{
+				int Underlying;
+				double Expiry;
+				vector<size_t> rateTerm, divTerm; // every entry the slice's rate and dividend term, as the batch kernel reads arrays
+				vector<double> sig, S, K, Phi, Quantity;
+				double Anchor; // spot of every entry of S, at which the slice was last repriced
+				PortfolioTotals Priced; // totals at the anchor
+				PortfolioTotals Totals; // totals at the spot of the underlying, equal to Priced unless moved by SpotDeltaGamma
+
+				size_t Size() const { return K.size(); } // function to return the number of contracts
+			};
+
+			struct Asset
+			{
+				double Spot;
+				int RateCurve, DivCurve;
+				vector<size_t> slices;
+				PortfolioTotals Totals;
+			};
+
+			TermCache terms;
+			vector<Slice> slices;
+			map<int, Asset> assets;
+			map<pair<int, double>, size_t> index; // (underlying, expiry) to slice
+			vector<vector<size_t> > termSlices; // term to the slices that depend on it
+			vector<function<void(const RiskDelta&)> > listeners;
+			LatencyHistogram latency[TickTypes];
+			PortfolioTotals total;
+			CdfTier tier;
+			unsigned threads; // most threads an update may use
+			unique_ptr<WorkerPool> pool; // threads of the updates, started by the constructor
+			SpotMode spotMode;
+			double spotBand; // relative spot move from the anchor beyond which SpotDeltaGamma reprices a slice
+
+			vector<size_t> touched; // slices to reprice in the current update
+			vector<size_t> chunkSlice, chunkBegin; // slice and first contract of every chunk of the touched slices
+			vector<PortfolioTotals> chunkTotals; // position-weighted totals of every chunk
+			vector<int> moved; // underlyings of the touched slices and of the spot tick
+			vector<RiskDelta> deltas; // changes to publish for the current update
+
+			size_t PriceTouched(); // function to reprice the touched slices, update their totals and return the number of contracts repriced
+			void TouchTerms(unsigned before); // function to collect the slices on the terms changed since generation before
+			size_t Refresh(TickType type, chrono::steady_clock::time_point start); // function to reprice the touched slices, sum them into their underlyings, record the latency and publish
+
+		public:
+			TickEngine(CdfTier cdfTier = CdfExact, unsigned nThreads = 0); // constructor with the cdf tier of the batch kernel and the most threads of an update, 0 means HardwareThreads()
+			TickEngine(const TickEngine& source); // copy constructor
+			~TickEngine(); // destructor
+
+			void AddUnderlying(int underlying, double spot, int rateCurve, int divCurve); // function to add an underlying with its rate and dividend curve
+			void SetCurve(int curve, const vector<double>& tenor, const vector<double>& zero); // function to set the pillars of a curve without repricing, e.g. before Reprice
+			size_t AddPosition(int underlying, int type, double quantity, double T, double sig, double K); // function to add a position (type 1 == call, -1 == put) on an added underlying and return its slice, or NoSlice if the underlying was not added
+			void Reprice(); // function to reprice the whole book, e.g. after adding positions; nothing is published
+
+			void Subscribe(const function<void(const RiskDelta&)>& listener); // function to add a listener for the risk changes
+			void SetSpotMode(SpotMode mode, double band = 0.005); // function to choose how spot ticks update the slices, band being the relative spot move of SpotDeltaGamma before a slice is repriced
+
+			// Updates. Each one reprices only the dependent slices and publishes one RiskDelta per touched underlying. The latency
+			// recorded for its type runs from the call to just before the listeners are called
+			size_t OnSpot(int underlying, double spot); // function to apply a spot tick as set by SetSpotMode and return the number of contracts repriced
+			size_t OnVol(int underlying, double T, double dSig); // function to shift the volatilities of the slice (underlying, T) by dSig and return the number of contracts repriced
+			size_t OnCurve(int curve, const vector<double>& tenor, const vector<double>& zero); // function to replace the pillars of a curve and return the number of contracts repriced
+			size_t OnCurveShift(int curve, double dz); // function to shift a curve in parallel and return the number of contracts repriced
+
+			size_t Positions() const; // function to return the number of positions
+			size_t Positions(int underlying) const; // function to return the number of positions on an underlying
+			const PortfolioTotals& Totals(int underlying) const; // function to return the position-weighted totals of an underlying, zero if it was not added
+			const PortfolioTotals& Total() const; // function to return the position-weighted totals of the book
+			unsigned Threads() const; // function to return the most threads an update may use
+			SpotMode GetSpotMode() const; // function to return how spot ticks update the slices
+			const LatencyHistogram& Latency(TickType type) const; // function to return the latency histogram of an update type
+			void ClearLatency(); // function to clear the latency histograms
+	};
+}
+
+#endif
@@ -0,0 +1,227 @@
+// Group A & B: Source file for an implied volatility surface by expiry and strike, feeding the batch pricers
+
+#include "VolSurface.h"
+#include "EuroBatch.h"
+#include <algorithm>
+#include <cmath>
+using namespace std;
+
+namespace Options
+{
+	const size_t SurfaceBlock = 64; // contracts whose volatilities are looked up per call of the batch pricer
+
+	VolSurface::VolSurface() // default constructor
+	{}
+
+	VolSurface::VolSurface(const VolSurface& source) : expiry(source.expiry), first(source.first), strike(source.strike), a(source.a), b(source.b), c(source.c), d(source.d) // copy constructor
+	{}
+
+	VolSurface::~VolSurface() // destructor
+	{}
+
+	// Function to rebuild the surface from a snapshot. The vectors are resized, so a rebuild of a snapshot no larger than
+	// the previous one reuses their storage
+	bool VolSurface::Build(size_t expiries, const double* T, const size_t* strikeBegin, const double* K, const double* vol)
+	{
+		expiry.clear(); first.clear(); strike.clear();
+		a.clear(); b.clear(); c.clear(); d.clear();
+
+		// Check the snapshot before anything is stored
+		if (expiries == 0)
+		{
+			return false;
+		}
+		for (size_t e = 0; e < expiries; ++e)
+		{
+			if (T[e] <= 0.0 || (e > 0 && T[e] <= T[e - 1]) || strikeBegin[e + 1] <= strikeBegin[e])
+			{
+				return false;
+			}
+			for (size_t k = strikeBegin[e]; k < strikeBegin[e + 1]; ++k)
+			{
+				if (vol[k] <= 0.0 || (k > strikeBegin[e] && K[k] <= K[k - 1]))
+				{
+					return false;
+				}
+			}
+		}
+
+		size_t base = strikeBegin[0], n = strikeBegin[expiries] - base;
+		expiry.assign(T, T + expiries);
+		first.resize(expiries + 1);
+		strike.assign(K + base, K + base + n);
+		a.resize(n); b.resize(n); c.resize(n); d.resize(n);
+		diag.resize(n); upper.resize(n); rhs.resize(n);
+		for (size_t e = 0; e <= expiries; ++e)
+		{
+			first[e] = strikeBegin[e] - base;
+		}
+
+		for (size_t e = 0; e < expiries; ++e)
+		{
+			size_t lo = first[e], m = first[e + 1] - lo;
+			const double* x = &strike[lo];
+			double* y = &a[lo];
+			for (size_t k = 0; k < m; ++k)
+			{
+				y[k] = vol[base + lo + k] * vol[base + lo + k] * T[e];
+			}
+
+			// Second derivatives M of the natural spline, M[0] = M[m - 1] = 0, by the Thomas algorithm; kept in c for now
+			double* M = &c[lo];
+			M[0] = 0.0;
+			M[m - 1] = 0.0;
+			for (size_t k = 1; k + 1 < m; ++k)
+			{
+				double h0 = x[k] - x[k - 1], h1 = x[k + 1] - x[k];
+				diag[k] = 2 * (h0 + h1);
+				upper[k] = h1;
+				rhs[k] = 6 * ((y[k + 1] - y[k]) / h1 - (y[k] - y[k - 1]) / h0);
+				if (k > 1)
+				{
+					double factor = h0 / diag[k - 1];
+					diag[k] -= factor * upper[k - 1];
+					rhs[k] -= factor * rhs[k - 1];
+				}
+			}
+			for (size_t k = m - 1; k-- > 1;)
+			{
+				M[k] = (rhs[k] - upper[k] * M[k + 1]) / diag[k];
+			}
+
+			// Coefficients of each interval; the last strike's entry holds the flat extrapolation
+			for (size_t k = 0; k + 1 < m; ++k)
+			{
+				double h = x[k + 1] - x[k];
+				b[lo + k] = (y[k + 1] - y[k]) / h - h * (2 * M[k] + M[k + 1]) / 6;
+				d[lo + k] = (M[k + 1] - M[k]) / (6 * h);
+				c[lo + k] = M[k] / 2;
+			}
+			b[lo + m - 1] = 0.0;
+			c[lo + m - 1] = 0.0;
+			d[lo + m - 1] = 0.0;
+		}
+		return true;
+	}
+
+	// Function to return the number of expiries at or before T
+	size_t VolSurface::Bracket(double T) const
+	{
+		return upper_bound(expiry.begin(), expiry.end(), T) - expiry.begin();
+	}
+
+	// Function to return the total variance of expiry e at strike K, moving the interval i forward from where the previous,
+	// lower strike left it; i starts at first[e]
+	double VolSurface::Walk(size_t e, size_t& i, double K) const
+	{
+		size_t lo = first[e], hi = first[e + 1] - 1;
+		if (K <= strike[lo]) return a[lo];
+		if (K >= strike[hi]) return a[hi];
+
+		while (strike[i + 1] < K) ++i;
+		double x = K - strike[i];
+		return a[i] + x * (b[i] + x * (c[i] + x * d[i]));
+	}
+
+	// Function to return the total variance of expiry e at strike K, by binary search for the interval
+	double VolSurface::Variance(size_t e, double K) const
+	{
+		size_t lo = first[e], hi = first[e + 1];
+		size_t i = upper_bound(strike.begin() + lo, strike.begin() + hi, K) - strike.begin();
+		i = (i > lo) ? i - 1 : lo; // beyond the outer strikes Walk returns the flat value without reading i
+		return Walk(e, i, K);
+	}
+
+	// Function to return the number of expiries
+	size_t VolSurface::Expiries() const
+	{
+		return expiry.size();
+	}
+
+	// Function to return the number of quotes
+	size_t VolSurface::Quotes() const
+	{
+		return strike.size();
+	}
+
+	// Function to return the volatility at one expiry and strike
+	double VolSurface::Vol(double T, double K) const
+	{
+		size_t E = expiry.size();
+		if (E == 0) return 0.0;
+
+		size_t e = Bracket(T);
+		size_t lo = (e == 0) ? 0 : e - 1, hi = (e == E) ? E - 1 : e;
+		if (lo == hi || expiry[lo] == T)
+		{
+			return sqrt(max(Variance(lo, K), 0.0) / expiry[lo]); // flat volatility outside the expiries
+		}
+
+		double weight = (T - expiry[lo]) / (expiry[hi] - expiry[lo]);
+		double wLo = Variance(lo, K), wHi = Variance(hi, K);
+		return sqrt(max(wLo + weight * (wHi - wLo), 0.0) / T);
+	}
+
+	// Function to return the volatilities of one expiry at n increasing strikes, walking the coefficients of the two
+	// neighbouring expiries in order
+	void VolSurface::Vols(double T, const double* K, double* vol, size_t n) const
+	{
+		size_t E = expiry.size();
+		if (E == 0)
+		{
+			fill(vol, vol + n, 0.0);
+			return;
+		}
+
+		size_t e = Bracket(T);
+		size_t lo = (e == 0) ? 0 : e - 1, hi = (e == E) ? E - 1 : e;
+		size_t i = first[lo], j = first[hi];
+		if (lo == hi || expiry[lo] == T)
+		{
+			for (size_t k = 0; k < n; ++k)
+			{
+				vol[k] = sqrt(max(Walk(lo, i, K[k]), 0.0) / expiry[lo]);
+			}
+			return;
+		}
+
+		double weight = (T - expiry[lo]) / (expiry[hi] - expiry[lo]);
+		for (size_t k = 0; k < n; ++k)
+		{
+			double wLo = Walk(lo, i, K[k]), wHi = Walk(hi, j, K[k]);
+			vol[k] = sqrt(max(wLo + weight * (wHi - wLo), 0.0) / T);
+		}
+	}
+
+	// Function to return the volatilities of n contracts; runs of equal T with increasing K take the walking path
+	void VolSurface::Vols(const double* T, const double* K, double* vol, size_t n) const
+	{
+		size_t i = 0;
+		while (i < n)
+		{
+			size_t j = i + 1;
+			while (j < n && T[j] == T[i] && K[j] >= K[j - 1]) ++j;
+			if (j - i > 1)
+			{
+				Vols(T[i], K + i, vol + i, j - i);
+			}
+			else
+			{
+				vol[i] = Vol(T[i], K[i]);
+			}
+			i = j;
+		}
+	}
+
+	// Function to price n European call and put options at the surface's volatilities, block by block into stack scratch
+	void SurfaceBatchPrice(const VolSurface& surface, const double* T, const double* r, const double* q, const double* S, const double* K, double* call, double* put, size_t n, CdfTier tier)
+	{
+		double sig[SurfaceBlock];
+		for (size_t start = 0; start < n; start += SurfaceBlock)
+		{
+			size_t m = min(SurfaceBlock, n - start);
+			surface.Vols(T + start, K + start, sig, m);
+			EuroBatchPrice(T + start, sig, r + start, q + start, S + start, K + start, call + start, put + start, m, tier);
+		}
+	}
+}
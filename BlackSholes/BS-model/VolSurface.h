@@ -0,0 +1,52 @@
+// Group A & B: Header file for an implied volatility surface by expiry and strike, feeding the batch pricers
+
+#ifndef VolSurfaceHPP
+#define VolSurfaceHPP
+
+#include "NormalCdf.h"
+#include <vector>
+#include <cstddef>
+using namespace std;
+
+namespace Options
+{
+	// Quotes of implied volatility on a grid of expiries, each with its own increasing strikes. The total variance
+	// w = vol^2 * T of each expiry is a natural cubic spline in the strike, flat beyond the outer strikes; between expiries w
+	// is linear in T at the same strike, before the first and after the last expiry the volatility stays flat. Build keeps
+	// the spline coefficients in flat arrays, one entry per strike, and costs O(quotes). The lookups only read them and
+	// never allocate
+	class VolSurface
+	{
+		private:
+			vector<double> expiry; // increasing
+			vector<size_t> first; // strikes of expiry e are first[e] to first[e + 1] - 1
+			vector<double> strike; // increasing within each expiry
+			vector<double> a, b, c, d; // w = a + b*x + c*x^2 + d*x^3 with x = K - strike[i] on [strike[i], strike[i + 1]]
+			vector<double> diag, upper, rhs; // scratch of the tridiagonal solve in Build
+
+			double Variance(size_t e, double K) const; // function to return the total variance of expiry e at strike K, by binary search
+			double Walk(size_t e, size_t& i, double K) const; // function to return the total variance of expiry e at strike K, moving the interval i forward from where the previous, lower strike left it
+			size_t Bracket(double T) const; // function to return the number of expiries at or before T
+
+		public:
+			VolSurface(); // default constructor
+			VolSurface(const VolSurface& source); // copy constructor
+			~VolSurface(); // destructor
+
+			// Quotes: expiry e has T[e] and the strikes K[strikeBegin[e]] to K[strikeBegin[e + 1] - 1] with the volatilities vol[].
+			// Returns false, leaving the surface empty, unless T and each expiry's strikes increase and every volatility is positive
+			bool Build(size_t expiries, const double* T, const size_t* strikeBegin, const double* K, const double* vol); // function to rebuild the surface from a snapshot
+
+			size_t Expiries() const; // function to return the number of expiries
+			size_t Quotes() const; // function to return the number of quotes
+			double Vol(double T, double K) const; // function to return the volatility at one expiry and strike
+			void Vols(double T, const double* K, double* vol, size_t n) const; // function to return the volatilities of one expiry at n increasing strikes, walking the coefficients in order
+			void Vols(const double* T, const double* K, double* vol, size_t n) const; // function to return the volatilities of n contracts; runs of equal T with increasing K take the walking path
+	};
+
+	// Function to price n European call and put options with their volatilities read off the surface, block by block
+	// into stack scratch so nothing is allocated
+	void SurfaceBatchPrice(const VolSurface& surface, const double* T, const double* r, const double* q, const double* S, const double* K, double* call, double* put, size_t n, CdfTier tier = CdfExact); // function to price n European call and put options at the surface's volatilities
+}
+
+#endif
@@ -1,4 +1,5 @@
 #include "FdmDirector.hpp"
+#include "../../BlackSholes/BS-model/NormalCdf.h"
 #include <iostream>
 #include <string>
 using namespace std;
@@ -85,5 +86,14 @@ int main()
 	fdir.doit();
 	cout << "Finished\n";
 
+	// Validate the put at the mesh point nearest the strike against the exact Black-Scholes put
+	const std::vector<double>& V = fdir.current();
+	unsigned int j = static_cast<unsigned int>(BS::K / Smax * J + 0.5);
+	double S = fdir.xarr[j];
+	double d1 = (log(S / BS::K) + (BS::r - BS::D + 0.5 * BS::sig * BS::sig) * BS::T) / (BS::sig * sqrt(BS::T));
+	double d2 = d1 - BS::sig * sqrt(BS::T);
+	double exact = BS::K * exp(-BS::r * BS::T) * Options::NormalCdfExact(-d2) - S * exp(-BS::D * BS::T) * Options::NormalCdfExact(-d1);
+	cout << "FDM put at S = " << S << ": " << V[j] << ", exact: " << exact << ", error: " << V[j] - exact << endl;
+
 	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,80 @@
+// BrownianBridge.cpp
+//
+// Construction order and weights as in Jaeckel, Monte Carlo Methods in
+// Finance (2002), for a mesh that need not be uniform.
+//
+
+#include "BrownianBridge.hpp"
+#include <cmath>
+
+BrownianBridge::BrownianBridge(const std::vector<double>& mesh)
+{
+	std::size_t n = (mesh.size() > 1) ? mesh.size() - 1 : 0;
+	bridgeIndex.resize(n); leftIndex.resize(n); rightIndex.resize(n);
+	leftWeight.resize(n); rightWeight.resize(n); stdDev.resize(n); sqrtStep.resize(n);
+	if (n == 0) return;
+
+	// t[j] is the time of W number j, relative to mesh[0]
+	std::vector<double> t(n);
+	for (std::size_t j = 0; j < n; ++j)
+	{
+		t[j] = mesh[j + 1] - mesh[0];
+		sqrtStep[j] = std::sqrt(mesh[j + 1] - mesh[j]);
+	}
+
+	std::vector<std::size_t> fixed(n, 0);
+	fixed[n - 1] = 1;
+	bridgeIndex[0] = n - 1;
+	stdDev[0] = std::sqrt(t[n - 1]);
+	leftWeight[0] = rightWeight[0] = 0.0;
+
+	for (std::size_t j = 0, i = 1; i < n; ++i)
+	{
+		// The first gap [j, k) of times not yet fixed, and its midpoint l
+		while (fixed[j]) ++j;
+		std::size_t k = j;
+		while (!fixed[k]) ++k;
+		std::size_t l = j + ((k - 1 - j) >> 1);
+		fixed[l] = i;
+		bridgeIndex[i] = l;
+		leftIndex[i] = j;
+		rightIndex[i] = k;
+
+		double tLeft = (j == 0) ? 0.0 : t[j - 1];
+		leftWeight[i] = (t[k] - t[l]) / (t[k] - tLeft);
+		rightWeight[i] = (t[l] - tLeft) / (t[k] - tLeft);
+		stdDev[i] = std::sqrt((t[l] - tLeft) * (t[k] - t[l]) / (t[k] - tLeft));
+
+		j = k + 1;
+		if (j >= n) j = 0;
+	}
+}
+
+
+std::size_t BrownianBridge::size() const
+{
+	return bridgeIndex.size();
+}
+
+
+void BrownianBridge::transform(const double* z, double* out) const
+{
+	std::size_t n = bridgeIndex.size();
+	if (n == 0) return;
+
+	// W at the times in out, in the order of the bridge
+	out[n - 1] = stdDev[0] * z[0];
+	for (std::size_t i = 1; i < n; ++i)
+	{
+		std::size_t j = leftIndex[i], k = rightIndex[i], l = bridgeIndex[i];
+		double left = (j == 0) ? 0.0 : out[j - 1];
+		out[l] = leftWeight[i] * left + rightWeight[i] * out[k] + stdDev[i] * z[i];
+	}
+
+	// Increments, scaled to standard normals
+	for (std::size_t j = n - 1; j > 0; --j)
+	{
+		out[j] = (out[j] - out[j - 1]) / sqrtStep[j];
+	}
+	out[0] /= sqrtStep[0];
+}
@@ -0,0 +1,38 @@
+// BrownianBridge.hpp
+//
+// Brownian bridge over a time mesh, such as Range<double>::mesh(N). The
+// first normal fixes W at the last time, the next ones the midpoints of
+// ever smaller intervals, so that the first coordinates of a quasi-random
+// point carry most of the variance of the path.
+//
+
+#ifndef BrownianBridge_HPP
+#define BrownianBridge_HPP
+
+#include <cstddef>
+#include <vector>
+
+class BrownianBridge
+{
+private:
+
+	std::vector<std::size_t> bridgeIndex;	// step i fixes W at time mesh[bridgeIndex[i] + 1]
+	std::vector<std::size_t> leftIndex;		// between W at mesh[leftIndex[i]] (W = 0 at mesh[0]) ...
+	std::vector<std::size_t> rightIndex;	// ... and W at mesh[rightIndex[i] + 1]
+	std::vector<double> leftWeight, rightWeight, stdDev;
+	std::vector<double> sqrtStep;			// sqrt(mesh[j + 1] - mesh[j])
+
+public:
+
+	BrownianBridge(const std::vector<double>& mesh);
+
+	// Number of steps, mesh.size() - 1
+	std::size_t size() const;
+
+	// From size() independent normals z, the normals of the path step by step:
+	// out[j] = (W(mesh[j + 1]) - W(mesh[j])) / sqrt(mesh[j + 1] - mesh[j])
+	void transform(const double* z, double* out) const;
+};
+
+
+#endif
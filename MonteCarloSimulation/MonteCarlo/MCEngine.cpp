@@ -0,0 +1,168 @@
+// MCEngine.cpp
+//
+// Batches of paths on a pool of threads, one normal stream per batch or,
+// in runPaths(), one counter-based stream per path, or, in runQMC(), the
+// points of a scrambled Sobol sequence.
+//
+
+#include "MCEngine.hpp"
+#include "BrownianBridge.hpp"
+#include "RNG/NormalGenerator.hpp"
+#include "ParallelFor.hpp"
+#include <cmath>
+#include <algorithm>
+
+const long MCBatch = 4096;	// paths per batch, fixed so that the streams do not depend on the threads
+
+struct MCSums
+{ // Sums kept by one batch
+
+	double sum;
+	double sumSquares;
+	long originHits;
+};
+
+
+MCEngine::MCEngine(const OptionData& option, double S_0, const std::vector<double>& timeMesh,
+	SDEFunction driftFunction, SDEFunction diffusionFunction, unsigned long long mySeed)
+	: data(option), S0(S_0), mesh(timeMesh), drift(driftFunction), diffusion(diffusionFunction), seed(mySeed)
+{
+}
+
+
+MCResult MCEngine::run(long NSim, unsigned nThreads) const
+{
+	return simulate(0, NSim, nThreads, JumpedStreams, 0, false);
+}
+
+
+MCResult MCEngine::runPaths(long firstPath, long NSim, unsigned nThreads) const
+{
+	return simulate(firstPath, NSim, nThreads, PathStreams, 0, false);
+}
+
+
+MCResult MCEngine::runQMC(long NSim, int replications, bool bridge, unsigned nThreads) const
+{
+	if (NSim < 1 || replications < 1 || mesh.empty())
+	{ // Nothing to simulate
+		MCResult empty = { 0.0, 0.0, 0.0, 0, 0 };
+		return empty;
+	}
+
+	MCResult result = { 0.0, 0.0, 0.0, NSim * replications, 0 };
+	std::vector<double> prices(replications);
+	for (int r = 0; r < replications; ++r)
+	{
+		MCResult one = simulate(0, NSim, nThreads, SobolPoints, seed + r, bridge);
+		prices[r] = one.price;
+		result.price += one.price / replications;
+		result.sd += one.sd / replications;
+		result.originHits += one.originHits;
+	}
+
+	double spread = 0.0;
+	for (int r = 0; r < replications; ++r)
+	{
+		spread += (prices[r] - result.price) * (prices[r] - result.price);
+	}
+	result.se = (replications > 1) ? std::sqrt(spread / (replications - 1) / replications) : 0.0;
+	return result;
+}
+
+
+MCResult MCEngine::simulate(long firstPath, long NSim, unsigned nThreads, Streams source, unsigned long long key, bool bridge) const
+{
+	if (NSim < 1 || mesh.empty())
+	{ // Nothing to simulate
+		MCResult empty = { 0.0, 0.0, 0.0, 0, 0 };
+		return empty;
+	}
+
+	long batches = (NSim + MCBatch - 1) / MCBatch;
+
+	// The streams, one jump apart, set up before the threads start
+	std::vector<XoshiroNormal> streams(source == JumpedStreams ? batches : 0);
+	XoshiroNormal stream(seed);
+	for (long b = 0; b < long(streams.size()); ++b)
+	{
+		streams[b] = stream;
+		stream.jump();
+	}
+
+	// Step sizes of the time grid
+	std::vector<double> k(mesh.size()), sqrk(mesh.size());
+	for (std::size_t index = 1; index < mesh.size(); ++index)
+	{
+		k[index] = mesh[index] - mesh[index - 1];
+		sqrk[index] = std::sqrt(k[index]);
+	}
+
+	std::size_t steps = mesh.size() - 1;
+	BrownianBridge brownianBridge(mesh);
+
+	std::vector<MCSums> sums(batches);
+	parallelFor(batches, 1, [&](size_t begin, size_t end)
+	{
+		OptionData option = data;	// myPayOffFunction is not const
+		std::vector<double> dW(mesh.size());	// normals of one path, dW[index] for the step ending at mesh[index]
+		std::vector<double> z(mesh.size());		// coordinates of a Sobol point, before the bridge
+		PhiloxNormal pathNormal(seed);
+		SobolNormal sobol(source == SobolPoints ? steps : 0, true, key);
+		for (size_t b = begin; b < end; ++b)
+		{
+			const NormalGenerator& normal = (source == JumpedStreams) ? (const NormalGenerator&)streams[b]
+				: (source == PathStreams) ? (const NormalGenerator&)pathNormal : (const NormalGenerator&)sobol;
+			long first = long(b) * MCBatch, last = std::min(first + MCBatch, NSim);
+			MCSums s = { 0.0, 0.0, 0 };
+			if (source == SobolPoints) sobol.setPoint(first);
+
+			for (long i = first; i < last; ++i)
+			{ // Calculate a path at each iteration
+
+				double VOld = S0, VNew = S0;
+				if (source == PathStreams) pathNormal.setPath(firstPath + i);
+				if (steps > 0 && bridge)
+				{
+					normal.getNormals(&z[0], steps);
+					brownianBridge.transform(&z[0], &dW[1]);
+				}
+				else if (steps > 0)
+				{
+					normal.getNormals(&dW[1], steps);
+				}
+				for (std::size_t index = 1; index < mesh.size(); ++index)
+				{
+					// The FDM (in this case explicit Euler)
+					VNew = VOld + (k[index] * drift(mesh[index - 1], VOld))
+						+ (sqrk[index] * diffusion(mesh[index - 1], VOld) * dW[index]);
+					VOld = VNew;
+
+					// Spurious values
+					if (VNew <= 0.0) s.originHits++;
+				}
+
+				double payoff = option.myPayOffFunction(VNew);
+				s.sum += payoff;
+				s.sumSquares += payoff * payoff;
+			}
+			sums[b] = s;
+		}
+	}, nThreads);
+
+	// Merge in batch order
+	double sum = 0.0, sumSquares = 0.0;
+	MCResult result = { 0.0, 0.0, 0.0, NSim, 0 };
+	for (long b = 0; b < batches; ++b)
+	{
+		sum += sums[b].sum;
+		sumSquares += sums[b].sumSquares;
+		result.originHits += sums[b].originHits;
+	}
+
+	double discount = std::exp(-data.r * data.T);
+	result.price = discount * sum / NSim;
+	result.sd = (NSim > 1) ? std::sqrt(std::max(sumSquares - sum * sum / NSim, 0.0) / (NSim - 1)) * discount : 0.0;
+	result.se = result.sd / std::sqrt(double(NSim));
+	return result;
+}
@@ -0,0 +1,69 @@
+// MCEngine.hpp
+//
+// One factor Monte Carlo engine with explicit Euler paths. The paths are
+// cut into batches of a fixed size; batch b draws its normals from its own
+// stream, b jumps of the seeded generator, and keeps its own sums. The
+// batches run on a pool of threads and their sums are merged in batch
+// order, so a run with a given seed gives the same bits on any number of
+// threads. The same holds for runPaths() and runQMC().
+//
+
+#ifndef MCEngine_HPP
+#define MCEngine_HPP
+
+#include "OptionData.hpp"
+#include <vector>
+
+// Drift or diffusion of the SDE as a function of (t, X)
+typedef double (*SDEFunction)(double t, double X);
+
+struct MCResult
+{ // Outcome of a run
+
+	double price;		// discounted mean payoff
+	double sd;			// discounted standard deviation of the payoff
+	double se;			// standard error of the price
+	long paths;
+	long originHits;	// time steps at which S <= 0
+};
+
+class MCEngine
+{
+private:
+
+	OptionData data;
+	double S0;
+	std::vector<double> mesh;	// time grid of the paths
+	SDEFunction drift;
+	SDEFunction diffusion;
+	unsigned long long seed;
+
+	enum Streams { JumpedStreams, PathStreams, SobolPoints };	// where the normals of the paths come from
+
+	MCResult simulate(long firstPath, long NSim, unsigned nThreads, Streams source, unsigned long long key, bool bridge) const;
+
+public:
+
+	MCEngine(const OptionData& option, double S_0, const std::vector<double>& timeMesh,
+		SDEFunction driftFunction, SDEFunction diffusionFunction, unsigned long long mySeed = 0);
+
+	// Price with NSim paths; nThreads == 0 means all hardware threads. NSim < 1 or
+	// an empty time mesh give a result of zeros with no paths, a single path sd = 0
+	MCResult run(long NSim, unsigned nThreads = 0) const;
+
+	// Price with the paths firstPath to firstPath + NSim - 1, path i drawing from
+	// PhiloxNormal(seed, i) alone. Any range of paths gives the same paths as in a
+	// larger run, so a run can be split into shards, resumed, or single paths audited
+	MCResult runPaths(long firstPath, long NSim, unsigned nThreads = 0) const;
+
+	// Randomised quasi Monte Carlo: replications runs over the first NSim points of
+	// the Sobol sequence, each with its own Owen scramble. The price is the mean of
+	// the replications and se their standard error, sd the mean of their payoff
+	// standard deviations. With bridge, the coordinates of a point build the path
+	// through a Brownian bridge, else they are its steps in order. Fewer than one
+	// point or replication gives a result of zeros with no paths
+	MCResult runQMC(long NSim, int replications, bool bridge = true, unsigned nThreads = 0) const;
+};
+
+
+#endif
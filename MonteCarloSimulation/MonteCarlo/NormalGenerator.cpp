@@ -1,7 +1,17 @@
 #include "RNG/NormalGenerator.hpp"
+#include "BatchMath.hpp"
+#include <boost/random/sobol.hpp>
 #include <cmath>
 
 
+void NormalGenerator::getNormals(double* out, std::size_t n) const
+{
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		out[i] = getNormal();
+	}
+}
+
 
 BoostNormal::BoostNormal() : NormalGenerator()
 {
@@ -20,8 +30,616 @@ double BoostNormal::getNormal() const
 }
 
 
+void BoostNormal::getNormals(double* out, std::size_t n) const
+{ // Direct calls of the variate generator, no virtual call per draw
+
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		out[i] = (*myRandom)();
+	}
+}
+
+
 BoostNormal::~BoostNormal()
 {
 
 	delete myRandom;
+}
+
+
+// Splitmix64, used to spread a seed over the xoshiro state
+static unsigned long long splitMix(unsigned long long& x)
+{
+	unsigned long long z = (x += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+static unsigned long long rotl(unsigned long long x, int k)
+{
+	return (x << k) | (x >> (64 - k));
+}
+
+// xoshiro256** (Blackman and Vigna): next output of the state s[0..3]
+static unsigned long long xoshiroNext(unsigned long long* s)
+{
+	unsigned long long result = rotl(s[1] * 5, 7) * 9;
+	unsigned long long t = s[1] << 17;
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = rotl(s[3], 45);
+	return result;
+}
+
+// Advance the state s[0..3] by 2^128 outputs
+static void xoshiroJump(unsigned long long* s)
+{
+	static const unsigned long long JUMP[] = { 0x180EC6D33CFD0ABAULL, 0xD5A61266F0C9392CULL, 0xA9582618E03FC9AAULL, 0x39ABDC4529B1661CULL };
+
+	unsigned long long t[4] = { 0, 0, 0, 0 };
+	for (int i = 0; i < 4; ++i)
+	{
+		for (int b = 0; b < 64; ++b)
+		{
+			if (JUMP[i] & (1ULL << b))
+			{
+				for (int j = 0; j < 4; ++j)
+				{
+					t[j] ^= s[j];
+				}
+			}
+			xoshiroNext(s);
+		}
+	}
+	for (int j = 0; j < 4; ++j)
+	{
+		s[j] = t[j];
+	}
+}
+
+
+XoshiroNormal::XoshiroNormal(unsigned long long seed) : NormalGenerator()
+{
+	for (int i = 0; i < 4; ++i)
+	{
+		s[i] = splitMix(seed);
+	}
+	spare = 0.0;
+	hasSpare = false;
+}
+
+
+XoshiroNormal::XoshiroNormal(const XoshiroNormal& source) : NormalGenerator()
+{
+	*this = source;
+}
+
+
+XoshiroNormal& XoshiroNormal::operator = (const XoshiroNormal& source)
+{
+	for (int i = 0; i < 4; ++i)
+	{
+		s[i] = source.s[i];
+	}
+	spare = source.spare;
+	hasSpare = source.hasSpare;
+	return *this;
+}
+
+
+unsigned long long XoshiroNormal::nextUniform() const
+{
+	return xoshiroNext(s);
+}
+
+
+void XoshiroNormal::polarPair(double& first, double& second) const
+{ // Polar method: a point uniform in the unit disc gives two independent normals
+
+	double u, v, w;
+	do
+	{
+		u = (nextUniform() >> 11) * (2.0 / 9007199254740992.0) - 1.0;
+		v = (nextUniform() >> 11) * (2.0 / 9007199254740992.0) - 1.0;
+		w = u * u + v * v;
+	} while (w >= 1.0 || w == 0.0);
+
+	double factor = std::sqrt(-2.0 * std::log(w) / w);
+	first = u * factor;
+	second = v * factor;
+}
+
+
+// Implement (variant) hook function
+double XoshiroNormal::getNormal() const
+{
+	if (hasSpare)
+	{
+		hasSpare = false;
+		return spare;
+	}
+
+	double first;
+	polarPair(first, spare);
+	hasSpare = true;
+	return first;
+}
+
+
+void XoshiroNormal::getNormals(double* out, std::size_t n) const
+{ // Whole pairs straight into the buffer; a spare from either end carries over
+
+	std::size_t i = 0;
+	if (hasSpare && n > 0)
+	{
+		out[i++] = spare;
+		hasSpare = false;
+	}
+	for (; i + 1 < n; i += 2)
+	{
+		polarPair(out[i], out[i + 1]);
+	}
+	if (i < n)
+	{
+		polarPair(out[i], spare);
+		hasSpare = true;
+	}
+}
+
+
+void XoshiroNormal::jump()
+{
+	xoshiroJump(s);
+	hasSpare = false;
+}
+
+
+XoshiroBlock::XoshiroBlock(unsigned long long seed)
+{
+	unsigned long long s[4];
+	for (int i = 0; i < 4; ++i)
+	{
+		s[i] = splitMix(seed);
+	}
+	for (std::size_t l = 0; l < Lanes; ++l)
+	{
+		s0[l] = s[0]; s1[l] = s[1]; s2[l] = s[2]; s3[l] = s[3];
+		xoshiroJump(s);
+	}
+}
+
+
+void XoshiroBlock::fill(unsigned long long* out, std::size_t n)
+{
+	for (std::size_t j = 0; j < n; j += Lanes)
+	{
+		BATCH_LOOP
+		for (std::size_t l = 0; l < Lanes; ++l)
+		{ // xoshiroNext() on lane l
+
+			unsigned long long a = s0[l], b = s1[l], c = s2[l], d = s3[l];
+			out[j + l] = rotl(b * 5, 7) * 9;
+			unsigned long long t = b << 17;
+			c ^= a;
+			d ^= b;
+			b ^= c;
+			a ^= d;
+			c ^= t;
+			d = rotl(d, 45);
+			s0[l] = a; s1[l] = b; s2[l] = c; s3[l] = d;
+		}
+	}
+}
+
+
+void XoshiroBlock::jump()
+{
+	for (std::size_t l = 0; l < Lanes; ++l)
+	{
+		unsigned long long s[4] = { s0[l], s1[l], s2[l], s3[l] };
+		for (std::size_t k = 0; k < Lanes; ++k)
+		{
+			xoshiroJump(s);
+		}
+		s0[l] = s[0]; s1[l] = s[1]; s2[l] = s[2]; s3[l] = s[3];
+	}
+}
+
+
+BlockNormal::BlockNormal() : NormalGenerator()
+{
+	used = Block;
+}
+
+
+double BlockNormal::getNormal() const
+{
+	if (used == Block)
+	{
+		generate(buffer);
+		used = 0;
+	}
+	return buffer[used++];
+}
+
+
+void BlockNormal::getNormals(double* out, std::size_t n) const
+{ // What is left in the buffer, then whole blocks in place, then a fresh buffer for the rest
+
+	std::size_t i = 0;
+	for (; i < n && used < Block; ++i)
+	{
+		out[i] = buffer[used++];
+	}
+	for (; i + Block <= n; i += Block)
+	{
+		generate(out + i);
+	}
+	if (i < n)
+	{
+		generate(buffer);
+		used = 0;
+		for (; i < n; ++i)
+		{
+			out[i] = buffer[used++];
+		}
+	}
+}
+
+
+ZigguratNormal::ZigguratNormal(unsigned long long seed) : BlockNormal(), uniforms(seed)
+{
+	// The fallback stream follows the lanes of the uniforms: Lanes jumps from the seed
+	for (int i = 0; i < 4; ++i)
+	{
+		fallback[i] = splitMix(seed);
+	}
+	for (std::size_t l = 0; l < XoshiroBlock::Lanes; ++l)
+	{
+		xoshiroJump(fallback);
+	}
+
+	// Layers of equal area V below exp(-x^2/2); layer 0 is the base strip with the tail beyond R
+	const double R = 3.6541528853610088, V = 0.00492867323399;
+	double f = std::exp(-0.5 * R * R);
+	x[0] = V / f;
+	x[1] = R;
+	x[256] = 0.0;
+	for (int i = 2; i < 256; ++i)
+	{
+		x[i] = std::sqrt(-2.0 * std::log(V / x[i - 1] + f));
+		f = std::exp(-0.5 * x[i] * x[i]);
+	}
+	for (int i = 0; i < 256; ++i)
+	{
+		ratio[i] = x[i + 1] / x[i];
+	}
+}
+
+
+double ZigguratNormal::slow(unsigned long long r) const
+{ // Wedge and tail tests for a draw outside its rectangle, fresh draws from the fallback stream until one is accepted
+
+	const double scale = 1.0 / 9007199254740992.0;
+	for (;;)
+	{
+		std::size_t i = r & 0xFF;
+		double u = (r >> 11) * (2.0 * scale) - 1.0;
+		if (std::fabs(u) < ratio[i])
+		{
+			return u * x[i];
+		}
+
+		if (i == 0)
+		{ // Tail beyond R (Marsaglia)
+
+			double a, b;
+			do
+			{
+				a = std::log(((xoshiroNext(fallback) >> 11) + 0.5) * scale) / x[1];
+				b = std::log(((xoshiroNext(fallback) >> 11) + 0.5) * scale);
+			} while (-2.0 * b < a * a);
+			return (u < 0.0) ? a - x[1] : x[1] - a;
+		}
+
+		// Wedge: accept v if a uniform point between the layer's edges falls below the density
+		double v = u * x[i];
+		double f0 = std::exp(-0.5 * (x[i] * x[i] - v * v));
+		double f1 = std::exp(-0.5 * (x[i + 1] * x[i + 1] - v * v));
+		if (f1 + (xoshiroNext(fallback) >> 11) * scale * (f0 - f1) < 1.0)
+		{
+			return v;
+		}
+		r = xoshiroNext(fallback);
+	}
+}
+
+
+void ZigguratNormal::generate(double* out) const
+{
+	unsigned long long r[Block];
+	unsigned char inside[Block];
+	uniforms.fill(r, Block);
+
+	// Low 8 bits pick the layer, the top 53 give a uniform in [-1, 1)
+	BATCH_LOOP
+	for (std::size_t j = 0; j < Block; ++j)
+	{
+		std::size_t i = r[j] & 0xFF;
+		double u = (r[j] >> 11) * (2.0 / 9007199254740992.0) - 1.0;
+		out[j] = u * x[i];
+		inside[j] = std::fabs(u) < ratio[i];
+	}
+
+	for (std::size_t j = 0; j < Block; ++j)
+	{
+		if (!inside[j])
+		{
+			out[j] = slow(r[j]);
+		}
+	}
+}
+
+
+BoxMullerNormal::BoxMullerNormal(unsigned long long seed) : BlockNormal(), uniforms(seed)
+{
+}
+
+
+void BoxMullerNormal::generate(double* out) const
+{
+	const std::size_t half = Block / 2;
+	unsigned long long r[Block];
+	uniforms.fill(r, Block);
+
+	// Uniform k gives the radius and uniform k + half the angle, in turns, of normals k and k + half. The
+	// branch-free log and sine/cosine keep the loop vectorised, where the library calls would not
+	BATCH_LOOP
+	for (std::size_t k = 0; k < half; ++k)
+	{
+		double u = ((r[k] >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+		double turns = (r[k + half] >> 11) * (1.0 / 9007199254740992.0);
+		double radius = std::sqrt(-2.0 * batchLog(u));
+		double s, c;
+		batchSinCosTurns(turns, s, c);
+		out[k] = radius * c;
+		out[k + half] = radius * s;
+	}
+}
+
+
+// One Philox round with the multipliers of Philox4x32
+static inline void philoxRound(unsigned int& c0, unsigned int& c1, unsigned int& c2, unsigned int& c3, unsigned int k0, unsigned int k1)
+{
+	unsigned long long p0 = 0xD2511F53ULL * c0, p1 = 0xCD9E8D57ULL * c2;
+	unsigned int n0 = (unsigned int)(p1 >> 32) ^ c1 ^ k0;
+	unsigned int n2 = (unsigned int)(p0 >> 32) ^ c3 ^ k1;
+	c1 = (unsigned int)p1;
+	c3 = (unsigned int)p0;
+	c0 = n0;
+	c2 = n2;
+}
+
+
+// Box-Muller on the Philox block of counter (m, path): words 0-1 give the radius, 2-3 the angle
+static inline void philoxPair(unsigned long long m, unsigned long long path, const unsigned int* key, double& first, double& second)
+{
+	const double scale = 1.0 / 9007199254740992.0;
+	unsigned int c0 = (unsigned int)m, c1 = (unsigned int)(m >> 32), c2 = (unsigned int)path, c3 = (unsigned int)(path >> 32);
+	unsigned int k0 = key[0], k1 = key[1];
+	for (int round = 0; round < 10; ++round)
+	{
+		philoxRound(c0, c1, c2, c3, k0, k1);
+		k0 += 0x9E3779B9;
+		k1 += 0xBB67AE85;
+	}
+
+	double u = ((((unsigned long long)c0 << 32 | c1) >> 11) + 0.5) * scale;
+	double angle = 6.283185307179586 * ((((unsigned long long)c2 << 32 | c3) >> 11) * scale);
+	double radius = std::sqrt(-2.0 * std::log(u));
+	first = radius * std::cos(angle);
+	second = radius * std::sin(angle);
+}
+
+
+PhiloxNormal::PhiloxNormal(unsigned long long seed, unsigned long long pathIndex) : NormalGenerator()
+{
+	key[0] = (unsigned int)seed;
+	key[1] = (unsigned int)(seed >> 32);
+	setPath(pathIndex);
+}
+
+
+void PhiloxNormal::setPath(unsigned long long pathIndex, unsigned long long drawIndex)
+{
+	path = pathIndex;
+	draw = drawIndex;
+	hasPair = false;
+}
+
+
+void PhiloxNormal::philox(const unsigned int ctr[4], const unsigned int k[2], unsigned int out[4])
+{
+	unsigned int c0 = ctr[0], c1 = ctr[1], c2 = ctr[2], c3 = ctr[3], k0 = k[0], k1 = k[1];
+	for (int round = 0; round < 10; ++round)
+	{
+		philoxRound(c0, c1, c2, c3, k0, k1);
+		k0 += 0x9E3779B9;
+		k1 += 0xBB67AE85;
+	}
+	out[0] = c0; out[1] = c1; out[2] = c2; out[3] = c3;
+}
+
+
+// Implement (variant) hook function
+double PhiloxNormal::getNormal() const
+{
+	if (!hasPair || (draw & 1) == 0)
+	{
+		philoxPair(draw / 2, path, key, pair[0], pair[1]);
+	}
+	hasPair = (draw & 1) == 0;
+	return pair[draw++ & 1];
+}
+
+
+void PhiloxNormal::getNormals(double* out, std::size_t n) const
+{ // Only the pairs that cover draws draw to draw + n - 1 are computed
+
+	std::size_t i = 0;
+	if ((draw & 1) && n > 0)
+	{
+		if (!hasPair)
+		{
+			philoxPair(draw / 2, path, key, pair[0], pair[1]);
+		}
+		out[i++] = pair[1];
+		++draw;
+	}
+
+	std::size_t pairs = (n - i) / 2;
+	unsigned long long m = draw / 2;
+	BATCH_LOOP
+	for (std::size_t k = 0; k < pairs; ++k)
+	{
+		philoxPair(m + k, path, key, out[i + 2 * k], out[i + 2 * k + 1]);
+	}
+	i += 2 * pairs;
+	draw += 2 * pairs;
+
+	hasPair = false;
+	if (i < n)
+	{
+		philoxPair(draw / 2, path, key, pair[0], pair[1]);
+		out[i] = pair[0];
+		++draw;
+		hasPair = true;
+	}
+}
+
+
+static unsigned int reverseBits(unsigned int x)
+{
+	x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+	x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+	x = ((x >> 4) & 0x0F0F0F0Fu) | ((x & 0x0F0F0F0Fu) << 4);
+	x = ((x >> 8) & 0x00FF00FFu) | ((x & 0x00FF00FFu) << 8);
+	return (x >> 16) | (x << 16);
+}
+
+// Owen's nested uniform scramble of a 32 bit fraction: the Laine-Karras hash, which only lets
+// each bit depend on the bits below it, applied to the reversed bits (Burley 2020)
+static unsigned int owenScramble(unsigned int x, unsigned int key)
+{
+	x = reverseBits(x);
+	x += key;
+	x ^= x * 0x6C50B47Cu;
+	x ^= x * 0xB82F1E52u;
+	x ^= x * 0xC7AFE638u;
+	x ^= x * 0x8D22F6E6u;
+	return reverseBits(x);
+}
+
+
+SobolNormal::SobolNormal(std::size_t dim, bool scrambled, unsigned long long seed)
+	: NormalGenerator(), dimension(dim), direction(32 * dim), point(dim, 0), index(0), next(0)
+{
+	typedef boost::random::default_sobol_table Table;
+
+	for (std::size_t d = 0; d < dimension; ++d)
+	{
+		// Coordinate 0 is van der Corput's sequence, m_j = 1. The others take their initial m_j from the table and
+		// the rest by the recurrence of their primitive polynomial (Bratley and Fox)
+		unsigned int m[32];
+		if (d == 0)
+		{
+			for (unsigned int j = 0; j < 32; ++j)
+			{
+				m[j] = 1;
+			}
+		}
+		else
+		{
+			unsigned int poly = Table::polynomial(d - 1), degree = 0;
+			while ((poly >> (degree + 1)) != 0) ++degree;
+			for (unsigned int j = 0; j < degree; ++j)
+			{
+				m[j] = Table::minit(d - 1, j);
+			}
+			for (unsigned int j = degree; j < 32; ++j)
+			{
+				m[j] = m[j - degree];
+				unsigned int p = poly;
+				for (unsigned int k = 0; k < degree; ++k, p >>= 1)
+				{
+					m[j] ^= ((p & 1) * m[j - degree + k]) << (degree - k);
+				}
+			}
+		}
+		for (unsigned int j = 0; j < 32; ++j)
+		{
+			direction[j * dimension + d] = m[j] << (31 - j);
+		}
+	}
+
+	if (scrambled)
+	{
+		scramble.resize(dimension);
+		for (std::size_t d = 0; d < dimension; ++d)
+		{
+			scramble[d] = (unsigned int)splitMix(seed);
+		}
+	}
+}
+
+
+void SobolNormal::setPoint(unsigned long long pointIndex)
+{
+	index = pointIndex;
+	next = 0;
+	unsigned long long gray = pointIndex ^ (pointIndex >> 1);
+	for (std::size_t d = 0; d < dimension; ++d)
+	{
+		point[d] = 0;
+	}
+	for (unsigned int j = 0; j < 32 && (gray >> j) != 0; ++j)
+	{
+		if ((gray >> j) & 1)
+		{
+			for (std::size_t d = 0; d < dimension; ++d)
+			{
+				point[d] ^= direction[j * dimension + d];
+			}
+		}
+	}
+}
+
+
+unsigned int SobolNormal::coordinate(std::size_t d) const
+{
+	return scramble.empty() ? point[d] : owenScramble(point[d], scramble[d]);
+}
+
+
+// Implement (variant) hook function
+double SobolNormal::getNormal() const
+{
+	if (next == dimension)
+	{ // Next point: flip the direction number of the lowest zero bit of the index (Antonov and Saleev)
+
+		unsigned int c = 0;
+		while ((index >> c) & 1) ++c;
+		for (std::size_t d = 0; d < dimension; ++d)
+		{
+			point[d] ^= direction[c * dimension + d];
+		}
+		++index;
+		next = 0;
+	}
+
+	return normalQuantile((coordinate(next++) + 0.5) * (1.0 / 4294967296.0));
 }
\ No newline at end of file
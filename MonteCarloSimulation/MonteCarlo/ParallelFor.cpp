@@ -0,0 +1,136 @@
+// ParallelFor.cpp
+//
+// Shares of the index range guarded by their own lock, so that the owner
+// and the thieves can meet.
+//
+
+#include "ParallelFor.hpp"
+#include <algorithm>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct WorkShare
+{ // Part of the index range still to be done by one worker
+
+	std::mutex lock;
+	std::size_t begin;
+	std::size_t end;
+};
+
+unsigned hardwareThreads()
+{
+	unsigned n = std::thread::hardware_concurrency();
+	return (n == 0) ? 1 : n;
+}
+
+void parallelFor(std::size_t n, std::size_t grain, const std::function<void(std::size_t, std::size_t)>& body, unsigned nThreads)
+{
+	if (n == 0) return;
+
+	grain = std::max(grain, std::size_t(1));
+	nThreads = (nThreads == 0) ? hardwareThreads() : nThreads;
+	nThreads = unsigned(std::min(std::size_t(nThreads), (n + grain - 1) / grain));
+
+	if (nThreads <= 1)
+	{
+		for (std::size_t b = 0; b < n; b += grain)
+		{
+			body(b, std::min(b + grain, n));
+		}
+		return;
+	}
+
+	std::unique_ptr<WorkShare[]> shares(new WorkShare[nThreads]);
+	for (unsigned w = 0; w < nThreads; ++w)
+	{
+		shares[w].begin = n * w / nThreads;
+		shares[w].end = n * (w + 1) / nThreads;
+	}
+
+	std::mutex errorLock;
+	std::exception_ptr error;
+
+	auto worker = [&](unsigned w)
+	{
+		try
+		{
+			while (true)
+			{
+				// Take the next chunk from the front of the own share
+				std::size_t b = 0, e = 0;
+				{
+					std::lock_guard<std::mutex> guard(shares[w].lock);
+					if (shares[w].begin < shares[w].end)
+					{
+						b = shares[w].begin;
+						e = std::min(b + grain, shares[w].end);
+						shares[w].begin = e;
+					}
+				}
+				if (b < e)
+				{
+					body(b, e);
+					continue;
+				}
+
+				// Own share is empty: steal the back half of the largest share left
+				unsigned victim = w;
+				std::size_t most = 0;
+				for (unsigned v = 0; v < nThreads; ++v)
+				{
+					std::lock_guard<std::mutex> guard(shares[v].lock);
+					if (v != w && shares[v].end - shares[v].begin > most)
+					{
+						most = shares[v].end - shares[v].begin;
+						victim = v;
+					}
+				}
+				if (victim == w) return;	// nothing left anywhere
+
+				{
+					std::lock_guard<std::mutex> guard(shares[victim].lock);
+					std::size_t left = shares[victim].end - shares[victim].begin;
+					if (left == 0) continue;	// the owner finished it meanwhile, look again
+
+					std::size_t mid = shares[victim].begin + left / 2;
+					b = mid;
+					e = shares[victim].end;
+					shares[victim].end = mid;
+				}
+				{
+					std::lock_guard<std::mutex> guard(shares[w].lock);
+					shares[w].begin = b;
+					shares[w].end = e;
+				}
+			}
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> guard(errorLock);
+			if (!error) error = std::current_exception();
+
+			// Drain every share so that the other workers stop soon
+			for (unsigned v = 0; v < nThreads; ++v)
+			{
+				std::lock_guard<std::mutex> guard2(shares[v].lock);
+				shares[v].begin = shares[v].end;
+			}
+		}
+	};
+
+	std::vector<std::thread> pool;
+	for (unsigned w = 1; w < nThreads; ++w)
+	{
+		pool.push_back(std::thread(worker, w));
+	}
+	worker(0);
+	for (auto& t : pool)
+	{
+		t.join();
+	}
+
+	if (error) std::rethrow_exception(error);
+}
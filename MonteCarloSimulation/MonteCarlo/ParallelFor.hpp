@@ -0,0 +1,23 @@
+// ParallelFor.hpp
+//
+// Work-stealing parallel loop that runs the batches of MCEngine. Each
+// thread starts on an equal share of the index range and, once it runs
+// dry, steals the back half of the largest share left. The calling thread
+// takes part. An exception thrown by the body is rethrown on the calling
+// thread after all workers have stopped.
+//
+
+#ifndef ParallelFor_HPP
+#define ParallelFor_HPP
+
+#include <cstddef>
+#include <functional>
+
+// Number of hardware threads, at least 1
+unsigned hardwareThreads();
+
+// Calls body(begin, end) on disjoint chunks of at most grain indices until
+// [0, n) is covered, on nThreads threads (0 == hardwareThreads())
+void parallelFor(std::size_t n, std::size_t grain, const std::function<void(std::size_t, std::size_t)>& body, unsigned nThreads = 0);
+
+#endif
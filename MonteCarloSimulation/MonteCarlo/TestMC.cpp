@@ -1,8 +1,16 @@
 #include "OptionData.hpp" 
 #include "RNG/NormalGenerator.hpp"
 #include "Geometry/Range.cpp"
+#include "MCEngine.hpp"
+#include "BrownianBridge.hpp"
+#include "BatchMath.hpp"
+#include "ParallelFor.hpp"
+#include <boost/random/sobol.hpp>
+#include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <iostream>
+#include <string>
 #include <vector>
 
 template <class T> void print(const std::vector<T>& myList)
@@ -74,6 +82,200 @@ double computeStandardError(const std::vector<double>& prices, double r, double
 	return sd / sqrt(prices.size());
 }
 
+// Draws per second of a generator through getNormal(), one virtual call per draw, and of a
+// second generator in the same state through getNormals() blocks; both must give the same draws
+void benchmarkNormals(const std::string& name, const NormalGenerator& one, const NormalGenerator& block)
+{
+	const std::size_t blockSize = 1024;
+	const long draws = 10000 * blockSize;
+
+	auto start = std::chrono::high_resolution_clock::now();
+	double sumOne = 0.0;
+	for (long i = 0; i < draws; ++i)
+	{
+		sumOne += one.getNormal();
+	}
+	double oneTime = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+	std::vector<double> buffer(blockSize);
+	start = std::chrono::high_resolution_clock::now();
+	double sumBlock = 0.0;
+	for (long i = 0; i < draws; i += blockSize)
+	{
+		block.getNormals(&buffer[0], blockSize);
+		for (std::size_t j = 0; j < blockSize; ++j)
+		{
+			sumBlock += buffer[j];
+		}
+	}
+	double blockTime = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+	// Both generators are now in the same state; blocks of any size must give the draws one at a time
+	bool same = true;
+	std::vector<double> check(2049);
+	for (std::size_t size : { 1, 333, 1000, 2049 })
+	{
+		block.getNormals(&check[0], size);
+		for (std::size_t j = 0; j < size; ++j)
+		{
+			same = same && one.getNormal() == check[j];
+		}
+	}
+	volatile double sink = sumOne + sumBlock;	// keep the timed loops
+	(void)sink;
+
+	std::cout << name << ": " << draws / oneTime / 1e6 << " M draws/s one at a time, "
+		<< draws / blockTime / 1e6 << " M draws/s in blocks of " << blockSize;
+	std::cout << ", same sequence" << (same ? " (ok)" : " (FAILED)") << std::endl;
+}
+
+// Moments of 10^7 draws against those of N(0, 1), each within 5 standard errors, and a
+// Kolmogorov-Smirnov test of the first 10^6 draws at the 0.1% level
+void testNormalQuality(const std::string& name, const NormalGenerator& normal)
+{
+	const long n = 10000000, nKS = 1000000;
+	std::vector<double> z(n);
+	normal.getNormals(&z[0], n);
+
+	double m1 = 0.0, m2 = 0.0, m3 = 0.0, m4 = 0.0;
+	for (long i = 0; i < n; ++i)
+	{
+		double z2 = z[i] * z[i];
+		m1 += z[i]; m2 += z2; m3 += z2 * z[i]; m4 += z2 * z2;
+	}
+	m1 /= n; m2 /= n; m3 /= n; m4 /= n;
+	double var = m2 - m1 * m1;
+	double skew = (m3 - 3 * m1 * m2 + 2 * m1 * m1 * m1) / pow(var, 1.5);
+	double kurt = (m4 - 4 * m1 * m3 + 6 * m1 * m1 * m2 - 3 * m1 * m1 * m1 * m1) / (var * var) - 3.0;
+	bool moments = fabs(m1) < 5 * sqrt(1.0 / n) && fabs(var - 1) < 5 * sqrt(2.0 / n)
+		&& fabs(skew) < 5 * sqrt(6.0 / n) && fabs(kurt) < 5 * sqrt(24.0 / n);
+
+	std::sort(z.begin(), z.begin() + nKS);
+	double D = 0.0;
+	for (long i = 0; i < nKS; ++i)
+	{
+		double F = normalCdf(z[i]);
+		D = std::max(D, std::max(double(i + 1) / nKS - F, F - double(i) / nKS));
+	}
+	double ks = D * sqrt(double(nKS));
+
+	std::cout << name << ": mean " << m1 << ", variance " << var << ", skewness " << skew << ", excess kurtosis " << kurt
+		<< (moments ? " (ok)" : " (FAILED)") << std::endl;
+	std::cout << name << ": Kolmogorov-Smirnov sqrt(n) D = " << ks << (ks < 1.95 ? " (ok)" : " (FAILED)") << std::endl;
+}
+
+// Philox4x32-10 against the known answers of Random123, and PhiloxNormal paths drawn
+// directly against the same paths reached after drawing others
+void testPhilox()
+{
+	const unsigned int ctr[3][4] = { { 0, 0, 0, 0 }, { 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF },
+		{ 0x243F6A88, 0x85A308D3, 0x13198A2E, 0x03707344 } };
+	const unsigned int key[3][2] = { { 0, 0 }, { 0xFFFFFFFF, 0xFFFFFFFF }, { 0xA4093822, 0x299F31D0 } };
+	const unsigned int expected[3][4] = { { 0x6627E8D5, 0xE169C58D, 0xBC57AC4C, 0x9B00DBD8 },
+		{ 0x408F276D, 0x41C83B0E, 0xA20BC7C6, 0x6D5451FD }, { 0xD16CFE09, 0x94FDCCEB, 0x5001E420, 0x24126EA1 } };
+	bool known = true;
+	for (int t = 0; t < 3; ++t)
+	{
+		unsigned int out[4];
+		PhiloxNormal::philox(ctr[t], key[t], out);
+		for (int j = 0; j < 4; ++j)
+		{
+			known = known && out[j] == expected[t][j];
+		}
+	}
+	std::cout << "Philox4x32-10 known answers" << (known ? " (ok)" : " (FAILED)") << std::endl;
+
+	// Path 7 of seed 42: drawn directly, and after part of path 3 and one normal of path 7 from elsewhere
+	const std::size_t n = 1000;
+	std::vector<double> direct(n), later(n);
+	PhiloxNormal(42, 7).getNormals(&direct[0], n);
+	PhiloxNormal walker(42, 3);
+	walker.getNormals(&later[0], 300);
+	walker.setPath(7);
+	later[0] = walker.getNormal();
+	walker.getNormals(&later[1], n - 1);
+	walker.setPath(7, 501);
+	bool middle = walker.getNormal() == direct[501] && walker.getNormal() == direct[502];
+	std::cout << "Path addressed directly equals the path reached by setPath()" << (direct == later && middle ? " (ok)" : " (FAILED)") << std::endl;
+}
+
+// Sobol points against boost::random::sobol, the stratification that Owen's scramble keeps,
+// and the increments a Brownian bridge builds from independent normals
+void testSobol(const std::vector<double>& mesh)
+{
+	const std::size_t dim = 10, points = 1024;
+	SobolNormal plain(dim), scrambled(dim, true, 5);
+	boost::random::sobol reference(dim);
+	bool same = true;
+	std::vector<std::vector<int> > strata(dim, std::vector<int>(points, 0));
+	for (std::size_t i = 0; i < points; ++i)
+	{
+		plain.setPoint(i + 1);	// boost starts from point 1
+		scrambled.setPoint(i);
+		for (std::size_t d = 0; d < dim; ++d)
+		{
+			same = same && plain.coordinate(d) == (unsigned int)(reference() >> 32);	// boost keeps 64 bits
+			strata[d][scrambled.coordinate(d) >> 22]++;
+		}
+	}
+	bool stratified = true;
+	for (std::size_t d = 0; d < dim; ++d)
+	{
+		stratified = stratified && *std::min_element(strata[d].begin(), strata[d].end()) == 1;
+	}
+	std::cout << "Sobol points equal those of boost::random::sobol" << (same ? " (ok)" : " (FAILED)") << std::endl;
+	std::cout << "Scrambled points: one in each of " << points << " strata of every coordinate" << (stratified ? " (ok)" : " (FAILED)") << std::endl;
+
+	// Normals through the bridge must again be independent standard normals
+	BrownianBridge bridge(mesh);
+	std::size_t n = bridge.size(), samples = 200000;
+	std::vector<double> z(n), out(n), cov(n * n, 0.0);
+	XoshiroNormal normal(3);
+	for (std::size_t k = 0; k < samples; ++k)
+	{
+		normal.getNormals(&z[0], n);
+		bridge.transform(&z[0], &out[0]);
+		for (std::size_t i = 0; i < n; ++i)
+		{
+			for (std::size_t j = 0; j < n; ++j)
+			{
+				cov[i * n + j] += out[i] * out[j] / samples;
+			}
+		}
+	}
+	double worst = 0.0;
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		for (std::size_t j = 0; j < n; ++j)
+		{
+			worst = std::max(worst, fabs(cov[i * n + j] - (i == j ? 1.0 : 0.0)));
+		}
+	}
+	std::cout << "Brownian bridge over " << n << " steps: max covariance error of the increments " << worst
+		<< (worst < 10.0 / sqrt(double(samples)) ? " (ok)" : " (FAILED)") << std::endl;
+}
+
+// Standard errors of plain MC against randomised QMC with and without the Brownian bridge, at
+// equal numbers of paths; 16 replications give each RQMC error estimate
+void testQMC(const MCEngine& engine)
+{
+	const int replications = 16;
+	double mcLast = 0.0, qmcLast = 0.0;
+	std::cout << "Paths\tMC se\t\tRQMC se\t\tRQMC + bridge se\tRQMC + bridge price" << std::endl;
+	for (long NSim = 1024; NSim <= 16384; NSim *= 4)
+	{
+		long total = NSim * replications;
+		MCResult mc = engine.run(total);
+		MCResult qmc = engine.runQMC(NSim, replications, false);
+		MCResult bridged = engine.runQMC(NSim, replications, true);
+		std::cout << total << "\t" << mc.se << "\t" << qmc.se << "\t" << bridged.se << "\t\t" << bridged.price << std::endl;
+		mcLast = mc.se;
+		qmcLast = bridged.se;
+	}
+	std::cout << "RQMC with the bridge beats MC by " << mcLast / qmcLast << "x in standard error"
+		<< (qmcLast < mcLast / 4 ? " (ok)" : " (FAILED)") << std::endl;
+}
+
 int main()
 {
 	std::cout << "1 factor MC with explicit Euler\n";
@@ -91,8 +293,6 @@ int main()
 
 	// Create the basic SDE (Context class)
 	Range<double> range(0.0, myOption.T);
-	double VOld = S_0;
-	double VNew;
 
 	std::vector<double> x = range.mesh(N);
 
@@ -102,67 +302,90 @@ int main()
 	std::cout << "Number of simulations: ";
 	std::cin >> NSim;
 
-	double k = myOption.T / double(N);
-	double sqrk = sqrt(k);
-
-	// Normal random number
-	double dW;
-	double price = 0.0;	// Option price
-
-	// NormalGenerator is a base class
-	NormalGenerator* myNormal = new BoostNormal();
-
 	using namespace SDEDefinition;
 	SDEDefinition::data = &myOption;
 
-	std::vector<double> res;
-	int coun = 0; // Number of times S hits origin
-
-	// A.
-	std::vector<double> prices;
-	for (long i = 1; i <= NSim; ++i)
-	{ // Calculate a path at each iteration
-
-		if ((i / 10000) * 10000 == i)
-		{// Give status after each 1000th iteration
-
-			std::cout << i << std::endl;
-		}
-
-		VOld = S_0;
-		for (unsigned long index = 1; index < x.size(); ++index)
-		{
-
-			// Create a random number
-			dW = myNormal->getNormal();
+	// The paths run in batches on all hardware threads, each batch with its own normal stream
+	MCEngine engine(myOption, S_0, x, drift, diffusion, 20120117);
+	auto start = std::chrono::high_resolution_clock::now();
+	MCResult result = engine.run(NSim);
+	double elapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
 
-			// The FDM (in this case explicit Euler)
-			VNew = VOld + (k * drift(x[index - 1], VOld))
-				+ (sqrk * diffusion(x[index - 1], VOld) * dW);
-
-			VOld = VNew;
-
-			// Spurious values
-			if (VNew <= 0.0) coun++;
-		}
-
-		double tmp = myOption.myPayOffFunction(VNew);
-		price += (tmp) / double(NSim);
-		prices.push_back(tmp);
-	}
-
-	// D. Finally, discounting the average price
-	price *= exp(-myOption.r * myOption.T);
-
-	// Calculate the standard deviation and standard error
-	double sd = computeStandardDeviation(prices, myOption.r, myOption.T);
-	double se = computeStandardError(prices, myOption.r, myOption.T);
+	double price = result.price;
+	double sd = result.sd;
+	double se = result.se;
+	int coun = result.originHits; // Number of times S hits origin
 
 	// Print results
 	std::cout << "Price, after discounting: " << price << std::endl;
 	std::cout << "Number of times origin is hit: " << coun << endl;
 	std::cout << "Standard Deviation: " << sd << std::endl;
 	std::cout << "Standard Error: " << se << std::endl;
+	std::cout << "Time on " << hardwareThreads() << " threads: " << elapsed << " s" << std::endl;
+
+	// The same seed on any number of threads must give the same bits
+	for (unsigned threads : { 1u, 3u })
+	{
+		start = std::chrono::high_resolution_clock::now();
+		MCResult other = engine.run(NSim, threads);
+		double otherElapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+		bool same = other.price == result.price && other.sd == result.sd && other.originHits == result.originHits;
+		std::cout << "Time on " << threads << " threads: " << otherElapsed << " s, same result" << (same ? " (ok)" : " (FAILED)") << std::endl;
+	}
+
+	// Counter-based paths: a run split into two shards gives the full run's price
+	start = std::chrono::high_resolution_clock::now();
+	MCResult paths = engine.runPaths(0, NSim);
+	double pathsElapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	long half = NSim / 2;
+	MCResult shard1 = engine.runPaths(0, half), shard2 = engine.runPaths(half, NSim - half, 3);
+	double combined = (shard1.price * half + shard2.price * (NSim - half)) / NSim;
+	bool sharded = fabs(combined - paths.price) < 1e-12 * fabs(paths.price) && shard1.originHits + shard2.originHits == paths.originHits;
+	std::cout << "Counter-based paths: price " << paths.price << ", standard error " << paths.se << ", time " << pathsElapsed
+		<< " s, two shards give the same price" << (sharded ? " (ok)" : " (FAILED)") << std::endl;
+
+	// Degenerate runs: no paths, a single path, an empty time mesh
+	MCEngine noSteps(myOption, S_0, std::vector<double>(), drift, diffusion, 20120117);
+	MCResult none = engine.run(0), negative = engine.runPaths(0, -5), single = engine.run(1), empty = noSteps.run(NSim), noPoints = engine.runQMC(0, 4);
+	bool degenerate = none.paths == 0 && none.price == 0.0 && negative.paths == 0 && single.paths == 1 && single.sd == 0.0 && single.se == 0.0
+		&& empty.paths == 0 && empty.price == 0.0 && noPoints.paths == 0 && noPoints.price == 0.0;
+	std::cout << "No paths, one path and an empty mesh give finite results" << (degenerate ? " (ok)" : " (FAILED)") << std::endl;
+
+	// Exact Black-Scholes price of the same option, to judge the MC estimate against its standard error
+	double sqrtT = sqrt(myOption.T);
+	double d1 = (log(S_0 / myOption.K) + (myOption.r + 0.5 * myOption.sig * myOption.sig) * myOption.T) / (myOption.sig * sqrtT);
+	double d2 = d1 - myOption.sig * sqrtT;
+	double exact = myOption.type * (S_0 * normalCdf(myOption.type * d1) - myOption.K * exp(-myOption.r * myOption.T) * normalCdf(myOption.type * d2));
+	std::cout << "Exact Black-Scholes price: " << exact << " (MC error in standard errors: " << (price - exact) / se << ")" << std::endl;
+
+	// Block generation of normals against one call per draw
+	std::cout << std::endl;
+	BoostNormal boostOne, boostBlock;
+	benchmarkNormals("BoostNormal", boostOne, boostBlock);
+	XoshiroNormal xoshiroOne(1), xoshiroBlock(1);
+	benchmarkNormals("XoshiroNormal", xoshiroOne, xoshiroBlock);
+	ZigguratNormal zigguratOne(1), zigguratBlock(1);
+	benchmarkNormals("ZigguratNormal", zigguratOne, zigguratBlock);
+	BoxMullerNormal boxMullerOne(1), boxMullerBlock(1);
+	benchmarkNormals("BoxMullerNormal", boxMullerOne, boxMullerBlock);
+
+	// Statistical quality of the vectorised generators, with BoostNormal for reference
+	std::cout << std::endl;
+	testNormalQuality("BoostNormal", BoostNormal());
+	testNormalQuality("ZigguratNormal", ZigguratNormal(2));
+	testNormalQuality("BoxMullerNormal", BoxMullerNormal(2));
+	testNormalQuality("PhiloxNormal", PhiloxNormal(2, 0));
+
+	// Counter-based generator
+	std::cout << std::endl;
+	PhiloxNormal philoxOne(1), philoxBlock(1);
+	benchmarkNormals("PhiloxNormal", philoxOne, philoxBlock);
+	testPhilox();
+
+	// Quasi-random paths
+	std::cout << std::endl;
+	testSobol(Range<double>(0.0, myOption.T).mesh(8));
+	testQMC(engine);
 
 	return 0;
 }
\ No newline at end of file
@@ -23,6 +23,8 @@
 #include <boost/random/mersenne_twister.hpp>
 #include <boost/random/normal_distribution.hpp>
 #include <boost/random/variate_generator.hpp>
+#include <cstddef>
+#include <vector>
 
 class NormalGenerator
 {
@@ -31,6 +33,10 @@ public:
 
 	// Empty at the moment
 	virtual double getNormal() const = 0;
+
+	// Fill out[0..n-1] with normals, the same sequence as n calls of getNormal().
+	// One virtual call per block; the default calls getNormal() n times
+	virtual void getNormals(double* out, std::size_t n) const;
 };
 
 
@@ -49,9 +55,184 @@ public:
 
 	// Implement (variant) hook function
 	double getNormal() const;
+	void getNormals(double* out, std::size_t n) const;
 
 	~BoostNormal();
 };
 
 
+class XoshiroNormal : public NormalGenerator
+{ // Seeded generator: xoshiro256** uniforms, Marsaglia's polar method for the normals
+
+private:
+
+	mutable unsigned long long s[4];	// state of the uniform generator
+	mutable double spare;				// second normal of the last polar pair
+	mutable bool hasSpare;
+
+	unsigned long long nextUniform() const;
+	void polarPair(double& first, double& second) const;
+
+public:
+	XoshiroNormal(unsigned long long seed = 0);
+	XoshiroNormal(const XoshiroNormal& source);
+	XoshiroNormal& operator = (const XoshiroNormal& source);
+
+	// Implement (variant) hook function
+	double getNormal() const;
+	void getNormals(double* out, std::size_t n) const;
+
+	// Advance the uniform stream by 2^128 draws. Streams that are 1, 2, 3, ... jumps
+	// apart from the same seed never overlap, so each can feed its own batch of paths
+	void jump();
+};
+
+
+class XoshiroBlock
+{ // Strategy for uniforms: Lanes xoshiro256** streams, each one jump beyond the last, stepped
+  // together in loops the compiler can vectorise
+
+public:
+	static const std::size_t Lanes = 8;
+
+private:
+
+	unsigned long long s0[Lanes], s1[Lanes], s2[Lanes], s3[Lanes];	// state word k of lane l is sk[l]
+
+public:
+	XoshiroBlock(unsigned long long seed = 0);
+
+	// Fill out[0..n-1] with 64 bit uniforms, n a multiple of Lanes; out[j] comes from lane j % Lanes
+	void fill(unsigned long long* out, std::size_t n);
+
+	// Advance every lane by Lanes jumps, so that successive jumps give disjoint sets of streams
+	void jump();
+};
+
+
+class BlockNormal : public NormalGenerator
+{ // Template Method: a derived class makes Block normals at a time, getNormal()
+  // serves them one by one from a buffer and getNormals() writes whole blocks in place
+
+public:
+	static const std::size_t Block = 256;
+
+private:
+
+	mutable double buffer[Block];
+	mutable std::size_t used;	// buffer[used..Block-1] are still to be served
+
+protected:
+
+	// Hook: the next Block normals
+	virtual void generate(double* out) const = 0;
+
+public:
+	BlockNormal();
+
+	double getNormal() const;
+	void getNormals(double* out, std::size_t n) const;
+};
+
+
+class ZigguratNormal : public BlockNormal
+{ // Ziggurat of Marsaglia and Tsang with 256 layers, in Doornik's symmetric form. A
+  // vectorised pass accepts the draws that fall inside the rectangles, about 99% of
+  // them; the rest go through the wedge and tail tests one by one
+
+private:
+
+	mutable XoshiroBlock uniforms;
+	mutable unsigned long long fallback[4];	// xoshiro256** state for the wedge and tail draws
+	double x[257];							// layer edges, x[1] = R down to x[256] = 0
+	double ratio[256];						// x[i + 1] / x[i]
+
+	double slow(unsigned long long r) const;
+
+protected:
+	void generate(double* out) const;
+
+public:
+	ZigguratNormal(unsigned long long seed = 0);
+};
+
+
+class BoxMullerNormal : public BlockNormal
+{ // Box-Muller transform without branches: every pair of uniforms gives a pair of normals.
+  // The log and the sine/cosine are the polynomial ones of BatchMath.hpp, so the block
+  // loop vectorises (with -fno-math-errno for the square root under GCC)
+
+private:
+
+	mutable XoshiroBlock uniforms;
+
+protected:
+	void generate(double* out) const;
+
+public:
+	BoxMullerNormal(unsigned long long seed = 0);
+};
+
+
+class PhiloxNormal : public NormalGenerator
+{ // Counter-based generator: Philox4x32-10 (Salmon et al., Random123) keyed by the seed.
+  // Normals 2m and 2m + 1 of a path come from Box-Muller on the block of counter
+  // (m, path), so each normal is a function of (seed, path, draw) alone and a path
+  // can be drawn apart from the others, in any order and on any machine
+
+private:
+
+	unsigned int key[2];
+	unsigned long long path;
+	mutable unsigned long long draw;	// index in the path of the next normal
+	mutable double pair[2];				// normals of pair draw / 2, once computed
+	mutable bool hasPair;
+
+public:
+	PhiloxNormal(unsigned long long seed = 0, unsigned long long pathIndex = 0);
+
+	// Implement (variant) hook function
+	double getNormal() const;
+	void getNormals(double* out, std::size_t n) const;
+
+	// Move to normal drawIndex of another path
+	void setPath(unsigned long long pathIndex, unsigned long long drawIndex = 0);
+
+	// The raw generator: the 4 words of counter ctr under key k
+	static void philox(const unsigned int ctr[4], const unsigned int k[2], unsigned int out[4]);
+};
+
+
+class SobolNormal : public NormalGenerator
+{ // Quasi-random normals: the points of a Sobol sequence in dimension coordinates, with the
+  // direction numbers of Joe and Kuo (new-joe-kuo-6.21201, as tabled by boost::random, up to
+  // 3667 coordinates), through the inverse normal cdf. getNormal() walks the coordinates of
+  // point 0, then those of point 1, ... Scrambled, every coordinate goes through Owen's nested
+  // uniform scramble, in the hash-based form of Laine, Karras and Burley, keyed by the seed and
+  // the coordinate; different seeds give independent randomised QMC replications. Unscrambled,
+  // point 0 is the corner of the cube and is best skipped with setPoint(1)
+
+private:
+
+	std::size_t dimension;
+	std::vector<unsigned int> direction;		// direction number j of coordinate d is direction[j * dimension + d]
+	std::vector<unsigned int> scramble;			// key of coordinate d, empty when not scrambled
+	mutable std::vector<unsigned int> point;	// current point, unscrambled, as 32 bit fractions
+	mutable unsigned long long index;			// index of the current point
+	mutable std::size_t next;					// next coordinate of the current point
+
+public:
+	SobolNormal(std::size_t dim, bool scrambled = false, unsigned long long seed = 0);
+
+	// Implement (variant) hook function
+	double getNormal() const;
+
+	// Move to coordinate 0 of point pointIndex (Gray code, no need to walk the points before it)
+	void setPoint(unsigned long long pointIndex);
+
+	// Coordinate d of the current point as a 32 bit fraction, scrambled if the generator is
+	unsigned int coordinate(std::size_t d) const;
+};
+
+
 #endif